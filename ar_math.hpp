@@ -0,0 +1,219 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Fixed-size math for the per-frame pose path
+// Plain aggregates with inline storage: no heap allocation and no element type dispatch, unlike
+// cv::Mat. OpenCV types only appear in the fromCv / toCv conversions at the boundary.
+namespace ar
+{
+    struct Vec3
+    {
+        double x = 0.0, y = 0.0, z = 0.0;
+
+        constexpr double operator[](int i) const { return i == 0 ? x : i == 1 ? y : z; }
+        constexpr Vec3 operator+(const Vec3 &o) const { return {x + o.x, y + o.y, z + o.z}; }
+        constexpr Vec3 operator-(const Vec3 &o) const { return {x - o.x, y - o.y, z - o.z}; }
+        constexpr Vec3 operator-() const { return {-x, -y, -z}; }
+        constexpr Vec3 operator*(double s) const { return {x * s, y * s, z * s}; }
+        constexpr Vec3 &operator+=(const Vec3 &o)
+        {
+            x += o.x;
+            y += o.y;
+            z += o.z;
+            return *this;
+        }
+        constexpr double dot(const Vec3 &o) const { return x * o.x + y * o.y + z * o.z; }
+        constexpr Vec3 cross(const Vec3 &o) const { return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x}; }
+        double norm() const { return std::sqrt(dot(*this)); }
+
+        // Empty or non-3-element matrices give a zero vector
+        static Vec3 fromCv(const cv::Mat &m)
+        {
+            if (m.total() != 3)
+                return {};
+            if (m.depth() == CV_32F)
+                return {m.at<float>(0), m.at<float>(1), m.at<float>(2)};
+            return {m.at<double>(0), m.at<double>(1), m.at<double>(2)};
+        }
+        cv::Vec3d toCv() const { return {x, y, z}; }
+    };
+
+    constexpr Vec3 operator*(double s, const Vec3 &v) { return v * s; }
+
+    // Row-major 3x3
+    struct alignas(16) Mat3
+    {
+        double m[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+        constexpr double operator()(int r, int c) const { return m[r * 3 + c]; }
+        constexpr double &operator()(int r, int c) { return m[r * 3 + c]; }
+
+        static constexpr Mat3 identity() { return {}; }
+
+        constexpr Mat3 operator*(const Mat3 &o) const
+        {
+            Mat3 r;
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    r.m[i * 3 + j] = m[i * 3] * o.m[j] + m[i * 3 + 1] * o.m[3 + j] + m[i * 3 + 2] * o.m[6 + j];
+            return r;
+        }
+        constexpr Vec3 operator*(const Vec3 &v) const
+        {
+            return {m[0] * v.x + m[1] * v.y + m[2] * v.z,
+                    m[3] * v.x + m[4] * v.y + m[5] * v.z,
+                    m[6] * v.x + m[7] * v.y + m[8] * v.z};
+        }
+        constexpr Mat3 &operator+=(const Mat3 &o)
+        {
+            for (int i = 0; i < 9; ++i)
+                m[i] += o.m[i];
+            return *this;
+        }
+        constexpr Mat3 transposed() const
+        {
+            return {{m[0], m[3], m[6], m[1], m[4], m[7], m[2], m[5], m[8]}};
+        }
+        constexpr double trace() const { return m[0] + m[4] + m[8]; }
+
+        // Rotation matrix of a rotation vector (Rodrigues)
+        static Mat3 fromRotationVector(const Vec3 &r)
+        {
+            const double angle = r.norm();
+            if (angle < 1e-12)
+                return {{1, -r.z, r.y, r.z, 1, -r.x, -r.y, r.x, 1}};
+            const Vec3 k = r * (1.0 / angle);
+            const double c = std::cos(angle), s = std::sin(angle), v = 1.0 - c;
+            return {{c + k.x * k.x * v, k.x * k.y * v - k.z * s, k.x * k.z * v + k.y * s,
+                     k.y * k.x * v + k.z * s, c + k.y * k.y * v, k.y * k.z * v - k.x * s,
+                     k.z * k.x * v - k.y * s, k.z * k.y * v + k.x * s, c + k.z * k.z * v}};
+        }
+
+        static Mat3 fromCv(const cv::Matx33d &R)
+        {
+            Mat3 r;
+            std::copy(R.val, R.val + 9, r.m);
+            return r;
+        }
+        cv::Matx33d toCv() const { return cv::Matx33d(m); }
+    };
+
+    // Geodesic angle between two rotations in radians
+    inline double rotationAngle(const Mat3 &a, const Mat3 &b)
+    {
+        const double c = ((a.transposed() * b).trace() - 1.0) / 2.0;
+        return std::acos(std::max(-1.0, std::min(1.0, c)));
+    }
+
+    // Unit quaternion (w, x, y, z)
+    struct Quat
+    {
+        double w = 1.0, x = 0.0, y = 0.0, z = 0.0;
+
+        constexpr Quat operator*(const Quat &b) const
+        {
+            return {w * b.w - x * b.x - y * b.y - z * b.z,
+                    w * b.x + x * b.w + y * b.z - z * b.y,
+                    w * b.y - x * b.z + y * b.w + z * b.x,
+                    w * b.z + x * b.y - y * b.x + z * b.w};
+        }
+        constexpr Quat conjugate() const { return {w, -x, -y, -z}; }
+        Quat normalized() const
+        {
+            const double n = std::sqrt(w * w + x * x + y * y + z * z);
+            return {w / n, x / n, y / n, z / n};
+        }
+
+        static Quat fromRotationVector(const Vec3 &r)
+        {
+            const double angle = r.norm();
+            if (angle < 1e-12)
+                return {1.0, 0.5 * r.x, 0.5 * r.y, 0.5 * r.z};
+            const double s = std::sin(0.5 * angle) / angle;
+            return {std::cos(0.5 * angle), s * r.x, s * r.y, s * r.z};
+        }
+
+        // Shortest rotation: w >= 0
+        Vec3 toRotationVector() const
+        {
+            const double sign = w < 0.0 ? -1.0 : 1.0;
+            const Vec3 v{sign * x, sign * y, sign * z};
+            const double sinHalf = v.norm();
+            if (sinHalf < 1e-12)
+                return 2.0 * v;
+            return v * (2.0 * std::atan2(sinHalf, sign * w) / sinHalf);
+        }
+    };
+
+    // Column-major 4x4 in OpenGL layout, data() goes straight to glUniformMatrix4fv
+    struct alignas(32) Mat4
+    {
+        float m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+        constexpr float operator()(int r, int c) const { return m[c * 4 + r]; }
+        constexpr float &operator()(int r, int c) { return m[c * 4 + r]; }
+        constexpr const float *data() const { return m; }
+
+        static constexpr Mat4 identity() { return {}; }
+
+        static Mat4 fromColumnMajor(const float *values)
+        {
+            Mat4 r;
+            std::copy(values, values + 16, r.m);
+            return r;
+        }
+
+        // Column by column, so the inner loop runs over contiguous floats
+        constexpr Mat4 operator*(const Mat4 &o) const
+        {
+            Mat4 r;
+            for (int j = 0; j < 4; ++j)
+            {
+                for (int i = 0; i < 4; ++i)
+                    r.m[j * 4 + i] = 0.0f;
+                for (int k = 0; k < 4; ++k)
+                {
+                    const float b = o.m[j * 4 + k];
+                    for (int i = 0; i < 4; ++i)
+                        r.m[j * 4 + i] += m[k * 4 + i] * b;
+                }
+            }
+            return r;
+        }
+    };
+
+    // Rigid pose in OpenCV camera coordinates (x right, y down, z forward)
+    struct Pose
+    {
+        Vec3 rvec; // Rotation vector
+        Vec3 tvec; // Translation
+
+        Mat3 rotation() const { return Mat3::fromRotationVector(rvec); }
+
+        // OpenGL modelview: the OpenCV pose with the y and z axes flipped
+        Mat4 modelView() const
+        {
+            const Mat3 R = rotation();
+            Mat4 mv;
+            for (int c = 0; c < 3; ++c)
+            {
+                mv(0, c) = static_cast<float>(R(0, c));
+                mv(1, c) = static_cast<float>(-R(1, c));
+                mv(2, c) = static_cast<float>(-R(2, c));
+            }
+            mv(0, 3) = static_cast<float>(tvec.x);
+            mv(1, 3) = static_cast<float>(-tvec.y);
+            mv(2, 3) = static_cast<float>(-tvec.z);
+            return mv;
+        }
+
+        static Pose fromCv(const cv::Mat &rvec, const cv::Mat &tvec) { return {Vec3::fromCv(rvec), Vec3::fromCv(tvec)}; }
+        void toCv(cv::Mat &rvecOut, cv::Mat &tvecOut) const
+        {
+            rvecOut = cv::Mat(rvec.toCv(), true);
+            tvecOut = cv::Mat(tvec.toCv(), true);
+        }
+    };
+} // namespace ar
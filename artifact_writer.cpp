@@ -0,0 +1,156 @@
+#include "artifact_writer.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+// Temporary file, fsync, rename
+static bool writeBytesDurable(const std::filesystem::path &path, const char *data, size_t size)
+{
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Unable to open " << tmp << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    size_t left = size;
+    bool ok = true;
+    while (left > 0)
+    {
+        const ssize_t n = ::write(fd, data, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            ok = false;
+            break;
+        }
+        data += n;
+        left -= static_cast<size_t>(n);
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Unable to write " << path << ": " << std::strerror(errno) << std::endl;
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writeFileDurable(const std::filesystem::path &path, const std::string &contents)
+{
+    return writeBytesDurable(path, contents.data(), contents.size());
+}
+
+ArtifactWriter::ArtifactWriter(size_t capacity) : capacity(std::max<size_t>(1, capacity))
+{
+    worker = std::thread(&ArtifactWriter::run, this);
+}
+
+ArtifactWriter::~ArtifactWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    worker.join();
+}
+
+void ArtifactWriter::writeImage(const std::filesystem::path &path, cv::Mat image, std::vector<int> params)
+{
+    Job job;
+    job.path = path;
+    job.image = std::move(image);
+    job.params = std::move(params);
+    enqueue(std::move(job));
+}
+
+void ArtifactWriter::writeFile(const std::filesystem::path &path, std::string contents)
+{
+    Job job;
+    job.path = path;
+    job.contents = std::move(contents);
+    enqueue(std::move(job));
+}
+
+void ArtifactWriter::enqueue(Job job)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // Backpressure: a slow disk holds the capture loop here instead of growing the queue without bound
+    changed.wait(lock, [this]
+                 { return jobs.size() < capacity; });
+    jobs.push_back(std::move(job));
+    lock.unlock();
+    notEmpty.notify_one();
+}
+
+bool ArtifactWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]
+                 { return jobs.empty() && writing == 0; });
+    return !std::exchange(failed, false);
+}
+
+size_t ArtifactWriter::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size() + writing;
+}
+
+void ArtifactWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        // Drain the queue before stopping
+        notEmpty.wait(lock, [this]
+                      { return !jobs.empty() || stopping; });
+        if (jobs.empty())
+            return;
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        writing++;
+        lock.unlock();
+        changed.notify_all(); // Space for a producer
+
+        bool ok = true;
+        std::error_code error;
+        std::filesystem::create_directories(job.path.parent_path(), error);
+        // An exception (unknown extension, bad image, out of memory) would end the worker and the
+        // process with it: it fails this job like any other error
+        try
+        {
+            if (!job.image.empty())
+            {
+                std::vector<uchar> encoded;
+                ok = cv::imencode(job.path.extension().string(), job.image, encoded, job.params);
+                if (ok)
+                    ok = writeBytesDurable(job.path, reinterpret_cast<const char *>(encoded.data()), encoded.size());
+                else
+                    std::cerr << "Unable to encode " << job.path << std::endl;
+            }
+            else
+                ok = writeFileDurable(job.path, job.contents);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Unable to write " << job.path << ": " << e.what() << std::endl;
+            ok = false;
+        }
+        job = Job(); // Release the frame before waiting again
+
+        lock.lock();
+        writing--;
+        failed = failed || !ok;
+        changed.notify_all(); // flush() may be waiting for the last job
+    }
+}
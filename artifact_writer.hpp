@@ -0,0 +1,61 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Write contents to path durably: a temporary file next to it is fsync'ed and renamed over the
+// target, so readers see either the old file or the complete new one
+bool writeFileDurable(const std::filesystem::path &path, const std::string &contents);
+
+// Background writer for capture artifacts (calibration images, the NFT reference). Image encoding,
+// the write and the fsync run on one worker thread, so the capture loop only pays for a queue push.
+// Jobs are written in the order they were queued.
+class ArtifactWriter
+{
+public:
+    // capacity bounds the queued jobs (and the frames they hold); enqueueing blocks while it is full
+    explicit ArtifactWriter(size_t capacity = 8);
+    // Writes everything still queued
+    ~ArtifactWriter();
+
+    ArtifactWriter(const ArtifactWriter &) = delete;
+    ArtifactWriter &operator=(const ArtifactWriter &) = delete;
+
+    // Queue an image; the format follows the extension as with cv::imwrite. Pass the frame by move
+    // (or a Mat nobody writes to any more): the worker encodes it later.
+    void writeImage(const std::filesystem::path &path, cv::Mat image, std::vector<int> params = {});
+    // Queue a file with the given contents
+    void writeFile(const std::filesystem::path &path, std::string contents);
+
+    // Block until every queued job is on disk. False if any write failed since the last flush.
+    bool flush();
+    // Jobs queued or being written
+    size_t pending() const;
+
+private:
+    struct Job
+    {
+        std::filesystem::path path;
+        cv::Mat image;           // Encoded by the worker when not empty
+        std::vector<int> params; // cv::imencode parameters
+        std::string contents;    // Written as is otherwise
+    };
+
+    void enqueue(Job job);
+    void run();
+
+    const size_t capacity;
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty; // Worker waits for jobs
+    std::condition_variable changed;  // Producers wait for space, flush waits for idle
+    std::deque<Job> jobs;
+    size_t writing = 0;    // Jobs taken by the worker, not finished yet
+    bool failed = false;   // A write failed since the last flush
+    bool stopping = false;
+    std::thread worker;
+};
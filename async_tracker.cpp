@@ -0,0 +1,97 @@
+#include "async_tracker.hpp"
+#include <chrono>
+
+AsyncTracker::AsyncTracker(std::unique_ptr<PoseTracker> tracker, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs)
+    : tracker(std::move(tracker)), cameraMatrix(cameraMatrix.clone()), distCoeffs(distCoeffs.clone()),
+      zeroDist(cv::Mat::zeros(4, 1, CV_64F))
+{
+    this->tracker->showDebug = false; // HighGUI windows only work on the main thread
+    worker = std::thread(&AsyncTracker::run, this);
+}
+
+AsyncTracker::~AsyncTracker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AsyncTracker::submit(const cv::Mat &frame, int frameId, double timestamp, bool undistorted)
+{
+    PreparedFrame prepared;
+    prepared.color = frame;
+    submit(prepared, frameId, timestamp, undistorted);
+}
+
+void AsyncTracker::submit(const PreparedFrame &frame, int frameId, double timestamp, bool undistorted)
+{
+    // Copy outside the lock
+    PreparedFrame copy;
+    copy.color = frame.color.clone();
+    copy.gray = frame.gray.clone();
+    copy.grayHalf = frame.grayHalf.clone();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (hasPending)
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        pendingFrame = std::move(copy);
+        pendingId = frameId;
+        pendingTimestamp = timestamp;
+        pendingUndistorted = undistorted;
+        hasPending = true;
+    }
+    wake.notify_one();
+}
+
+void AsyncTracker::setQuality(const TrackerQuality &quality)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingQuality = quality;
+    hasQuality = true;
+}
+
+void AsyncTracker::run()
+{
+    std::uint64_t sequence = 0;
+    cv::Mat rvec, tvec; // Kept across frames like in the synchronous loop
+    for (;;)
+    {
+        PreparedFrame frame;
+        TrackedPose pose;
+        bool undistorted = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]
+                      { return hasPending || stopping; });
+            if (stopping)
+                return;
+            frame = std::move(pendingFrame);
+            pose.frameId = pendingId;
+            pose.timestamp = pendingTimestamp;
+            undistorted = pendingUndistorted;
+            hasPending = false;
+            if (hasQuality)
+            {
+                tracker->quality = pendingQuality;
+                hasQuality = false;
+            }
+        }
+
+        tracker->lastDiagnostics = PoseDiagnostics();
+        auto start = std::chrono::high_resolution_clock::now();
+        // Frames submitted without grayscale go through the tracker's own conversion
+        const cv::Mat &dist = undistorted ? zeroDist : distCoeffs;
+        pose.success = frame.gray.empty() ? tracker->estimatePose(frame.color, cameraMatrix, dist, rvec, tvec)
+                                          : tracker->estimatePose(frame, cameraMatrix, dist, rvec, tvec);
+        pose.trackMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        pose.sequence = ++sequence;
+        pose.rvec = rvec.clone();
+        pose.tvec = tvec.clone();
+        pose.diagnostics = tracker->lastDiagnostics;
+        results.publish(std::move(pose));
+    }
+}
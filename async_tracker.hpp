@@ -0,0 +1,73 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "latest_value.hpp"
+#include "tracker.hpp"
+
+// Pose estimate of one frame, published by AsyncTracker
+struct TrackedPose
+{
+    std::uint64_t sequence = 0;  // Increments with every published result
+    int frameId = -1;            // Frame the pose was estimated on
+    double timestamp = 0.0;      // Capture time of that frame in seconds
+    bool success = false;        // Pose found
+    cv::Mat rvec, tvec;          // Rotation and translation vectors
+    PoseDiagnostics diagnostics; // Solver details of the estimate
+    double trackMs = 0.0;        // Time spent in estimatePose
+};
+
+// Runs a tracker on its own thread so rendering never waits for pose estimation.
+// The renderer submits every frame; the worker always picks the newest one (frames that arrive
+// while it is busy replace each other) and publishes results through a lock-free latest-value slot.
+class AsyncTracker
+{
+public:
+    // distCoeffs: distortion of frames as captured; frames submitted as undistorted are solved without
+    AsyncTracker(std::unique_ptr<PoseTracker> tracker, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs);
+    ~AsyncTracker();
+
+    AsyncTracker(const AsyncTracker &) = delete;
+    AsyncTracker &operator=(const AsyncTracker &) = delete;
+
+    // Hand over a frame (copied); replaces a frame the worker has not started on yet
+    void submit(const cv::Mat &frame, int frameId, double timestamp, bool undistorted = false);
+    // Same for a preprocessed frame (color and grayscale levels are copied, the upload buffer is not)
+    void submit(const PreparedFrame &frame, int frameId, double timestamp, bool undistorted = false);
+
+    // Quality settings for the frames the worker picks up from now on
+    void setQuality(const TrackerQuality &quality);
+
+    // Newest result, if one was published since the last call (render thread only)
+    bool poll(TrackedPose &pose) { return results.consume(pose); }
+
+    // Frames replaced before the worker picked them up
+    int droppedFrames() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    std::unique_ptr<PoseTracker> tracker; // Only touched by the worker
+    cv::Mat cameraMatrix, distCoeffs;
+    cv::Mat zeroDist; // For undistorted frames
+
+    // Frame mailbox
+    std::mutex mutex;
+    std::condition_variable wake;
+    PreparedFrame pendingFrame;
+    int pendingId = -1;
+    double pendingTimestamp = 0.0;
+    bool pendingUndistorted = false;
+    bool hasPending = false;
+    TrackerQuality pendingQuality;
+    bool hasQuality = false;
+    bool stopping = false;
+    std::atomic<int> dropped{0};
+
+    LatestValue<TrackedPose> results; // Worker -> renderer
+    std::thread worker;
+};
@@ -1,82 +1,86 @@
 #include "augmentor.hpp"
 #include "openGLrenderer.hpp"
-#include "jsonHelper.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
-#include "tracker.hpp"
-#include "chessboard_tracker.hpp"
-#include "nft_tracker.hpp"
+#include "async_tracker.hpp"
+#include "tracker_factory.hpp"
 #include "statistics.hpp"
 #include <fstream>
 
 // Initialize augmentor by loading camera calibration data
-void initAugmentor(cv::Mat &cameraMatrix, cv::Mat &distCoeffs, cv::Size patternSize)
+bool initAugmentor(CalibrationStore &calibration, cv::Size patternSize)
 {
     // Build file path based on pattern size
     std::string patternStr = std::to_string(patternSize.width) + "x" + std::to_string(patternSize.height);
     // Load calibration data
     std::filesystem::path calibrationJson = std::filesystem::path("data/calibration") / patternStr / "calibration.json";
-    // Load calibration data from JSON file
-    if (!ar::loadCalibrationData(calibrationJson, cameraMatrix, distCoeffs))
+    // Load calibration data (binary sidecar when calibration.json is unchanged)
+    if (!calibration.load(calibrationJson))
     {
         std::cerr << "Unable to read " << calibrationJson << std::endl;
+        return false;
     }
+    return true;
 }
 
-// Main augmentation loop - captures video, estimates pose, and renders AR content
-void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize, float squareSize, const std::string &experimentName, const std::string &testName)
+void initAugmentor(cv::Mat &cameraMatrix, cv::Mat &distCoeffs, cv::Size patternSize)
 {
-    // create pose tracker
-    std::unique_ptr<PoseTracker> tracker;
-
-    // initialize tracker
-    if (useNft)
+    CalibrationStore calibration;
+    if (initAugmentor(calibration, patternSize))
     {
-        // NFT Tracker
-        auto nft = std::make_unique<NFTTracker>("data/reference/reference.png");
-        // Initialize NFT tracker
-        nft->init();
-        // assign to base pointer
-        tracker = std::move(nft);
+        cameraMatrix = calibration.cameraMatrix;
+        distCoeffs = calibration.distCoeffs;
     }
-    else
+}
+
+// Main augmentation loop - captures video, estimates pose, and renders AR content
+void augmentLoop(bool &useNft, cv::Size patternSize, float squareSize, const std::string &experimentName, const std::string &testName,
+                 const AugmentOptions &options)
+{
+    // create and initialize pose tracker (NFT or chessboard)
+    std::unique_ptr<PoseTracker> tracker = createTracker(useNft, patternSize, squareSize);
+    tracker->solver = options.solver;
+    if (auto *nft = dynamic_cast<NFTTracker *>(tracker.get()))
     {
-        // Chessboard Tracker
-        auto chess = std::make_unique<ChessboardTracker>(patternSize, squareSize);
-        // Initialize Chessboard tracker
-        chess->init();
-        // assign to base pointer
-        tracker = std::move(chess);
+        nft->gridFeatures = options.gridFeatures;
+        nft->multiView = options.multiView;
     }
+    else if (auto *chessboard = dynamic_cast<ChessboardTracker *>(tracker.get()))
+        chessboard->chessCorners = options.chessCorners;
 
     // load calibration data
-    cv::Mat cameraMatrix, distCoeffs;
+    CalibrationStore calibration;
     // initialize augmentor (load calibration)
-    initAugmentor(cameraMatrix, distCoeffs, patternSize);
-
-    // Let's print it for debugging
-    std::cout << "Camera Matrix: " << cameraMatrix << std::endl;
-    std::cout << "Distortion Coefficients: " << distCoeffs << std::endl;
-
-    if (cameraMatrix.empty() || distCoeffs.empty())
+    if (!initAugmentor(calibration, patternSize))
     {
         std::cerr << "Failed to load calibration data." << std::endl;
         return;
     }
-    // start video capture
-    cv::VideoCapture cap(0);
-    if (!cap.isOpened())
+    const cv::Mat &distCoeffs = calibration.distCoeffs;
+    // start video capture (frame ring or raw file input when given)
+    FrameSource source;
+    bool opened = false;
+    if (!options.frameRing.empty())
+        opened = source.openRing(options.frameRing);
+    else if (!options.rawInput.empty())
+        opened = source.openRaw(options.rawInput, options.rawSize, options.captureFormat);
+    else
+        opened = source.open(0, options.captureFormat);
+    if (!opened)
     {
         std::cerr << "Error: Could not open camera." << std::endl;
         return;
     }
+    // YUV frames are tracked on their distorted luma plane and undistorted only for display
+    const bool yuvCapture = source.format() != CaptureFormat::BGR;
     // Get frame dimensions
-    int frame_width = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
-    int frame_height = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
-    std::cout << "Camera capture size: " << frame_width << "x" << frame_height << std::endl;
+    int frame_width = source.size().width;
+    int frame_height = source.size().height;
+    std::cout << "Camera capture size: " << frame_width << "x" << frame_height << (yuvCapture ? " (YUV)" : "") << std::endl;
 
     // Fail-safe debugging for frame_width and frame_height
     if (frame_width <= 0 || frame_height <= 0)
@@ -84,6 +88,14 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
         std::cerr << "Warning: Invalid frame dimensions." << std::endl;
     }
 
+    // Intrinsics rescaled to the capture size, with their projection matrix and undistortion maps
+    const ResolutionIntrinsics &intrinsics = calibration.at(cv::Size(frame_width, frame_height));
+    const cv::Mat cameraMatrix = intrinsics.cameraMatrix;
+
+    // Let's print it for debugging
+    std::cout << "Camera Matrix: " << cameraMatrix << std::endl;
+    std::cout << "Distortion Coefficients: " << distCoeffs << std::endl;
+
     // initialize OpenGL window
     if (!glfwInit())
         return;
@@ -110,15 +122,55 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
     // create renderer
     Renderer renderer(frame_width, frame_height);
 
-    // calculate projection matrix
-    GLfloat projectionMatrix[16];
-    // build projection matrix from camera intrinsics
-    renderer.buildProjectionMatrix(cameraMatrix, frame_width, frame_height, projectionMatrix);
+    // projection matrix from camera intrinsics (precomputed by the calibration store)
+    const GLfloat *projectionMatrix = intrinsics.projection;
+    if (yuvCapture)
+    {
+        // The background shader undistorts with the same maps cv::remap uses
+        cv::Mat undistortMap;
+        cv::convertMaps(intrinsics.map1, intrinsics.map2, undistortMap, cv::noArray(), CV_32FC2);
+        renderer.setUndistortMap(undistortMap);
+    }
+    // Distortion the trackers see, chosen per frame: none on undistorted BGR frames, the real one on raw
+    // luma (a backend may deliver BGR despite the YUV request, so source.format() does not decide it)
+    const cv::Mat zeroDist = cv::Mat::zeros(4, 1, CV_64F);
 
-    // Frame variable
+    // Frame variable (the debug view drawn on; never a capture or ring view)
     cv::Mat frame;
+    cv::Mat debugView; // Colour debug view of luma frames
+    CapturedFrame captured;
+    // Gray, half-resolution and texture upload buffers, computed once per frame for every consumer
+    PreprocessOptions preprocessOptions;
+    preprocessOptions.halfResolution = options.halfResDetection;
+    FramePreprocessor preprocessor(preprocessOptions);
+    PreparedFrame prepared;
+    // Quality governor: cheaper tracker settings while frames run over the budget
+    std::unique_ptr<QualityGovernor> governor;
+    if (options.frameBudgetMs > 0.0)
+    {
+        QualityGovernorOptions governorOptions = options.governor;
+        governorOptions.budgetMs = options.frameBudgetMs;
+        governor = std::make_unique<QualityGovernor>(governorOptions);
+    }
+    // Motion gate: static scenes keep the previous pose instead of running the tracker
+    std::unique_ptr<MotionGate> motionGate;
+    if (options.motionGate && !options.asyncTracking)
+        motionGate = std::make_unique<MotionGate>(options.gate);
     // Pose variables
-    cv::Mat rvec, tvec, rotationMatrix;
+    cv::Mat rvec, tvec;
+    // Rendered pose (filtered and predicted to display time, or the raw pose)
+    ar::Pose drawPose;
+    PoseFilter poseFilter(options.filter);
+    const int trackEveryN = std::max(1, options.trackEveryN);
+    // Smoothed capture-to-display latency in seconds
+    double displayLatency = 0.0;
+
+    // Asynchronous tracking: the worker owns the tracker, the loop renders every camera frame
+    std::unique_ptr<AsyncTracker> asyncTracker;
+    if (options.asyncTracking)
+        asyncTracker = std::make_unique<AsyncTracker>(std::move(tracker), cameraMatrix, distCoeffs);
+    // Last two successful results, interpolated when the filter is off
+    TrackedPose lastPose, previousPose;
 
     // Statistical collection
     int frameCount = 0;
@@ -128,6 +180,9 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
     const int framesPerSet = 800;
     // Session statistics
     SessionStats stats;
+    if (governor)
+        stats.frameBudgetMs = governor->options.budgetMs;
+    stats.motionGate = motionGate != nullptr;
     // Start time for timestamps
     auto t_start = std::chrono::high_resolution_clock::now();
 
@@ -136,20 +191,42 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
         // Start frame timer
         auto frameStart = std::chrono::high_resolution_clock::now();
         // capture frame
-        cap >> frame;
-        if (frame.empty())
+        if (!source.read(captured))
         {
             std::cerr << "Error: Could not read frame." << std::endl;
             break;
         }
-        // 1. Undistort frame
-        cv::Mat undistortedFrame;
-        cv::undistort(frame, undistortedFrame, cameraMatrix, distCoeffs);
-        frame = undistortedFrame;
+        const double captureTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+        const bool undistorted = captured.format == CaptureFormat::BGR;
+        const cv::Mat &trackingDist = undistorted ? zeroDist : distCoeffs;
+        if (undistorted)
+        {
+            // 1. Undistort frame (cached maps instead of rebuilding them in cv::undistort every frame)
+            cv::Mat undistortedFrame;
+            cv::remap(captured.bgr, undistortedFrame, intrinsics.map1, intrinsics.map2, cv::INTER_LINEAR);
+            frame = undistortedFrame;
+            preprocessor.process(frame, prepared);
+        }
+        else
+        {
+            // 1. Luma plane straight to the trackers, no colour conversion and no undistortion
+            preprocessor.processGray(captured.luma(), prepared);
+            // Debug view in its own buffer: the luma is a view into the capture or a read-only ring slot
+            cv::cvtColor(prepared.gray, debugView, cv::COLOR_GRAY2BGR);
+            frame = debugView;
+        }
+        // Ring frames are read in place: drop one the producer overwrote while it was being copied,
+        // still processing window events so a consumer that keeps falling behind does not freeze
+        if (!source.isCurrent())
+        {
+            glfwPollEvents();
+            if (cv::waitKey(1) == 27)
+                break;
+            continue;
+        }
 
-        // 2. Create a "Zero" distortion vector for tracking
-        // Since the frame is now undistorted, we treat it as a perfect pinhole camera
-        cv::Mat zeroDist = cv::Mat::zeros(4, 1, cv::DataType<double>::type);
+        // 2. Since BGR frames are now undistorted, we treat them as a perfect pinhole camera (zero distortion);
+        // YUV luma is tracked with the real distortion coefficients (trackingDist)
 
         // Update viewport in case window size != framebuffer size
         int display_w, display_h;
@@ -162,46 +239,105 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // update and draw camera frame as background
-        renderer.updateBackground(frame);
+        if (captured.format != CaptureFormat::BGR)
+            renderer.updateBackground(captured);
+        else
+            renderer.updateBackground(prepared);
         // draw background
         renderer.drawBackground();
 
-        // 3. Estimate pose using zeroDist
-        // We use the original cameraMatrix (approximation), but NO distortion
-        bool success = tracker->estimatePose(frame, cameraMatrix, zeroDist, rvec, tvec);
+        // 3. Estimate pose with the intrinsics of this resolution and trackingDist: the undistortion maps
+        // keep cameraMatrix as the new camera matrix, so undistorted BGR frames are exact pinhole images
+        // Skipped frames render the prediction of the filter
+        bool tracked = false;
+        bool success = false;
+        bool reused = false; // Motion gate: the previous pose still holds for this frame
+        double gateMs = 0.0;
+        double measuredAt = captureTime; // Capture time of the frame the new pose belongs to
+        double trackMs = 0.0;
+        PoseDiagnostics diagnostics;
+        if (asyncTracker)
+        {
+            // Hand the frame to the worker and pick up whatever it finished since the last frame
+            asyncTracker->submit(prepared, frameCount, captureTime, undistorted);
+            TrackedPose result;
+            if (asyncTracker->poll(result))
+            {
+                tracked = true;
+                success = result.success;
+                rvec = result.rvec;
+                tvec = result.tvec;
+                measuredAt = result.timestamp;
+                trackMs = result.trackMs;
+                diagnostics = result.diagnostics;
+                if (success)
+                {
+                    previousPose = lastPose;
+                    lastPose = result;
+                }
+            }
+        }
+        else if (frameCount % trackEveryN == 0)
+        {
+            // Motion gate: a static scene keeps the last estimate (rvec / tvec still hold it)
+            if (motionGate)
+            {
+                auto gateStart = std::chrono::high_resolution_clock::now();
+                reused = !motionGate->needsTracking(prepared.gray);
+                gateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - gateStart).count();
+            }
+            if (!reused)
+            {
+                tracked = true;
+                tracker->lastDiagnostics = PoseDiagnostics();
+                auto trackStart = std::chrono::high_resolution_clock::now();
+                success = tracker->estimatePose(prepared, cameraMatrix, trackingDist, rvec, tvec);
+                trackMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - trackStart).count();
+                diagnostics = tracker->lastDiagnostics;
+                // Ring luma is tracked in place; a pose from a rewritten slot is not trusted
+                success = success && source.isCurrent();
+                if (motionGate)
+                    motionGate->tracked(success);
+            }
+        }
 
-        if (success)
+        // 4. Pose to draw, at the time this frame reaches the screen
+        const double displayTime = captureTime + displayLatency;
+        bool hasPose = false;
+        double poseTime = measuredAt; // Newest measurement behind the drawn pose
+        if (options.filterPose)
         {
-            // build rotation matrix
-            cv::Rodrigues(rvec, rotationMatrix);
-
-            // build modelview matrix
-            double modelViewMatrix[16];
-            std::memset(modelViewMatrix, 0, sizeof(modelViewMatrix));
-
-            // Column 0
-            modelViewMatrix[0] = (double)rotationMatrix.at<double>(0, 0);
-            modelViewMatrix[1] = -(double)rotationMatrix.at<double>(1, 0);
-            modelViewMatrix[2] = -(double)rotationMatrix.at<double>(2, 0);
-            modelViewMatrix[3] = 0.0;
-
-            // Column 1  (flip Y)
-            modelViewMatrix[4] = (double)rotationMatrix.at<double>(0, 1);
-            modelViewMatrix[5] = -(double)rotationMatrix.at<double>(1, 1);
-            modelViewMatrix[6] = -(double)rotationMatrix.at<double>(2, 1);
-            modelViewMatrix[7] = 0.0;
-
-            // Column 2  (flip Z)
-            modelViewMatrix[8] = (double)rotationMatrix.at<double>(0, 2);
-            modelViewMatrix[9] = -(double)rotationMatrix.at<double>(1, 2);
-            modelViewMatrix[10] = -(double)rotationMatrix.at<double>(2, 2);
-            modelViewMatrix[11] = 0.0;
-
-            // Column 3 = translation (flip Y and Z)
-            modelViewMatrix[12] = (double)tvec.at<double>(0);
-            modelViewMatrix[13] = -(double)tvec.at<double>(1);
-            modelViewMatrix[14] = -(double)tvec.at<double>(2);
-            modelViewMatrix[15] = 1.0;
+            // A reused pose is measured again at this frame, so the filter keeps it instead of coasting out
+            if (success || reused)
+                poseFilter.correct(measuredAt, rvec, tvec);
+            // Extrapolates the filtered pose; coasts through short failure streaks
+            hasPose = poseFilter.predict(displayTime, drawPose);
+            poseTime = poseFilter.lastTimestamp();
+        }
+        else if (asyncTracker)
+        {
+            // Interpolate / extrapolate the last two results of the worker
+            if (lastPose.sequence > 0 && displayTime - lastPose.timestamp <= options.filter.maxCoastSeconds)
+            {
+                if (previousPose.sequence > 0)
+                    drawPose = interpolatePose(previousPose.timestamp, ar::Pose::fromCv(previousPose.rvec, previousPose.tvec),
+                                               lastPose.timestamp, ar::Pose::fromCv(lastPose.rvec, lastPose.tvec), displayTime);
+                else
+                    drawPose = ar::Pose::fromCv(lastPose.rvec, lastPose.tvec);
+                hasPose = true;
+                poseTime = lastPose.timestamp;
+            }
+        }
+        else if (success || reused)
+        {
+            drawPose = ar::Pose::fromCv(rvec, tvec);
+            hasPose = true;
+        }
+
+        if (hasPose)
+        {
+            // OpenCV pose -> OpenGL modelview, fixed-size and on the stack
+            const ar::Mat4 modelViewMatrix = drawPose.modelView();
 
             // --- RENDER ---
             // project the 3D axes onto the image.
@@ -212,8 +348,8 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
             axisPoints.push_back(cv::Point3f(0, 0, -squareSize * 3)); // Z-axis
 
             std::vector<cv::Point2f> image_axes;
-            // Use zeroDist, so lines match with OpenGL render
-            cv::projectPoints(axisPoints, rvec, tvec, cameraMatrix, distCoeffs, image_axes);
+            // Distortion of the debug view: none on undistorted BGR, the real one on raw luma
+            cv::projectPoints(axisPoints, drawPose.rvec.toCv(), drawPose.tvec.toCv(), cameraMatrix, trackingDist, image_axes);
 
             // Draw the projected axes on the image
             cv::line(frame, image_axes[0], image_axes[1], cv::Scalar(0, 0, 255), 3); // X-axis in Red
@@ -230,18 +366,48 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
         double frameTimeMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
 
         // Store frame statistics
-        stats.frames.push_back(FrameStats{
+        FrameStats frameStats{
             frameCount,
             std::chrono::duration<double>(frameEnd - t_start).count(),
             success,
-            rvec.clone(), tvec.clone(),
-            frameTimeMs});
+            ar::Pose::fromCv(rvec, tvec),
+            frameTimeMs};
+        frameStats.solverIterations = diagnostics.iterations;
+        frameStats.solveMs = diagnostics.solveMs;
+        frameStats.warmStarted = diagnostics.warmStarted;
+        frameStats.tracked = tracked;
+        frameStats.trackMs = trackMs;
+        frameStats.displayed = hasPose;
+        if (hasPose)
+        {
+            frameStats.displayPose = drawPose;
+            frameStats.poseAgeMs = (displayTime - poseTime) * 1000.0;
+        }
+        frameStats.qualityLevel = governor ? governor->level() : 0;
+        frameStats.motionSkipped = reused;
+        frameStats.gateMs = gateMs;
+        stats.frames.push_back(frameStats);
+
+        // Adapt the tracker to the measured time (the worker's own time in asynchronous mode,
+        // since rendering does not wait for it there)
+        if (governor && tracked && governor->update(frameStats.frame_id, asyncTracker ? trackMs : frameTimeMs))
+        {
+            const TrackerQuality &quality = governor->quality();
+            if (asyncTracker)
+                asyncTracker->setQuality(quality);
+            else
+                tracker->quality = quality;
+            preprocessor.options.halfResolution = options.halfResDetection || quality.halfResolution;
+            const QualityChange &change = governor->changes().back();
+            stats.qualityChanges.push_back(change);
+            std::cout << "Quality level " << change.fromLevel << " -> " << change.toLevel << " (" << change.measuredMs << " ms, budget " << change.budgetMs << " ms)" << std::endl;
+        }
 
         // Increment frame count
         frameCount++;
 
-        // DEBUGGING
-        if (!useNft)
+        // DEBUGGING (the corners belong to the worker in asynchronous mode)
+        if (!useNft && !asyncTracker)
         {
             ChessboardTracker *chess = dynamic_cast<ChessboardTracker *>(tracker.get());
             if (chess && chess->lastCorners.size() == patternSize.width * patternSize.height)
@@ -306,6 +472,19 @@ void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize,
         // swap buffers and poll events
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        // Latency the next prediction has to cover
+        const double swapTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+        displayLatency += 0.1 * ((swapTime - captureTime) - displayLatency);
+    }
+    if (source.skippedFrames() > 0)
+        std::cout << "Skipped " << source.skippedFrames() << " ring frames to stay on the newest" << std::endl;
+    if (motionGate)
+    {
+        const nlohmann::json gate = stats.computeMotionGate();
+        std::cout << "Motion gate skipped " << gate["skipped_frames"] << " frames (" << gate["skip_ratio"].get<double>() * 100.0
+                  << "%), saving about " << gate["saved_time_ms"].get<double>() << " ms of tracking; "
+                  << motionGate->forcedCount() << " forced re-estimates" << std::endl;
     }
     // cleanup
     glfwDestroyWindow(window);
@@ -1,7 +1,41 @@
+#pragma once
 #include <opencv2/opencv.hpp>
+#include <filesystem>
 #include <vector>
+#include "calibration_store.hpp"
+#include "frame_preprocessor.hpp"
+#include "frame_source.hpp"
+#include "motion_gate.hpp"
+#include "pose_filter.hpp"
+#include "quality_governor.hpp"
+#include "tracker.hpp"
+
+// Settings of the augmentation loop
+struct AugmentOptions
+{
+    PoseSolver solver = PoseSolver::OpenCV; // Pose solver of the tracker
+    bool filterPose = true;                 // Render the filtered pose predicted to display time
+    PoseFilterOptions filter;               // Smoothing / coasting of the rendered pose
+    int trackEveryN = 1;                    // Run the tracker on every Nth frame (needs filterPose to render in between)
+    bool asyncTracking = false;             // Track on a worker thread, render every camera frame (ignores trackEveryN)
+    bool halfResDetection = false;          // Chessboard detection on the half-resolution level, refined at full resolution
+    bool chessCorners = false;              // Chessboard: ChESS saddle-point detector instead of cv::findChessboardCorners
+    bool gridFeatures = false;              // NFT: tile-parallel FAST with per-cell quotas instead of one ORB pass
+    bool multiView = false;                 // NFT: match against zoomed-out and tilted views of the reference
+    CaptureFormat captureFormat = CaptureFormat::BGR; // YUYV / NV12: track on the luma plane, convert colour only in the background shader
+    std::filesystem::path rawInput;         // Read raw YUYV / NV12 frames from this file instead of the camera
+    cv::Size rawSize;                       // Frame size of rawInput
+    std::string frameRing;                  // Take frames from this shared-memory ring (ar_ring produce) instead of the camera
+    double frameBudgetMs = 0.0;             // > 0: the quality governor trades tracker quality to keep frames within this time
+    QualityGovernorOptions governor;        // Ladder stepping of the governor (its budget comes from frameBudgetMs)
+    bool motionGate = false;                // Reuse the previous pose while the scene is static (synchronous tracking only)
+    MotionGateOptions gate;                 // Motion threshold and forced re-estimate interval of the gate
+};
 
 // Initialize augmentor by loading camera calibration data
 void initAugmentor(cv::Mat &cameraMatrix, cv::Mat &distCoeffs, cv::Size patternSize);
+// Same, keeping the store for per-resolution intrinsics, projection and undistortion maps
+bool initAugmentor(CalibrationStore &calibration, cv::Size patternSize);
 // Main augmentation loop - captures video, estimates pose, and renders AR content
-void augmentLoop(cv::VideoCapture &capture, bool &useNft, cv::Size patternSize, float squareSize, const std::string &experimentName, const std::string &testName);
\ No newline at end of file
+void augmentLoop(bool &useNft, cv::Size patternSize, float squareSize, const std::string &experimentName, const std::string &testName,
+                 const AugmentOptions &options = AugmentOptions());
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "batch_processor.hpp"
+#include "frame_reader.hpp"
+#include "reorder_buffer.hpp"
+#include "tracker_factory.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+bool parsePatternSize(const std::string &text, cv::Size &patternSize)
+{
+    const size_t x = text.find('x');
+    if (x == std::string::npos)
+        return false;
+    try
+    {
+        patternSize = cv::Size(std::stoi(text.substr(0, x)), std::stoi(text.substr(x + 1)));
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    return patternSize.width > 0 && patternSize.height > 0;
+}
+
+// Output names for the inputs: the stem alone where that is unique, otherwise prefixed with as
+// many parent folders as it takes ("a/images" and "b/images" become a_images and b_images).
+// Inputs that differ only in the extension keep it. False if two inputs are the same path.
+static bool outputNames(const std::vector<std::filesystem::path> &inputs, std::vector<std::string> &names)
+{
+    // Candidate names of every input, from the shortest to one that spells out the whole path
+    std::vector<std::vector<std::string>> candidates;
+    for (const auto &input : inputs)
+    {
+        std::vector<std::string> parts;
+        for (const auto &part : std::filesystem::absolute(input).lexically_normal().relative_path())
+            if (!part.empty())
+                parts.push_back(part.string());
+        if (parts.empty())
+            parts.push_back("root");
+        const std::filesystem::path file = parts.back();
+        const std::string stem = file.stem().string();
+        std::string withExtension = file.filename().string();
+        std::replace(withExtension.begin(), withExtension.end(), '.', '_');
+
+        std::vector<std::string> forms{stem, withExtension};
+        std::string prefix;
+        for (size_t i = parts.size() - 1; i-- > 0;)
+        {
+            prefix = parts[i] + "_" + prefix;
+            forms.push_back(prefix + stem);
+            forms.push_back(prefix + withExtension);
+        }
+        candidates.push_back(std::move(forms));
+    }
+
+    // Lengthen the names of colliding inputs until they all differ
+    std::vector<size_t> level(inputs.size(), 0);
+    while (true)
+    {
+        bool grown = false, collision = false;
+        std::vector<size_t> next = level; // Both sides of a collision grow in the same pass
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            for (size_t j = 0; j < inputs.size(); ++j)
+            {
+                if (i == j || candidates[i][level[i]] != candidates[j][level[j]])
+                    continue;
+                collision = true;
+                if (level[i] + 1 < candidates[i].size())
+                {
+                    next[i] = level[i] + 1;
+                    grown = true;
+                }
+                break;
+            }
+        }
+        if (!collision)
+            break;
+        if (!grown)
+            return false;
+        level = next;
+    }
+
+    names.clear();
+    for (size_t i = 0; i < inputs.size(); ++i)
+        names.push_back(candidates[i][level[i]]);
+    return true;
+}
+
+BatchProcessor::BatchProcessor(const BatchOptions &options) : options(options), pool(options.threads)
+{
+    if (this->options.maxInFlight <= 0)
+        this->options.maxInFlight = static_cast<int>(pool.size()) * 4;
+}
+
+bool BatchProcessor::init()
+{
+    // Workers get frames in scheduling order, so a warm start would refine from an unrelated frame
+    if (options.solver == PoseSolver::Temporal)
+    {
+        std::cerr << "The temporal solver needs consecutive frames and is not available in batch processing" << std::endl;
+        return false;
+    }
+
+    // Default to the calibration folder keyed by pattern size, like initAugmentor
+    std::filesystem::path calibrationJson = options.calibrationPath;
+    if (calibrationJson.empty())
+    {
+        std::string patternStr = std::to_string(options.patternSize.width) + "x" + std::to_string(options.patternSize.height);
+        calibrationJson = std::filesystem::path("data/calibration") / patternStr / "calibration.json";
+    }
+    if (!calibration.load(calibrationJson))
+    {
+        std::cerr << "Unable to read " << calibrationJson << std::endl;
+        return false;
+    }
+    intrinsics = nullptr;
+    // Frames are undistorted before tracking, so trackers see a perfect pinhole camera
+    zeroDist = cv::Mat::zeros(4, 1, CV_64F);
+
+    // Trackers keep per-call state, so every worker gets its own instance
+    trackers.clear();
+    for (unsigned i = 0; i < pool.size(); ++i)
+    {
+        auto tracker = createTracker(options.useNft, options.patternSize, options.squareSize, options.referencePath);
+        tracker->showDebug = false; // No HighGUI windows from worker threads
+        tracker->solver = options.solver;
+        if (auto *nft = dynamic_cast<NFTTracker *>(tracker.get()); nft && options.multiView)
+        {
+            // One database for all workers, built by the first
+            nft->multiView = true;
+            if (trackers.empty())
+                nft->buildDatabase();
+            else
+                nft->useDatabase(static_cast<NFTTracker &>(*trackers.front()).sharedDatabase());
+        }
+        if (auto *chessboard = dynamic_cast<ChessboardTracker *>(tracker.get()))
+            chessboard->chessCorners = options.chessCorners;
+        trackers.push_back(std::move(tracker));
+    }
+    return true;
+}
+
+FrameStats BatchProcessor::processFrame(const cv::Mat &frame, int index, double timestamp)
+{
+    PoseTracker &tracker = *trackers[pool.currentWorker()];
+    // A worker's previous frame is whatever it was scheduled last, not the frame before this one:
+    // drop the prior pose so every frame is tracked from scratch
+    if (auto *nft = dynamic_cast<NFTTracker *>(&tracker))
+        nft->lostTrack();
+    else if (auto *chessboard = dynamic_cast<ChessboardTracker *>(&tracker))
+        chessboard->temporal.reset();
+
+    auto frameStart = std::chrono::high_resolution_clock::now();
+    // Same undistortion as augmentLoop, using the precomputed maps
+    cv::Mat undistorted;
+    cv::remap(frame, undistorted, intrinsics->map1, intrinsics->map2, cv::INTER_LINEAR);
+
+    cv::Mat rvec, tvec;
+    auto trackStart = std::chrono::high_resolution_clock::now();
+    bool success = tracker.estimatePose(undistorted, intrinsics->cameraMatrix, zeroDist, rvec, tvec);
+    auto frameEnd = std::chrono::high_resolution_clock::now();
+
+    FrameStats stats{
+        index,
+        timestamp,
+        success,
+        ar::Pose::fromCv(rvec, tvec),
+        std::chrono::duration<double, std::milli>(frameEnd - frameStart).count()};
+    stats.solverIterations = tracker.lastDiagnostics.iterations;
+    stats.solveMs = tracker.lastDiagnostics.solveMs;
+    stats.warmStarted = tracker.lastDiagnostics.warmStarted;
+    stats.trackMs = std::chrono::duration<double, std::milli>(frameEnd - trackStart).count();
+    return stats;
+}
+
+BatchResult BatchProcessor::process(const std::filesystem::path &input, SessionStats &stats)
+{
+    BatchResult result;
+    result.input = input;
+
+    FrameReader reader(input);
+    if (!reader.isOpened())
+    {
+        std::cerr << "Unable to open " << input << std::endl;
+        return result;
+    }
+
+    // Results arrive in completion order; the reorder buffer appends them in frame order
+    ReorderBuffer<FrameStats> reorder([&stats](size_t, FrameStats &&f)
+                                      { stats.frames.push_back(std::move(f)); });
+
+    // Bound the number of decoded frames waiting for a worker
+    std::mutex flightMutex;
+    std::condition_variable flightChanged;
+    int inFlight = 0;
+
+    auto wallStart = std::chrono::high_resolution_clock::now();
+    cv::Mat frame;
+    int index = 0;
+    while (reader.read(frame))
+    {
+        // Intrinsics and undistortion maps once per frame size (cached across runs in the sidecar)
+        if (!intrinsics || frame.size() != intrinsics->size)
+        {
+            pool.waitIdle(); // Workers may still be reading the old maps
+            intrinsics = &calibration.at(frame.size());
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(flightMutex);
+            flightChanged.wait(lock, [&]
+                               { return inFlight < options.maxInFlight; });
+            inFlight++;
+        }
+
+        const double timestamp = reader.timestamp(index);
+        pool.submit([this, &reorder, &flightMutex, &flightChanged, &inFlight, frame, index, timestamp]
+                    {
+                        // A throwing tracker fails its frame, it must not leave a hole in the
+                        // reorder buffer or an inFlight slot that is never released
+                        FrameStats result{index, timestamp, false, ar::Pose{}, 0.0};
+                        try
+                        {
+                            result = processFrame(frame, index, timestamp);
+                        }
+                        catch (const std::exception &e)
+                        {
+                            std::cerr << "Frame " << index << " failed: " << e.what() << std::endl;
+                        }
+                        reorder.push(index, std::move(result));
+                        // Notified under the lock: once inFlight reaches 0 the waiter may return and
+                        // destroy the condition variable
+                        std::lock_guard<std::mutex> lock(flightMutex);
+                        inFlight--;
+                        flightChanged.notify_one(); });
+
+        // Release our reference so the reader decodes into a fresh buffer
+        frame.release();
+        index++;
+    }
+
+    // Wait for the tail of the input
+    {
+        std::unique_lock<std::mutex> lock(flightMutex);
+        flightChanged.wait(lock, [&]
+                           { return inFlight == 0; });
+    }
+    pool.waitIdle(); // No task still holds the flow-control state
+
+    auto wallEnd = std::chrono::high_resolution_clock::now();
+    result.frames = static_cast<size_t>(index);
+    result.wallSeconds = std::chrono::duration<double>(wallEnd - wallStart).count();
+    result.framesPerSecond = result.wallSeconds > 0 ? result.frames / result.wallSeconds : 0.0;
+    return result;
+}
+
+std::vector<BatchResult> BatchProcessor::run(const std::vector<std::filesystem::path> &inputs)
+{
+    std::vector<BatchResult> results;
+    // Checked up front, so a duplicate does not overwrite a finished session
+    std::vector<std::string> names;
+    if (!outputNames(inputs, names))
+    {
+        std::cerr << "Duplicate inputs: every input needs its own output name" << std::endl;
+        return results;
+    }
+    std::filesystem::create_directories(options.outputDir);
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const std::filesystem::path &input = inputs[i];
+        SessionStats stats;
+        BatchResult result = process(input, stats);
+        if (result.frames == 0)
+        {
+            results.push_back(result);
+            continue;
+        }
+
+        // Save in the same format augmentLoop writes, named after the input
+        result.output = options.outputDir / (names[i] + ".json");
+        std::ofstream out(result.output);
+        if (out.is_open())
+        {
+            out << stats.toJson().dump(4);
+            std::cout << input << ": " << result.frames << " frames in " << result.wallSeconds << " s ("
+                      << result.framesPerSecond << " fps) -> " << result.output << std::endl;
+        }
+        else
+        {
+            std::cerr << "Unable to open " << result.output << " to save session statistics." << std::endl;
+        }
+        results.push_back(result);
+    }
+    return results;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "calibration_store.hpp"
+#include "statistics.hpp"
+#include "thread_pool.hpp"
+#include "tracker.hpp"
+
+// Settings for offline processing of recorded sessions
+struct BatchOptions
+{
+    bool useNft = false;                                     // NFT or chessboard tracking
+    PoseSolver solver = PoseSolver::OpenCV;                  // Pose solver of every tracker (not Temporal)
+    cv::Size patternSize{8, 6};                              // Inner corners of the chessboard
+    float squareSize = 25.0f;                                // Physical square size
+    std::string referencePath = "data/reference/reference.png"; // NFT reference image
+    bool multiView = false;                                  // NFT: multi-scale / multi-view reference database
+    bool chessCorners = false;                               // Chessboard: ChESS saddle-point detector
+    std::filesystem::path calibrationPath;                   // calibration.json (empty = data/calibration/<WxH>)
+    std::filesystem::path outputDir = "data/statistics/Batch"; // Where the session JSON files go
+    unsigned threads = 0;                                    // Worker count (0 = all cores)
+    int maxInFlight = 0;                                     // Frames decoded ahead of the writer (0 = 4 per worker)
+};
+
+// Outcome of processing one input
+struct BatchResult
+{
+    std::filesystem::path input;  // Video file or image directory
+    std::filesystem::path output; // Written session statistics
+    size_t frames = 0;            // Frames processed
+    double wallSeconds = 0.0;     // Total wall-clock time
+    double framesPerSecond = 0.0; // Throughput
+};
+
+// Runs a tracker over video files or image directories, fanning frames out across a
+// work-stealing pool. Every worker owns its own tracker instance and results are written
+// in frame order through a reorder buffer.
+class BatchProcessor
+{
+public:
+    explicit BatchProcessor(const BatchOptions &options);
+
+    // Load calibration and build one tracker per worker
+    bool init();
+
+    // Process one input into stats (frames are appended in order)
+    BatchResult process(const std::filesystem::path &input, SessionStats &stats);
+
+    // Process every input and save <outputDir>/<input stem>.json for each. Inputs with the same stem
+    // are prefixed with their parent folders; nothing is processed if an input is listed twice.
+    std::vector<BatchResult> run(const std::vector<std::filesystem::path> &inputs);
+
+    // Number of worker threads
+    unsigned workerCount() const { return pool.size(); }
+
+private:
+    // Undistort and track a single frame on the calling worker
+    FrameStats processFrame(const cv::Mat &frame, int index, double timestamp);
+
+    BatchOptions options;
+    ThreadPool pool;                                     // Frame-level workers
+    std::vector<std::unique_ptr<PoseTracker>> trackers; // One tracker per worker
+    CalibrationStore calibration;                       // Calibration, rescaled per frame size
+    const ResolutionIntrinsics *intrinsics = nullptr;   // Intrinsics and undistortion maps of the current frame size
+    cv::Mat zeroDist;                                   // Frames are tracked undistorted
+};
+
+// Parse a pattern string such as "8x6"
+bool parsePatternSize(const std::string &text, cv::Size &patternSize);
@@ -0,0 +1,274 @@
+#include "calibration_engine.hpp"
+#include "calibrator.hpp"
+#include "frame_reader.hpp"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+CalibrationEngine::CalibrationEngine(const CalibrationEngineOptions &options, ThreadPool *pool)
+    : options(options), pool(pool)
+{
+    // Same board coordinates as the interactive calibrator
+    for (int i = 0; i < options.patternSize.height; i++)
+        for (int j = 0; j < options.patternSize.width; j++)
+            boardPoints.push_back(cv::Point3f(j * options.squareSize, i * options.squareSize, 0));
+}
+
+bool CalibrationEngine::detectCorners(const cv::Mat &gray, std::vector<cv::Point2f> &corners) const
+{
+    if (!cv::findChessboardCorners(gray, options.patternSize, corners, cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE))
+        return false;
+    cv::TermCriteria criteria(cv::TermCriteria::EPS | cv::TermCriteria::MAX_ITER, 30, 0.001);
+    cv::cornerSubPix(gray, corners, cv::Size(11, 11), cv::Size(-1, -1), criteria);
+    return true;
+}
+
+std::filesystem::path CalibrationEngine::cachePath(const std::filesystem::path &image) const
+{
+    const std::filesystem::path dir = options.cacheDir.empty() ? image.parent_path().parent_path() / "corner_cache" : options.cacheDir;
+    return dir / (image.filename().string() + ".json");
+}
+
+// Identity of an image file as stored in the cache
+static nlohmann::json fileStamp(const std::filesystem::path &image, cv::Size patternSize)
+{
+    return {
+        {"pattern", {patternSize.width, patternSize.height}},
+        {"file_size", std::filesystem::file_size(image)},
+        {"mtime", std::filesystem::last_write_time(image).time_since_epoch().count()}};
+}
+
+bool CalibrationEngine::loadCached(const std::filesystem::path &image, CalibrationView &view, bool &found, cv::Size &size) const
+{
+    std::ifstream in(cachePath(image));
+    if (!in)
+        return false;
+    nlohmann::json j = nlohmann::json::parse(in, nullptr, false);
+    if (j.is_discarded() || j["stamp"] != fileStamp(image, options.patternSize))
+        return false; // Unreadable or stale
+
+    // Missing or mistyped keys make it a miss as well; nothing is written to the outputs until
+    // the whole entry has been read
+    bool cachedFound = false;
+    cv::Size cachedSize;
+    std::vector<cv::Point2f> corners;
+    try
+    {
+        cachedFound = j.at("found").get<bool>();
+        cachedSize = cv::Size(j.at("image_size").at(0).get<int>(), j.at("image_size").at(1).get<int>());
+        for (const auto &c : j.at("corners"))
+            corners.emplace_back(c.at(0).get<float>(), c.at(1).get<float>());
+    }
+    catch (const nlohmann::json::exception &)
+    {
+        return false;
+    }
+    if (cachedFound && corners.size() != boardPoints.size())
+        return false;
+
+    found = cachedFound;
+    size = cachedSize;
+    view.corners = std::move(corners);
+    return true;
+}
+
+void CalibrationEngine::storeCached(const std::filesystem::path &image, const CalibrationView &view, bool found, cv::Size size) const
+{
+    nlohmann::json j;
+    j["stamp"] = fileStamp(image, options.patternSize);
+    j["found"] = found;
+    j["image_size"] = {size.width, size.height};
+    j["corners"] = nlohmann::json::array();
+    for (const auto &c : view.corners)
+        j["corners"].push_back({c.x, c.y});
+
+    std::ofstream out(cachePath(image));
+    if (out)
+        out << j.dump();
+}
+
+std::vector<CalibrationView> CalibrationEngine::detectDirectory(const std::filesystem::path &dir)
+{
+    const std::vector<std::filesystem::path> images = listImages(dir);
+    std::vector<CalibrationView> results(images.size());
+    std::vector<char> found(images.size(), 0);
+    std::vector<cv::Size> sizes(images.size());
+    if (images.empty())
+        return {};
+    if (options.useCache)
+        std::filesystem::create_directories(cachePath(images.front()).parent_path());
+
+    // One image per task: detection time varies a lot between images, stealing evens it out
+    auto detectRange = [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            CalibrationView &view = results[i];
+            view.image = images[i];
+            bool hit = false;
+            if (options.useCache)
+            {
+                bool cachedFound = false;
+                hit = loadCached(images[i], view, cachedFound, sizes[i]);
+                found[i] = cachedFound;
+            }
+            if (hit)
+                continue;
+
+            cv::Mat gray = cv::imread(images[i].string(), cv::IMREAD_GRAYSCALE);
+            if (gray.empty())
+                continue;
+            sizes[i] = gray.size();
+            found[i] = detectCorners(gray, view.corners);
+            if (options.useCache)
+                storeCached(images[i], view, found[i], sizes[i]);
+        }
+    };
+    pool->parallelFor(0, static_cast<int>(images.size()), detectRange);
+
+    std::vector<CalibrationView> views;
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (!found[i])
+        {
+            std::cout << "No board in " << images[i].filename() << std::endl;
+            continue;
+        }
+        if (imageSize.empty())
+            imageSize = sizes[i];
+        else if (sizes[i] != imageSize)
+        {
+            std::cerr << "Skipping " << images[i].filename() << ": image size differs" << std::endl;
+            continue;
+        }
+        views.push_back(std::move(results[i]));
+    }
+    return views;
+}
+
+int CalibrationEngine::addImageDirectory(const std::filesystem::path &dir)
+{
+    std::vector<CalibrationView> views = detectDirectory(dir);
+    for (auto &view : views)
+        addView(std::move(view));
+    return static_cast<int>(views.size());
+}
+
+void CalibrationEngine::addView(CalibrationView view)
+{
+    evaluateView(view);
+    viewList.push_back(std::move(view));
+}
+
+void CalibrationEngine::setViews(std::vector<CalibrationView> views)
+{
+    viewList = std::move(views);
+    for (auto &view : viewList)
+        evaluateView(view);
+}
+
+void CalibrationEngine::evaluateView(CalibrationView &view) const
+{
+    if (!solved())
+        return;
+    cv::solvePnP(boardPoints, view.corners, cameraMatrix, distCoeffs, view.rvec, view.tvec);
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(boardPoints, view.rvec, view.tvec, cameraMatrix, distCoeffs, projected);
+    view.error = cv::norm(view.corners, projected, cv::NORM_L2) / std::sqrt(static_cast<double>(projected.size()));
+}
+
+int CalibrationEngine::enabledViews() const
+{
+    int count = 0;
+    for (const auto &view : viewList)
+        count += view.enabled;
+    return count;
+}
+
+bool CalibrationEngine::solve()
+{
+    std::vector<std::vector<cv::Point3f>> objectPoints;
+    std::vector<std::vector<cv::Point2f>> imagePoints;
+    std::vector<CalibrationView *> used;
+    for (auto &view : viewList)
+    {
+        if (!view.enabled)
+            continue;
+        objectPoints.push_back(boardPoints);
+        imagePoints.push_back(view.corners);
+        used.push_back(&view);
+    }
+    if (used.size() < 3 || imageSize.empty())
+        return false;
+
+    // Warm start: LM begins at the previous intrinsics instead of the closed-form initialization
+    int flags = options.flags;
+    cv::Mat K, dist;
+    if (solved())
+    {
+        K = cameraMatrix.clone();
+        dist = distCoeffs.clone();
+        flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+    }
+
+    std::vector<cv::Mat> rvecs, tvecs;
+    cv::Mat stdIntrinsics, stdExtrinsics, perViewErrors;
+    auto start = std::chrono::high_resolution_clock::now();
+    double error = cv::calibrateCamera(objectPoints, imagePoints, imageSize, K, dist, rvecs, tvecs,
+                                       stdIntrinsics, stdExtrinsics, perViewErrors, flags);
+    lastSolveMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    cameraMatrix = K;
+    distCoeffs = dist;
+    rms = error;
+    for (size_t i = 0; i < used.size(); ++i)
+    {
+        used[i]->error = perViewErrors.at<double>(static_cast<int>(i));
+        used[i]->rvec = rvecs[i];
+        used[i]->tvec = tvecs[i];
+    }
+    // Disabled views keep an up-to-date score so they can be brought back
+    for (auto &view : viewList)
+        if (!view.enabled)
+            evaluateView(view);
+    return true;
+}
+
+int CalibrationEngine::prune(double maxViewError)
+{
+    int pruned = 0;
+    for (auto &view : viewList)
+    {
+        if (view.enabled && view.error > maxViewError)
+        {
+            view.enabled = false;
+            pruned++;
+        }
+    }
+    if (pruned > 0)
+        solve();
+    return pruned;
+}
+
+bool CalibrationEngine::save(const std::filesystem::path &dir) const
+{
+    if (!solved())
+        return false;
+    saveCalibrationData(dir, cameraMatrix, distCoeffs, rms, imageSize);
+
+    // Per-view report next to calibration.json
+    nlohmann::json report = nlohmann::json::array();
+    for (const auto &view : viewList)
+    {
+        report.push_back({{"image", view.image.filename().string()},
+                          {"enabled", view.enabled},
+                          {"reprojection_error", view.error}});
+    }
+    std::ofstream out(dir / "views.json");
+    if (!out)
+        return false;
+    out << report.dump(4);
+    return true;
+}
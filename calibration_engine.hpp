@@ -0,0 +1,83 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <vector>
+#include "thread_pool.hpp"
+
+// One calibration image and what the engine knows about it
+struct CalibrationView
+{
+    std::filesystem::path image;      // Source image (empty for views added from a live camera)
+    std::vector<cv::Point2f> corners; // Sub-pixel chessboard corners
+    bool enabled = true;              // Part of the solve (false once pruned)
+    double error = 0.0;               // RMS reprojection error of this view in pixels
+    cv::Mat rvec, tvec;               // Board pose of this view
+};
+
+// Settings of the calibration engine
+struct CalibrationEngineOptions
+{
+    cv::Size patternSize{8, 6};     // Inner corners of the chessboard
+    float squareSize = 25.0f;       // Physical square size
+    bool useCache = true;           // Reuse corners detected by an earlier run
+    std::filesystem::path cacheDir; // Where cached corners go (empty = corner_cache next to the image directory)
+    int flags = 0;                  // Extra cv::calibrateCamera flags
+};
+
+// Chessboard camera calibration that can grow and shrink its view set cheaply
+// - Corners are detected in parallel and cached per image, so reruns skip detection
+// - Every solve after the first starts from the previous intrinsics (CALIB_USE_INTRINSIC_GUESS)
+// - Per-view reprojection errors identify bad views, which can be dropped and re-solved without
+//   detecting anything again
+class CalibrationEngine
+{
+public:
+    explicit CalibrationEngine(const CalibrationEngineOptions &options, ThreadPool *pool = &ThreadPool::shared());
+
+    // Detect (or load cached) corners of every image in dir in parallel; returns the views with a board
+    std::vector<CalibrationView> detectDirectory(const std::filesystem::path &dir);
+
+    // detectDirectory + addView for each result; returns the number of views added
+    int addImageDirectory(const std::filesystem::path &dir);
+
+    // Add a view; scored against the current solution right away
+    void addView(CalibrationView view);
+
+    // Replace the view set (e.g. with a selector's pool); the current solution stays as the warm start
+    void setViews(std::vector<CalibrationView> views);
+
+    // Find and refine the corners of one grayscale image
+    bool detectCorners(const cv::Mat &gray, std::vector<cv::Point2f> &corners) const;
+
+    // Solve over all enabled views; warm-started once a solution exists
+    bool solve();
+
+    // Disable views whose error exceeds maxViewError and re-solve; returns the number pruned
+    int prune(double maxViewError);
+
+    // Write calibration.json (same layout as the interactive calibrator) and views.json to dir
+    bool save(const std::filesystem::path &dir) const;
+
+    const std::vector<CalibrationView> &views() const { return viewList; }
+    int enabledViews() const;
+    bool solved() const { return !cameraMatrix.empty(); }
+
+    cv::Mat cameraMatrix, distCoeffs; // Current solution
+    double rms = 0.0;                 // RMS reprojection error over the enabled views
+    double lastSolveMs = 0.0;         // Duration of the last cv::calibrateCamera call
+    cv::Size imageSize;               // Size of the calibration images
+
+private:
+    // Corner cache, invalidated when the image file or the pattern changes
+    std::filesystem::path cachePath(const std::filesystem::path &image) const;
+    bool loadCached(const std::filesystem::path &image, CalibrationView &view, bool &found, cv::Size &size) const;
+    void storeCached(const std::filesystem::path &image, const CalibrationView &view, bool found, cv::Size size) const;
+
+    // Error of one view under the current intrinsics (solvePnP, no full solve)
+    void evaluateView(CalibrationView &view) const;
+
+    CalibrationEngineOptions options;
+    ThreadPool *pool;
+    std::vector<cv::Point3f> boardPoints; // Board corners in board coordinates
+    std::vector<CalibrationView> viewList;
+};
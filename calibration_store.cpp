@@ -0,0 +1,246 @@
+#include "calibration_store.hpp"
+#include "jsonHelper.hpp"
+#include "openGLrenderer.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    const char kMagic[8] = {'A', 'R', 'C', 'A', 'L', 'v', '2', '\0'};
+    const std::int32_t kMaxSide = 1 << 14; // Largest frame side accepted from the sidecar
+    const int kMaxDistCoeffs = 14;         // Longest OpenCV distortion model
+
+    // Identity of the JSON file the sidecar was derived from
+    struct SourceStamp
+    {
+        std::uint64_t fileSize = 0;
+        std::int64_t mtime = 0;
+        bool operator==(const SourceStamp &other) const { return fileSize == other.fileSize && mtime == other.mtime; }
+    };
+
+    SourceStamp stampOf(const std::filesystem::path &path)
+    {
+        SourceStamp stamp;
+        stamp.fileSize = std::filesystem::file_size(path);
+        stamp.mtime = static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+        return stamp;
+    }
+
+    template <typename T>
+    void writeValue(std::ostream &out, const T &value)
+    {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool readValue(std::istream &in, T &value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    // Header (rows, cols, type) followed by the raw elements
+    void writeMat(std::ostream &out, const cv::Mat &mat)
+    {
+        const cv::Mat m = mat.isContinuous() ? mat : mat.clone();
+        writeValue(out, static_cast<std::int32_t>(m.rows));
+        writeValue(out, static_cast<std::int32_t>(m.cols));
+        writeValue(out, static_cast<std::int32_t>(m.type()));
+        out.write(reinterpret_cast<const char *>(m.data), static_cast<std::streamsize>(m.total() * m.elemSize()));
+    }
+
+    // Counterpart of writeMat. A header that does not match what the sidecar stores in this place
+    // (type, at most maxRows x maxCols) is rejected before anything is allocated.
+    bool readMat(std::istream &in, cv::Mat &mat, int expectedType, int maxRows, int maxCols)
+    {
+        std::int32_t rows = 0, cols = 0, type = 0;
+        if (!readValue(in, rows) || !readValue(in, cols) || !readValue(in, type) || type != expectedType ||
+            rows <= 0 || cols <= 0 || rows > maxRows || cols > maxCols)
+            return false;
+        mat.create(rows, cols, type);
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(mat.data), static_cast<std::streamsize>(mat.total() * mat.elemSize())));
+    }
+
+    // One derived resolution as appended to the sidecar
+    void writeEntry(std::ostream &out, const ResolutionIntrinsics &entry)
+    {
+        writeValue(out, static_cast<std::int32_t>(entry.size.width));
+        writeValue(out, static_cast<std::int32_t>(entry.size.height));
+        writeMat(out, entry.cameraMatrix);
+        out.write(reinterpret_cast<const char *>(entry.projection), sizeof(entry.projection));
+        writeMat(out, entry.map1);
+        writeMat(out, entry.map2);
+    }
+
+    // Append bytes through O_APPEND, so an entry lands at the end even if another process appended since
+    bool appendBytes(const std::filesystem::path &path, const std::string &bytes)
+    {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0)
+            return false;
+        const char *data = bytes.data();
+        size_t left = bytes.size();
+        while (left > 0)
+        {
+            const ssize_t n = ::write(fd, data, left);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            data += n;
+            left -= static_cast<size_t>(n);
+        }
+        return ::close(fd) == 0 && left == 0;
+    }
+}
+
+bool CalibrationStore::load(const std::filesystem::path &calibrationJson)
+{
+    jsonPath = calibrationJson;
+    sidecarPath = std::filesystem::path(calibrationJson).replace_extension(".cache");
+    derived.clear();
+    if (!std::filesystem::exists(jsonPath))
+        return false;
+
+    sidecarReady = loadSidecar();
+    if (sidecarReady)
+        return true;
+    if (!ar::loadCalibrationData(jsonPath, cameraMatrix, distCoeffs, imageSize))
+        return false;
+    sidecarReady = saveSidecar();
+    return true;
+}
+
+cv::Mat CalibrationStore::scaledCameraMatrix(cv::Size size) const
+{
+    if (imageSize.empty() || size == imageSize)
+        return cameraMatrix.clone();
+
+    // Pixel centers map as (x + 0.5) * s - 0.5, which matters for the principal point
+    const double sx = static_cast<double>(size.width) / imageSize.width;
+    const double sy = static_cast<double>(size.height) / imageSize.height;
+    cv::Mat K = cameraMatrix.clone();
+    K.at<double>(0, 0) *= sx;
+    K.at<double>(0, 1) *= sx;
+    K.at<double>(1, 1) *= sy;
+    K.at<double>(0, 2) = (K.at<double>(0, 2) + 0.5) * sx - 0.5;
+    K.at<double>(1, 2) = (K.at<double>(1, 2) + 0.5) * sy - 0.5;
+    return K;
+}
+
+const ResolutionIntrinsics &CalibrationStore::at(cv::Size size)
+{
+    auto it = derived.find({size.width, size.height});
+    if (it != derived.end())
+        return it->second;
+
+    if (imageSize.empty())
+    {
+        // Older calibration files do not record their resolution
+        std::cerr << "Calibration resolution unknown, assuming " << size.width << "x" << size.height << std::endl;
+        imageSize = size;
+    }
+    else if (std::fabs(static_cast<double>(size.width) / size.height - static_cast<double>(imageSize.width) / imageSize.height) > 0.01)
+    {
+        std::cerr << "Warning: " << size.width << "x" << size.height << " has a different aspect ratio than the calibrated "
+                  << imageSize.width << "x" << imageSize.height << "; intrinsics are only valid if the frames are scaled, not cropped" << std::endl;
+    }
+
+    ResolutionIntrinsics &entry = derived[{size.width, size.height}];
+    entry.size = size;
+    entry.cameraMatrix = scaledCameraMatrix(size);
+    Renderer::buildProjectionMatrix(entry.cameraMatrix, size.width, size.height, entry.projection);
+    cv::initUndistortRectifyMap(entry.cameraMatrix, distCoeffs, cv::Mat(), entry.cameraMatrix,
+                                size, CV_16SC2, entry.map1, entry.map2);
+    appendSidecar(entry);
+    return entry;
+}
+
+bool CalibrationStore::loadSidecar()
+{
+    std::ifstream in(sidecarPath, std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[sizeof(kMagic)];
+    SourceStamp stamp;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !readValue(in, stamp.fileSize) || !readValue(in, stamp.mtime) || !(stamp == stampOf(jsonPath)))
+        return false; // Not ours, or calibration.json changed since
+
+    // Anything unexpected falls back to calibration.json, which rewrites the sidecar
+    std::int32_t width = 0, height = 0;
+    if (!readValue(in, width) || !readValue(in, height) || width < 0 || height < 0 || width > kMaxSide || height > kMaxSide ||
+        !readMat(in, cameraMatrix, CV_64FC1, 3, 3) || cameraMatrix.size() != cv::Size(3, 3) ||
+        !readMat(in, distCoeffs, CV_64FC1, kMaxDistCoeffs, kMaxDistCoeffs) || (distCoeffs.rows != 1 && distCoeffs.cols != 1))
+        return false;
+    imageSize = cv::Size(width, height);
+
+    // Resolutions follow until the end of the file, in the order they were first used
+    while (in.peek() != std::char_traits<char>::eof())
+    {
+        // The maps cover exactly the frame size of their entry
+        ResolutionIntrinsics entry;
+        if (!readValue(in, width) || !readValue(in, height) || width <= 0 || height <= 0 || width > kMaxSide || height > kMaxSide ||
+            !readMat(in, entry.cameraMatrix, CV_64FC1, 3, 3) || entry.cameraMatrix.size() != cv::Size(3, 3) ||
+            !in.read(reinterpret_cast<char *>(entry.projection), sizeof(entry.projection)) ||
+            !readMat(in, entry.map1, CV_16SC2, height, width) || entry.map1.size() != cv::Size(width, height) ||
+            !readMat(in, entry.map2, CV_16UC1, height, width) || entry.map2.size() != cv::Size(width, height))
+        {
+            derived.clear();
+            return false;
+        }
+        entry.size = cv::Size(width, height);
+        derived[{width, height}] = std::move(entry);
+    }
+    return !cameraMatrix.empty() && !distCoeffs.empty();
+}
+
+bool CalibrationStore::saveSidecar() const
+{
+    // Write to a temporary file first so a crash never leaves a truncated sidecar behind; named
+    // per process and call, so two processes rebuilding the same sidecar do not share it
+    static std::atomic<unsigned> counter{0};
+    const std::filesystem::path temporary = std::filesystem::path(sidecarPath).concat(
+        ".tmp" + std::to_string(::getpid()) + "_" + std::to_string(counter.fetch_add(1)));
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        const SourceStamp stamp = stampOf(jsonPath);
+        out.write(kMagic, sizeof(kMagic));
+        writeValue(out, stamp.fileSize);
+        writeValue(out, stamp.mtime);
+        writeValue(out, static_cast<std::int32_t>(imageSize.width));
+        writeValue(out, static_cast<std::int32_t>(imageSize.height));
+        writeMat(out, cameraMatrix);
+        writeMat(out, distCoeffs);
+        for (const auto &item : derived)
+            writeEntry(out, item.second);
+        if (!out)
+            return false;
+    }
+    std::error_code error, ignored;
+    std::filesystem::rename(temporary, sidecarPath, error);
+    if (error)
+        std::filesystem::remove(temporary, ignored);
+    return !error;
+}
+
+bool CalibrationStore::appendSidecar(const ResolutionIntrinsics &entry) const
+{
+    // Only ever extend a sidecar that belongs to the loaded calibration.json
+    if (!sidecarReady)
+        return false;
+    std::ostringstream bytes;
+    writeEntry(bytes, entry);
+    return appendBytes(sidecarPath, bytes.str());
+}
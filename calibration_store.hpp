@@ -0,0 +1,45 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <map>
+#include <utility>
+
+// Everything derived from the calibration for one frame resolution
+struct ResolutionIntrinsics
+{
+    cv::Size size;          // Frame size these belong to
+    cv::Mat cameraMatrix;   // Intrinsics rescaled from the calibrated resolution
+    float projection[16];   // OpenGL projection for a viewport of this size
+    cv::Mat map1, map2;     // Undistortion maps (CV_16SC2 / CV_16UC1) for cv::remap
+};
+
+// Camera calibration usable at any capture or processing resolution
+// calibration.json stays the source of truth; what was parsed and derived from it is kept in a
+// binary sidecar (calibration.cache) that is reused as long as the JSON file is unchanged, so
+// startup neither parses JSON nor rebuilds undistortion maps. The sidecar is only rewritten when
+// calibration.json changed; a newly used resolution is appended to it.
+class CalibrationStore
+{
+public:
+    // Load calibration.json, through the sidecar when it is up to date
+    bool load(const std::filesystem::path &calibrationJson);
+
+    // Intrinsics, projection and undistortion maps for frames of the given size
+    // Derived on first use and appended to the sidecar
+    const ResolutionIntrinsics &at(cv::Size size);
+
+    // Camera matrix rescaled from the calibrated resolution to size
+    cv::Mat scaledCameraMatrix(cv::Size size) const;
+
+    cv::Mat cameraMatrix, distCoeffs; // As calibrated
+    cv::Size imageSize;               // Calibrated resolution (empty for files written before it was recorded)
+
+private:
+    bool loadSidecar();
+    bool saveSidecar() const;                                    // Header and every derived resolution
+    bool appendSidecar(const ResolutionIntrinsics &entry) const; // One more resolution
+
+    std::filesystem::path jsonPath, sidecarPath;
+    bool sidecarReady = false; // The sidecar on disk matches calibration.json and can be appended to
+    std::map<std::pair<int, int>, ResolutionIntrinsics> derived; // Keyed by (width, height)
+};
@@ -1,6 +1,10 @@
 #include "calibrator.hpp"
+#include "artifact_writer.hpp"
+#include "calibration_engine.hpp"
+#include "view_selector.hpp"
+#include <algorithm>
 #include <filesystem>
-#include <fstream>
+#include <memory>
 #include <nlohmann/json.hpp>
 
 // Checkerboard pattern detection flags
@@ -32,19 +36,21 @@ nlohmann::json matToJson(const cv::Mat &mat)
 void saveCalibrationData(const std::filesystem::path &dir,
                          const cv::Mat &cameraMatrix,
                          const cv::Mat &distCoeffs,
-                         double reprojectionError)
+                         double reprojectionError,
+                         cv::Size imageSize)
 {
     std::filesystem::create_directories(dir);
     nlohmann::json j;
     j["reprojection_error"] = reprojectionError;
+    if (!imageSize.empty())
+    {
+        j["image_size"] = {imageSize.width, imageSize.height};
+    }
     j["camera_matrix"] = matToJson(cameraMatrix);
     j["distortion_coefficients"] = matToJson(distCoeffs);
 
-    std::ofstream out(dir / "calibration.json");
-    if (out)
-    {
-        out << j.dump(4);
-    }
+    // Durable before returning: CalibrationStore and the other tools pick it up right away
+    writeFileDurable(dir / "calibration.json", j.dump(4));
 }
 
 // Helper to convert pattern size to string
@@ -53,17 +59,24 @@ std::string patternSizeToString(const cv::Size &patternSize)
     return std::to_string(patternSize.width) + "x" + std::to_string(patternSize.height);
 }
 
-// Draw calibration status on frame
-void drawStatus(cv::Mat &frame, int saved, int kRequiredSamples)
+// Draw calibration status on frame (rms < 0 = no intermediate solution yet)
+// coverage < 0 = manual capture
+void drawStatus(cv::Mat &frame, int saved, int kRequiredSamples, double rms, double coverage)
 {
-    const std::string status = "Samples: " + std::to_string(saved) + " / " + std::to_string(kRequiredSamples);
+    std::string status = "Samples: " + std::to_string(saved) + " / " + std::to_string(kRequiredSamples);
+    if (rms >= 0.0)
+        status += "  RMS: " + cv::format("%.3f", rms);
+    if (coverage >= 0.0)
+        status += "  Coverage: " + cv::format("%.0f%%", coverage * 100.0);
     cv::putText(frame, status, {10, 25}, cv::FONT_HERSHEY_SIMPLEX, 0.7, {0, 255, 0}, 2);
-    cv::putText(frame, "Space = save, ESC/q = cancel", {10, 55}, cv::FONT_HERSHEY_SIMPLEX, 0.6, {0, 255, 255}, 1);
+    const std::string hint = coverage >= 0.0 ? "Move and tilt the board, ESC/q = finish" : "Space = save, ESC/q = cancel";
+    cv::putText(frame, hint, {10, 55}, cv::FONT_HERSHEY_SIMPLEX, 0.6, {0, 255, 255}, 1);
 }
 
 // Main calibration function
 void calibrateCamera(cv::VideoCapture &capture, int requiredSamples,
-                     const std::string &outputDir, cv::Size patternSize, float squareSize)
+                     const std::string &outputDir, cv::Size patternSize, float squareSize,
+                     bool autoSelect)
 {
     // Setup storage directories
     const std::filesystem::path storageDir = kBaseDataDir / outputDir / patternSizeToString(patternSize);
@@ -78,22 +91,22 @@ void calibrateCamera(cv::VideoCapture &capture, int requiredSamples,
         return;
     }
 
-    // calculate object points
-    std::vector<cv::Point3f> templatePoints;
-    for (int i = 0; i < patternSize.height; i++)
-    {
-        for (int j = 0; j < patternSize.width; j++)
-        {
-            templatePoints.push_back(cv::Point3f(j * squareSize, i * squareSize, 0));
-        }
-    }
+    // Calibration engine (board points, warm-started re-solves, per-view errors)
+    CalibrationEngineOptions engineOptions;
+    engineOptions.patternSize = patternSize;
+    engineOptions.squareSize = squareSize;
+    CalibrationEngine engine(engineOptions);
+    // View selector for auto-capture (bounded to requiredSamples views)
+    ViewSelectorOptions selectorOptions;
+    selectorOptions.maxViews = requiredSamples;
+    selectorOptions.minViews = std::min(selectorOptions.minViews, requiredSamples);
+    std::unique_ptr<ViewSelector> selector;
+
+    // Calibration images are encoded and written in the background, off the preview loop
+    ArtifactWriter writer;
 
     // Storage for captured points
     std::vector<cv::Point2f> imagePoints;
-    // All points for all images
-    std::vector<std::vector<cv::Point2f>> allImagePoints;
-    // Corresponding object points
-    std::vector<std::vector<cv::Point3f>> allObjectPoints;
     // Captured samples counter
     int collectedSamples = 0;
 
@@ -104,7 +117,7 @@ void calibrateCamera(cv::VideoCapture &capture, int requiredSamples,
     cv::Mat gray;
 
     // Capture loop
-    while (collectedSamples < requiredSamples)
+    while (autoSelect || collectedSamples < requiredSamples)
     {
         // Capture frame
         capture >> frame;
@@ -116,29 +129,60 @@ void calibrateCamera(cv::VideoCapture &capture, int requiredSamples,
         // Convert to grayscale
         cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
 
-        // Find chessboard corners
-        const bool found = findChessboardCorners(gray, patternSize, imagePoints, cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE);
+        // Find chessboard corners (fast check keeps the preview responsive when no board is visible)
+        const bool found = findChessboardCorners(gray, patternSize, imagePoints, cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_FAST_CHECK);
+        if (autoSelect && found)
+        {
+            if (!selector)
+                selector = std::make_unique<ViewSelector>(selectorOptions, gray.size(), patternSize, squareSize);
+            // Score against the partial intrinsics once there are any
+            cv::TermCriteria criteria(cv::TermCriteria::EPS | cv::TermCriteria::MAX_ITER, 30, 0.001);
+            cv::cornerSubPix(gray, imagePoints, cv::Size(11, 11), cv::Size(-1, -1), criteria);
+            CalibrationView view;
+            view.corners = imagePoints;
+            if (selector->offer(view, frame, engine.cameraMatrix, engine.distCoeffs))
+            {
+                // Re-solve over the pool; kept views were chosen to be well conditioned, so this stays small
+                collectedSamples = static_cast<int>(selector->views().size());
+                std::vector<CalibrationView> pool;
+                for (const auto &selected : selector->views())
+                    pool.push_back(selected.view);
+                engine.imageSize = gray.size();
+                engine.setViews(std::move(pool));
+                if (collectedSamples >= 4)
+                    engine.solve();
+            }
+        }
+
         // Draw status
-        drawStatus(frame, collectedSamples, requiredSamples);
+        const double coverage = !autoSelect ? -1.0 : selector ? selector->coverage() : 0.0;
+        drawStatus(frame, collectedSamples, requiredSamples, engine.solved() ? engine.rms : -1.0, coverage);
         // Draw found corners
         cv::drawChessboardCorners(frame, patternSize, imagePoints, found);
         // Show frame
         cv::imshow(kWindowName, frame);
 
-        const int key = cv::waitKey(30);
-        if (found && (key == 32)) // Space key
+        const int key = cv::waitKey(autoSelect ? 1 : 30);
+        if (autoSelect && selector && selector->done())
+            break;
+        if (!autoSelect && found && (key == 32)) // Space key
         {
             // Refine corner locations
             cv::TermCriteria criteria(cv::TermCriteria::EPS | cv::TermCriteria::MAX_ITER, 30, 0.001);
             // Refine the corner locations to sub-pixel accuracy
             cv::cornerSubPix(gray, imagePoints, cv::Size(11, 11), cv::Size(-1, -1), criteria);
-            // Store points
-            allImagePoints.push_back(imagePoints);
-            allObjectPoints.push_back(templatePoints);
             // Increment sample count
             collectedSamples++;
             // Optionally save the calibration image
-            cv::imwrite((imageDir / ("capture_" + std::to_string(collectedSamples) + ".png")).string(), frame);
+            const std::filesystem::path imagePath = imageDir / ("capture_" + std::to_string(collectedSamples) + ".png");
+            writer.writeImage(imagePath, std::move(frame)); // The next capture fills a new buffer
+            // Store points and re-solve, starting from the previous intrinsics
+            CalibrationView view;
+            view.image = imagePath;
+            view.corners = imagePoints;
+            engine.imageSize = gray.size();
+            engine.addView(view);
+            engine.solve();
         }
 
         if (key == 27 || key == 'q') // ESC or q
@@ -148,23 +192,43 @@ void calibrateCamera(cv::VideoCapture &capture, int requiredSamples,
     }
     // Destroy the calibration window
     cv::destroyWindow(kWindowName);
-    // Calibration logic would go here (not implemented for brevity)
-    std::cout << "\nCalibrating camera... Please wait." << std::endl;
-    // Calibration results
-    cv::Mat cameraMatrix, distCoeffs, R, T;
 
-    // Perform camera calibration
-    double reprojectionError = cv::calibrateCamera(allObjectPoints, allImagePoints, gray.size(), cameraMatrix, distCoeffs, R, T);
+    // Auto-capture: only the kept views are written out, followed by a final solve
+    if (selector)
+    {
+        std::vector<CalibrationView> pool;
+        for (const auto &selected : selector->views())
+        {
+            CalibrationView view = selected.view;
+            view.image = imageDir / ("capture_" + std::to_string(pool.size() + 1) + ".png");
+            writer.writeImage(view.image, selected.frame); // Shares the selector's buffer, which is no longer written
+            pool.push_back(std::move(view));
+        }
+        engine.setViews(std::move(pool));
+    }
+    // Every image is on disk before the final calibration and the saved results refer to them
+    if (!writer.flush())
+        std::cerr << "Some calibration images could not be saved." << std::endl;
+    if (selector)
+        engine.solve();
+    // The engine re-solved after every sample, so this is already the final solution
+    if (!engine.solved())
+    {
+        std::cerr << "Not enough samples to calibrate." << std::endl;
+        return;
+    }
 
     std::cout << "Calibration finished!" << std::endl;
-    std::cout << "Reprojection Error: " << reprojectionError << std::endl;
+    std::cout << "Reprojection Error: " << engine.rms << std::endl;
     std::cout << "Camera Matrix: \n"
-              << cameraMatrix << std::endl;
+              << engine.cameraMatrix << std::endl;
     std::cout << "Distortion Coefficients: \n"
-              << distCoeffs << std::endl;
+              << engine.distCoeffs << std::endl;
+    for (const auto &view : engine.views())
+        std::cout << view.image.filename().string() << ": " << view.error << " px" << std::endl;
 
-    // Save calibration results
-    saveCalibrationData(storageDir, cameraMatrix, distCoeffs, reprojectionError);
+    // Save calibration results (calibration.json and per-view errors)
+    engine.save(storageDir);
 }
 
 void captureReferenceImage(cv::VideoCapture &capture,
@@ -183,6 +247,7 @@ void captureReferenceImage(cv::VideoCapture &capture,
         return;
     }
     std::string windowName = "Capture Reference Image";
+    ArtifactWriter writer;
     cv::namedWindow(windowName, cv::WINDOW_AUTOSIZE);
 
     cv::Mat frame;
@@ -200,8 +265,10 @@ void captureReferenceImage(cv::VideoCapture &capture,
         if (key == 32) // Space key
         {
             std::filesystem::path outPath = std::filesystem::path(outputDir) / "reference.png";
-            cv::imwrite(outPath.string(), frame);
-            std::cout << "Reference image saved to " << outPath << std::endl;
+            writer.writeImage(outPath, std::move(frame));
+            // The tracker loads it as soon as this returns
+            if (writer.flush())
+                std::cout << "Reference image saved to " << outPath << std::endl;
             break;
         }
 
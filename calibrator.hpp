@@ -1,9 +1,22 @@
+#pragma once
 #include <opencv2/opencv.hpp>
+#include <filesystem>
 
 // Calibrate camera using checkerboard pattern
+// With autoSelect, informative frames are captured automatically (see ViewSelector) and
+// requiredSamples bounds the view pool instead of counting space presses
 void calibrateCamera(cv::VideoCapture &capture, int requiredSamples = 15,
-                     const std::string &outputDir = "calibration_images", cv::Size patternSize = cv::Size(8, 6), float squareSize = 25.0f);
+                     const std::string &outputDir = "calibration_images", cv::Size patternSize = cv::Size(8, 6), float squareSize = 25.0f,
+                     bool autoSelect = false);
 
 // Capture reference image for NFT tracking
 void captureReferenceImage(cv::VideoCapture &capture,
-                           const std::string &outputDir);
\ No newline at end of file
+                           const std::string &outputDir);
+
+// Save calibration data to <dir>/calibration.json
+// imageSize is the resolution the calibration images had (lets CalibrationStore rescale the intrinsics)
+void saveCalibrationData(const std::filesystem::path &dir,
+                         const cv::Mat &cameraMatrix,
+                         const cv::Mat &distCoeffs,
+                         double reprojectionError,
+                         cv::Size imageSize = cv::Size());
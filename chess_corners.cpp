@@ -0,0 +1,549 @@
+#include "chess_corners.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace
+{
+    constexpr int kRadius = 5;     // Sampling ring radius, also the border without a response
+    constexpr int kBucketSize = 16; // Cell size of the candidate hash in pixels
+
+    // ChESS response of one row, scaled by 9 so the 3x3 local mean stays an integer:
+    // 9 * (sum response - diff response) - |9 * ring sum - 16 * 3x3 sum|
+    // Ring samples n = 0..15 run clockwise from (5, 0); n and n + 8 are opposite.
+    inline void responseRow(const uchar *__restrict m5, const uchar *__restrict m4, const uchar *__restrict m2,
+                            const uchar *__restrict m1, const uchar *__restrict r0, const uchar *__restrict p1,
+                            const uchar *__restrict p2, const uchar *__restrict p4, const uchar *__restrict p5,
+                            int *__restrict out, int begin, int end)
+    {
+        for (int x = begin; x < end; ++x)
+        {
+            const int i0 = r0[x + 5], i1 = p2[x + 5], i2 = p4[x + 4], i3 = p5[x + 2];
+            const int i4 = p5[x], i5 = p5[x - 2], i6 = p4[x - 4], i7 = p2[x - 5];
+            const int i8 = r0[x - 5], i9 = m2[x - 5], i10 = m4[x - 4], i11 = m5[x - 2];
+            const int i12 = m5[x], i13 = m5[x + 2], i14 = m4[x + 4], i15 = m2[x + 5];
+
+            const int sum = std::abs(i0 + i8 - i4 - i12) + std::abs(i1 + i9 - i5 - i13) +
+                            std::abs(i2 + i10 - i6 - i14) + std::abs(i3 + i11 - i7 - i15);
+            const int diff = std::abs(i0 - i8) + std::abs(i1 - i9) + std::abs(i2 - i10) + std::abs(i3 - i11) +
+                             std::abs(i4 - i12) + std::abs(i5 - i13) + std::abs(i6 - i14) + std::abs(i7 - i15);
+            const int ring = i0 + i1 + i2 + i3 + i4 + i5 + i6 + i7 + i8 + i9 + i10 + i11 + i12 + i13 + i14 + i15;
+            const int local = m1[x - 1] + m1[x] + m1[x + 1] + r0[x - 1] + r0[x] + r0[x + 1] + p1[x - 1] + p1[x] + p1[x + 1];
+            out[x] = 9 * (sum - diff) - std::abs(9 * ring - 16 * local);
+        }
+    }
+
+    // Mean grey level of the 3x3 block around p (clamped to the image)
+    int sampleMean(const cv::Mat &gray, cv::Point2f p)
+    {
+        const int cx = std::min(std::max(cvRound(p.x), 1), gray.cols - 2);
+        const int cy = std::min(std::max(cvRound(p.y), 1), gray.rows - 2);
+        int total = 0;
+        for (int y = cy - 1; y <= cy + 1; ++y)
+        {
+            const uchar *row = gray.ptr<uchar>(y);
+            total += row[cx - 1] + row[cx] + row[cx + 1];
+        }
+        return total / 9;
+    }
+
+    // Ring samples as (dx, dy) and the doubled-angle weights of the phase
+    constexpr int kRing[16][2] = {{5, 0}, {5, 2}, {4, 4}, {2, 5}, {0, 5}, {-2, 5}, {-4, 4}, {-5, 2},
+                                  {-5, 0}, {-5, -2}, {-4, -4}, {-2, -5}, {0, -5}, {2, -5}, {4, -4}, {5, -2}};
+    constexpr float kCos2[8] = {1.0f, 0.7071f, 0.0f, -0.7071f, -1.0f, -0.7071f, 0.0f, 0.7071f};
+    constexpr float kSin2[8] = {0.0f, 0.7071f, 1.0f, 0.7071f, 0.0f, -0.7071f, -1.0f, -0.7071f};
+
+    // Second angular harmonic of the ring around (x, y): points along the dark quadrants of a saddle,
+    // so it changes sign from one board corner to the next
+    cv::Point2f ringPhase(const cv::Mat &gray, int x, int y)
+    {
+        float c = 0.0f, s = 0.0f;
+        for (int n = 0; n < 16; ++n)
+        {
+            const float v = gray.ptr<uchar>(y + kRing[n][1])[x + kRing[n][0]];
+            c += v * kCos2[n % 8];
+            s += v * kSin2[n % 8];
+        }
+        return cv::Point2f(c, s);
+    }
+
+    float length(cv::Point2f v)
+    {
+        return std::sqrt(v.x * v.x + v.y * v.y);
+    }
+}
+
+ChessCornerDetector::ChessCornerDetector(const ChessCornerOptions &options, ThreadPool *pool)
+    : options(options), pool(pool)
+{
+}
+
+int ChessCornerDetector::computeResponse(const cv::Mat &gray)
+{
+    const int width = gray.cols, height = gray.rows;
+    responseMap.create(height, width, CV_32SC1);
+    std::mutex mutex;
+    int maxResponse = 0;
+
+    auto body = [&](int begin, int end)
+    {
+        int bandMax = 0;
+        for (int y = begin; y < end; ++y)
+        {
+            int *out = responseMap.ptr<int>(y);
+            if (y < kRadius || y >= height - kRadius)
+            {
+                std::fill(out, out + width, 0);
+                continue;
+            }
+            responseRow(gray.ptr<uchar>(y - 5), gray.ptr<uchar>(y - 4), gray.ptr<uchar>(y - 2),
+                        gray.ptr<uchar>(y - 1), gray.ptr<uchar>(y), gray.ptr<uchar>(y + 1),
+                        gray.ptr<uchar>(y + 2), gray.ptr<uchar>(y + 4), gray.ptr<uchar>(y + 5),
+                        out, kRadius, width - kRadius);
+            std::fill(out, out + kRadius, 0);
+            std::fill(out + width - kRadius, out + width, 0);
+            bandMax = std::max(bandMax, *std::max_element(out, out + width));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        maxResponse = std::max(maxResponse, bandMax);
+    };
+
+    if (pool)
+        pool->parallelFor(0, height, body, std::max(16, height / (4 * static_cast<int>(pool->size() + 1))));
+    else
+        body(0, height);
+    return maxResponse;
+}
+
+void ChessCornerDetector::collectCandidates(const cv::Mat &gray, int threshold, int keep)
+{
+    const int width = responseMap.cols, height = responseMap.rows;
+    const int radius = std::min(std::max(options.suppressionRadius, 1), kRadius);
+    candidates.clear();
+    std::mutex mutex;
+
+    auto body = [&](int begin, int end)
+    {
+        std::vector<Candidate> band;
+        for (int y = begin; y < end; ++y)
+        {
+            const int *row = responseMap.ptr<int>(y);
+            for (int x = kRadius; x < width - kRadius; ++x)
+            {
+                const int v = row[x];
+                if (v <= threshold)
+                    continue;
+                // Strict maximum; ties go to the first pixel in raster order
+                bool isMax = true;
+                for (int dy = -radius; dy <= radius && isMax; ++dy)
+                {
+                    const int *other = responseMap.ptr<int>(y + dy);
+                    for (int dx = -radius; dx <= radius; ++dx)
+                    {
+                        const int w = other[x + dx];
+                        if (w > v || (w == v && (dy < 0 || (dy == 0 && dx < 0))))
+                        {
+                            isMax = false;
+                            break;
+                        }
+                    }
+                }
+                if (!isMax)
+                    continue;
+
+                // Sub-pixel position from the positive response around the maximum
+                float sx = 0.0f, sy = 0.0f, sw = 0.0f;
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    const int *other = responseMap.ptr<int>(y + dy);
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        const float w = static_cast<float>(std::max(other[x + dx], 0));
+                        sx += w * dx;
+                        sy += w * dy;
+                        sw += w;
+                    }
+                }
+                Candidate c;
+                c.pt = cv::Point2f(x + sx / sw, y + sy / sw);
+                c.response = v;
+                band.push_back(c);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        candidates.insert(candidates.end(), band.begin(), band.end());
+    };
+
+    if (pool)
+        pool->parallelFor(kRadius, height - kRadius, body, std::max(16, height / (4 * static_cast<int>(pool->size() + 1))));
+    else
+        body(kRadius, height - kRadius);
+
+    // Bands finish in any order; sorting by position as well keeps the result deterministic
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+              {
+                  if (a.response != b.response)
+                      return a.response > b.response;
+                  return a.pt.y != b.pt.y ? a.pt.y < b.pt.y : a.pt.x < b.pt.x; });
+    if (static_cast<int>(candidates.size()) > keep)
+        candidates.resize(keep);
+    for (auto &c : candidates)
+        c.phase = ringPhase(gray, cvRound(c.pt.x), cvRound(c.pt.y));
+}
+
+void ChessCornerDetector::buildBuckets(cv::Size size)
+{
+    bucketCols = (size.width + kBucketSize - 1) / kBucketSize;
+    bucketRows = (size.height + kBucketSize - 1) / kBucketSize;
+    bucketStart.assign(bucketCols * bucketRows + 1, 0);
+    bucketItems.resize(candidates.size());
+
+    // Counting sort of the candidates by bucket
+    auto bucketOf = [&](const Candidate &c)
+    {
+        const int bx = std::min(static_cast<int>(c.pt.x) / kBucketSize, bucketCols - 1);
+        const int by = std::min(static_cast<int>(c.pt.y) / kBucketSize, bucketRows - 1);
+        return by * bucketCols + bx;
+    };
+    for (const auto &c : candidates)
+        bucketStart[bucketOf(c) + 1]++;
+    for (size_t b = 1; b < bucketStart.size(); ++b)
+        bucketStart[b] += bucketStart[b - 1];
+    std::vector<int> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (int i = 0; i < static_cast<int>(candidates.size()); ++i)
+        bucketItems[fill[bucketOf(candidates[i])]++] = i;
+}
+
+int ChessCornerDetector::nearestFree(cv::Point2f p, float radius, cv::Point2f phase, int minResponse) const
+{
+    const int bx0 = std::max(static_cast<int>(std::floor((p.x - radius) / kBucketSize)), 0);
+    const int by0 = std::max(static_cast<int>(std::floor((p.y - radius) / kBucketSize)), 0);
+    const int bx1 = std::min(static_cast<int>(std::floor((p.x + radius) / kBucketSize)), bucketCols - 1);
+    const int by1 = std::min(static_cast<int>(std::floor((p.y + radius) / kBucketSize)), bucketRows - 1);
+
+    int best = -1;
+    const float limit = radius * radius;
+    for (int by = by0; by <= by1; ++by)
+    {
+        for (int bx = bx0; bx <= bx1; ++bx)
+        {
+            const int b = by * bucketCols + bx;
+            for (int k = bucketStart[b]; k < bucketStart[b + 1]; ++k)
+            {
+                const int i = bucketItems[k];
+                if (used[i] || candidates[i].response < minResponse || candidates[i].phase.dot(phase) <= 0.0f)
+                    continue;
+                const cv::Point2f d = candidates[i].pt - p;
+                if (d.x * d.x + d.y * d.y <= limit && (best < 0 || candidates[i].response > candidates[best].response))
+                    best = i;
+            }
+        }
+    }
+    return best;
+}
+
+bool ChessCornerDetector::growGrid(int seed, cv::Size patternSize, std::vector<int> &grid, int &rows, int &cols)
+{
+    const int count = static_cast<int>(candidates.size());
+    const cv::Point2f origin = candidates[seed].pt, phase = candidates[seed].phase;
+    used.assign(count, 0);
+
+    // Grid steps: the pair of near neighbours of opposite phase, roughly across each other, whose
+    // lattice around the seed is confirmed by the most candidates (stray responses next to a corner
+    // give pairs that nothing else lines up with)
+    std::vector<std::pair<float, int>> near;
+    for (int i = 0; i < count; ++i)
+    {
+        if (i != seed && candidates[i].phase.dot(phase) < 0.0f)
+            near.emplace_back(length(candidates[i].pt - origin), i);
+    }
+    const int nearCount = std::min(static_cast<int>(near.size()), 8);
+    std::partial_sort(near.begin(), near.begin() + nearCount, near.end());
+    cv::Point2f u, v;
+    int first = -1, second = -1, bestScore = 0;
+    float bestLength = 0.0f;
+    for (int a = 0; a < nearCount; ++a)
+    {
+        for (int b = a + 1; b < nearCount; ++b)
+        {
+            const cv::Point2f du = candidates[near[a].second].pt - origin, dv = candidates[near[b].second].pt - origin;
+            const float lu = near[a].first, lv = near[b].first;
+            if (lu < 2.0f || lv > 2.0f * lu || std::abs(du.dot(dv)) > 0.6f * lu * lv)
+                continue;
+            // Axis neighbours have the opposite phase, diagonal ones the seed's
+            const cv::Point2f lattice[6] = {-du, -dv, du + dv, du - dv, dv - du, -du - dv};
+            int score = 0;
+            for (int k = 0; k < 6; ++k)
+                score += nearestFree(origin + lattice[k], 0.25f * lu, k < 2 ? -phase : phase) >= 0;
+            if (score > bestScore || (score == bestScore && score > 0 && lu + lv < bestLength))
+            {
+                bestScore = score;
+                bestLength = lu + lv;
+                u = du;
+                v = dv;
+                first = near[a].second;
+                second = near[b].second;
+            }
+        }
+    }
+    if (bestScore == 0)
+        return false;
+
+    // Cells are indexed from the seed at the center; no board side is longer than maxSide
+    const int maxSide = std::max(patternSize.width, patternSize.height);
+    const int side = 2 * maxSide + 1;
+    std::vector<int> cells(side * side, -1);
+    auto at = [&](int i, int j)
+    {
+        return i < 0 || j < 0 || i >= side || j >= side ? -1 : cells[i * side + j];
+    };
+    auto place = [&](int i, int j, int index)
+    {
+        cells[i * side + j] = index;
+        used[index] = 1;
+    };
+    auto point = [&](int i, int j)
+    {
+        return candidates[at(i, j)].pt;
+    };
+
+    const int c = maxSide;
+    place(c, c, seed);
+    place(c, c + 1, first);
+    place(c + 1, c, second);
+    int iMin = c, iMax = c + 1, jMin = c, jMax = c + 1;
+
+    // Prediction of an empty cell: mean of the extrapolations along rows and columns (quadratic
+    // when three corners are known, which follows the shrinking steps of a tilted board) and of
+    // the parallelogram rule over complete neighbouring cells. The seed steps are only a fallback
+    // for cells with a single known neighbour. Returns the number of predictions averaged.
+    auto predict = [&](int i, int j, bool seedSteps, cv::Point2f &p, float &step)
+    {
+        cv::Point2f total(0.0f, 0.0f);
+        float steps = std::numeric_limits<float>::max();
+        int n = 0;
+        const int axis[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+        for (const auto &d : axis)
+        {
+            if (at(i + d[0], j + d[1]) < 0 || at(i + 2 * d[0], j + 2 * d[1]) < 0)
+                continue;
+            const cv::Point2f a = point(i + d[0], j + d[1]), b = point(i + 2 * d[0], j + 2 * d[1]);
+            if (at(i + 3 * d[0], j + 3 * d[1]) >= 0)
+                total += 3.0f * (a - b) + point(i + 3 * d[0], j + 3 * d[1]);
+            else
+                total += 2.0f * a - b;
+            steps = std::min(steps, length(a - b));
+            n++;
+        }
+        const int diagonal[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+        for (const auto &d : diagonal)
+        {
+            if (at(i + d[0], j) < 0 || at(i, j + d[1]) < 0 || at(i + d[0], j + d[1]) < 0)
+                continue;
+            const cv::Point2f a = point(i + d[0], j), b = point(i, j + d[1]), corner = point(i + d[0], j + d[1]);
+            total += a + b - corner;
+            steps = std::min(steps, std::min(length(a - corner), length(b - corner)));
+            n++;
+        }
+        if (n == 0 && seedSteps)
+        {
+            const cv::Point2f seedStep[4] = {u, -u, v, -v};
+            for (int k = 0; k < 4; ++k)
+            {
+                const auto &d = axis[k];
+                if (at(i + d[0], j + d[1]) < 0)
+                    continue;
+                total += point(i + d[0], j + d[1]) + seedStep[k];
+                steps = std::min(steps, length(seedStep[k]));
+                n++;
+            }
+        }
+        if (n > 0)
+        {
+            p = total / static_cast<float>(n);
+            step = steps;
+        }
+        return n;
+    };
+
+    // Sweeps over the cells around the grid until nothing is added. The best supported cells go
+    // first so that errors do not spread from cells known from a single direction, and cells that
+    // need the seed steps wait until everything else is exhausted.
+    constexpr int kMostSupport = 4;
+    int support = kMostSupport;
+    while (true)
+    {
+        bool changed = false;
+        for (int i = std::max(iMin - 1, 0); i <= std::min(iMax + 1, side - 1); ++i)
+        {
+            for (int j = std::max(jMin - 1, 0); j <= std::min(jMax + 1, side - 1); ++j)
+            {
+                cv::Point2f p;
+                float step = 0.0f;
+                if (at(i, j) >= 0 || predict(i, j, support == 0, p, step) < std::max(support, 1))
+                    continue;
+                // A board corner has the opposite phase of its row and column neighbours and about
+                // their contrast; the L-junctions around the board are much weaker
+                cv::Point2f expected(0.0f, 0.0f);
+                int neighbours = 0, strength = 0;
+                for (const auto &d : {cv::Point(0, -1), cv::Point(0, 1), cv::Point(-1, 0), cv::Point(1, 0)})
+                {
+                    const int k = at(i + d.y, j + d.x);
+                    if (k < 0)
+                        continue;
+                    expected = expected - candidates[k].phase;
+                    strength += candidates[k].response;
+                    neighbours++;
+                }
+                const int minResponse = static_cast<int>(options.minNeighbourResponse * strength / neighbours);
+                const int index = nearestFree(p, options.searchRadius * step, expected, minResponse);
+                if (index < 0)
+                    continue;
+                place(i, j, index);
+                iMin = std::min(iMin, i);
+                iMax = std::max(iMax, i);
+                jMin = std::min(jMin, j);
+                jMax = std::max(jMax, j);
+                changed = true;
+                // Longer than any board side: clutter lined up with the board, or the wrong board
+                if (iMax - iMin + 1 > maxSide || jMax - jMin + 1 > maxSide)
+                    return false;
+            }
+        }
+        if (changed)
+            support = kMostSupport;
+        else if (support > 0)
+            support--;
+        else
+            break;
+    }
+
+    rows = iMax - iMin + 1;
+    cols = jMax - jMin + 1;
+    const bool sizeMatches = (rows == patternSize.height && cols == patternSize.width) ||
+                             (rows == patternSize.width && cols == patternSize.height);
+    if (!sizeMatches)
+        return false;
+
+    // A few corners without a candidate (glare, a cable across the board, a very oblique view
+    // squashing the quadrants) are placed where their neighbours predict them; sub-pixel
+    // refinement moves them onto the corner. Only holes predicted from two directions are filled.
+    int holes = 0;
+    for (int i = iMin; i <= iMax; ++i)
+        for (int j = jMin; j <= jMax; ++j)
+            holes += at(i, j) < 0;
+    if (holes > static_cast<int>(std::ceil(options.maxPredicted * patternSize.area())))
+        return false;
+    while (holes > 0)
+    {
+        int filled = 0;
+        for (int i = iMin; i <= iMax; ++i)
+        {
+            for (int j = jMin; j <= jMax; ++j)
+            {
+                cv::Point2f p;
+                float step = 0.0f;
+                if (at(i, j) >= 0 || predict(i, j, false, p, step) < 2)
+                    continue;
+                Candidate predicted;
+                predicted.pt = p;
+                candidates.push_back(predicted);
+                used.push_back(0);
+                place(i, j, static_cast<int>(candidates.size()) - 1);
+                filled++;
+            }
+        }
+        if (filled == 0)
+            return false;
+        holes -= filled;
+    }
+
+    grid.resize(rows * cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            grid[i * cols + j] = at(iMin + i, jMin + j);
+    return true;
+}
+
+bool ChessCornerDetector::orderGrid(const cv::Mat &gray, const std::vector<int> &grid, int rows, int cols, cv::Size patternSize,
+                                    std::vector<cv::Point2f> &corners) const
+{
+    const int width = patternSize.width, height = patternSize.height;
+    const bool symmetric = (width + height) % 2 == 0; // Same colours at opposite board corners
+    int chosen = -1;
+    for (int t = 0; t < 8 && chosen < 0; ++t)
+    {
+        // Transpose and flips of the grown grid; the first one that gives cv::findChessboardCorners order
+        const bool transpose = t & 4, flipRows = t & 2, flipCols = t & 1;
+        if ((transpose ? cols : rows) != height || (transpose ? rows : cols) != width)
+            continue;
+        auto corner = [&](int r, int c)
+        {
+            if (flipRows)
+                r = height - 1 - r;
+            if (flipCols)
+                c = width - 1 - c;
+            return transpose ? candidates[grid[c * cols + r]].pt : candidates[grid[r * cols + c]].pt;
+        };
+
+        // Rows advance clockwise from the first row (image y points down)
+        const cv::Point2f p0 = corner(0, 0), rowDir = corner(0, width - 1) - p0, colDir = corner(height - 1, 0) - p0;
+        if (rowDir.x * colDir.y - rowDir.y * colDir.x <= 0.0f)
+            continue;
+        if (symmetric)
+        {
+            // cv::findChessboardCorners puts the first row on top when the board does not tell
+            if (colDir.y < 0.0f)
+                continue;
+        }
+        else
+        {
+            // The first corner touches a black corner square; its inner diagonal square has the
+            // same colour and is darker than the next square along the row
+            const cv::Point2f right = corner(0, 1) - p0, down = corner(1, 0) - p0;
+            const cv::Point2f inner = p0 + 0.5f * (right + down);
+            if (sampleMean(gray, inner) >= sampleMean(gray, inner + right))
+                continue;
+        }
+
+        chosen = t;
+        corners.resize(width * height);
+        for (int r = 0; r < height; ++r)
+            for (int c = 0; c < width; ++c)
+                corners[r * width + c] = corner(r, c);
+    }
+    return chosen >= 0;
+}
+
+bool ChessCornerDetector::detect(const cv::Mat &gray, cv::Size patternSize, std::vector<cv::Point2f> &corners)
+{
+    corners.clear();
+    if (gray.empty() || gray.type() != CV_8UC1 || patternSize.width < 2 || patternSize.height < 2 ||
+        gray.rows <= 2 * kRadius || gray.cols <= 2 * kRadius)
+        return false;
+
+    const int maxResponse = computeResponse(gray);
+    if (maxResponse <= 0)
+        return false;
+    const int boardCorners = patternSize.area();
+    collectCandidates(gray, static_cast<int>(options.relativeThreshold * maxResponse),
+                      options.maxCandidates > 0 ? options.maxCandidates : 3 * boardCorners + 100);
+    if (static_cast<int>(candidates.size()) < boardCorners)
+        return false;
+    buildBuckets(gray.size());
+
+    // Board corners respond strongly, so a board is usually grown from the first seed
+    std::vector<int> grid;
+    int rows = 0, cols = 0;
+    const int found = static_cast<int>(candidates.size());
+    const int seeds = std::min(options.maxSeeds, found);
+    for (int seed = 0; seed < seeds; ++seed)
+    {
+        if (growGrid(seed, patternSize, grid, rows, cols) && orderGrid(gray, grid, rows, cols, patternSize, corners))
+            return true;
+        candidates.resize(found); // Drop the predicted corners of a failed attempt
+    }
+    corners.clear();
+    return false;
+}
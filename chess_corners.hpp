@@ -0,0 +1,75 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "thread_pool.hpp"
+
+// Settings of the ChESS chessboard detector
+struct ChessCornerOptions
+{
+    float relativeThreshold = 0.05f;   // Candidates respond above this fraction of the frame's strongest response
+    int suppressionRadius = 3;         // Non-maximum suppression window radius (at most 5)
+    int maxCandidates = 0;             // Strongest candidates kept for grid recovery (0 = 3 per board corner + 100)
+    int maxSeeds = 16;                 // Strongest candidates tried as the grid origin before giving up
+    float searchRadius = 0.3f;         // Match radius around a predicted corner, in local grid steps
+    float minNeighbourResponse = 0.3f; // A new corner responds at least this fraction of its known neighbours' mean
+    float maxPredicted = 0.04f;        // Fraction of the board corners that may be taken from the prediction when no candidate is found
+};
+
+// Chessboard corners from the ChESS saddle-point response (Bennett & Lasenby, 2014)
+// Every pixel is scored from 16 samples on a radius-5 ring: opposite samples of a saddle agree and
+// samples a quarter turn apart differ, edges and blobs are penalised, so the response peaks on
+// X-junctions only. The response is computed in row bands on the ThreadPool with branch-free integer
+// row loops the compiler vectorizes; the maxima above a fraction of the strongest response are the
+// candidates. The board is then grown from a seed candidate by predicting each next corner from
+// its already found neighbours, taking only candidates whose dark quadrants are turned by a quarter
+// against the neighbour's (as on a chessboard), and accepted only when exactly the configured grid
+// is filled.
+// Unlike cv::findChessboardCorners there is no thresholding, quad extraction or board-size search,
+// so the cost is one pass over the image plus a walk over the board.
+class ChessCornerDetector
+{
+public:
+    explicit ChessCornerDetector(const ChessCornerOptions &options = {}, ThreadPool *pool = &ThreadPool::shared());
+
+    // Inner corners of a patternSize board (8-bit grey image) in the order cv::findChessboardCorners
+    // returns them: row by row, the second row below the first in the image's handedness, the first
+    // corner next to a black corner square (boards that look the same turned by 180 degrees start
+    // at the top). Pixel accurate; refine with cv::cornerSubPix. False unless the whole board was found.
+    bool detect(const cv::Mat &gray, cv::Size patternSize, std::vector<cv::Point2f> &corners);
+
+    // Response of the last frame (CV_32S, 9 x the ChESS response)
+    const cv::Mat &response() const { return responseMap; }
+
+    ChessCornerOptions options;
+
+private:
+    struct Candidate
+    {
+        cv::Point2f pt;    // Response-weighted centroid of the maximum
+        int response = 0;
+        cv::Point2f phase; // Orientation of the dark quadrants, as a doubled angle; flips sign between neighbours
+    };
+
+    // Response over the whole frame; returns its maximum
+    int computeResponse(const cv::Mat &gray);
+    // Local maxima above threshold, strongest first
+    void collectCandidates(const cv::Mat &gray, int threshold, int keep);
+    // Spatial hash of the candidates for radius queries
+    void buildBuckets(cv::Size size);
+    // Strongest candidate not in use within radius of p whose phase agrees with the given one, -1 if none
+    int nearestFree(cv::Point2f p, float radius, cv::Point2f phase, int minResponse = 0) const;
+    // Grow a grid from candidate seed; on success grid holds rows x cols candidate indices
+    // (predicted corners are appended to candidates)
+    bool growGrid(int seed, cv::Size patternSize, std::vector<int> &grid, int &rows, int &cols);
+    // Corners of the grown grid in cv::findChessboardCorners order
+    bool orderGrid(const cv::Mat &gray, const std::vector<int> &grid, int rows, int cols, cv::Size patternSize,
+                   std::vector<cv::Point2f> &corners) const;
+
+    ThreadPool *pool;                  // nullptr = single-threaded
+    cv::Mat responseMap;               // Reused between frames
+    std::vector<Candidate> candidates;
+    std::vector<char> used;            // Candidate already placed in the grid being grown
+    std::vector<int> bucketStart;      // First entry of every bucket in bucketItems
+    std::vector<int> bucketItems;      // Candidate indices sorted by bucket
+    int bucketCols = 0, bucketRows = 0;
+};
@@ -1,4 +1,9 @@
+#pragma once
 #include "tracker.hpp"
+#include "chess_corners.hpp"
+#include "planar_pose.hpp"
+#include "temporal_pose.hpp"
+#include <chrono>
 
 // Implements pose estimation using a chessboard pattern
 class ChessboardTracker : public PoseTracker
@@ -9,8 +14,20 @@ class ChessboardTracker : public PoseTracker
 
 public:
     std::vector<cv::Point2f> lastCorners; // Last detected corners
+    // Planar solver (all corners are exact correspondences, no RANSAC needed)
+    PlanarPoseEstimator planar;
+    // Warm-started solver (every corner is used, so no inlier gating)
+    TemporalPoseSolver temporal;
+    // Find the board with the ChESS detector instead of cv::findChessboardCorners (same corner order)
+    bool chessCorners = false;
+    ChessCornerDetector chess;
     // Constructor
     ChessboardTracker(cv::Size size, float sqSize) : patternSize(size), squareSize(sqSize) {}
+
+    void setThreadPool(ThreadPool *pool) override
+    {
+        chess = ChessCornerDetector(chess.options, pool);
+    }
     // Initialize the tracker by preparing object points
     void init() override
     {
@@ -30,37 +47,114 @@ public:
         }
     }
 
+    // Sub-pixel refinement with the window and iteration count of the current quality level
+    void refineCorners(const cv::Mat &gray, std::vector<cv::Point2f> &corners) const
+    {
+        if (quality.subPixIterations <= 0)
+            return;
+        cv::cornerSubPix(gray, corners, cv::Size(quality.subPixWindow, quality.subPixWindow), cv::Size(-1, -1),
+                         cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, quality.subPixIterations, 0.1));
+    }
+
+    // Unrefined corners from the selected detector
+    bool findCorners(const cv::Mat &gray, std::vector<cv::Point2f> &corners)
+    {
+        if (chessCorners)
+            return chess.detect(gray, patternSize, corners);
+        return cv::findChessboardCorners(gray, patternSize, corners, cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
+    }
+
+    // Find and refine the chessboard corners in a grayscale frame
+    bool detectCorners(const cv::Mat &gray, std::vector<cv::Point2f> &corners)
+    {
+        bool found = findCorners(gray, corners);
+        if (!found)
+            return false;
+
+        // Refine corners (Sub-pixel)
+        refineCorners(gray, corners);
+        return true;
+    }
+
+    // Solve the pose from detected corners with the selected solver
+    // (every corner is an inlier, so there is nothing for a robust solver to do)
+    bool solvePose(const std::vector<cv::Point2f> &corners, const cv::Mat &camMat, const cv::Mat &dist, cv::Mat &rvec, cv::Mat &tvec)
+    {
+        auto solveStart = std::chrono::high_resolution_clock::now();
+        bool success = true;
+        lastDiagnostics.correspondences = static_cast<int>(corners.size());
+        lastDiagnostics.inliers = static_cast<int>(corners.size());
+
+        if (solver == PoseSolver::Planar)
+        {
+            PlanarPoseResult result = planar.estimate(objectPoints, corners, camMat, dist, rvec, tvec);
+            success = result.success;
+            lastDiagnostics.inliers = result.inliers;
+            lastDiagnostics.iterations = result.iterations;
+        }
+        else if (solver == PoseSolver::Temporal)
+        {
+            // Refine from the previous pose; solve from scratch on the first frame or on divergence
+            TemporalPoseResult result = temporal.refine(objectPoints, corners, camMat, dist, rvec, tvec);
+            lastDiagnostics.warmStarted = result.success;
+            lastDiagnostics.iterations = result.iterations;
+            if (!result.success)
+                cv::solvePnP(objectPoints, corners, camMat, dist, rvec, tvec);
+            temporal.update(rvec, tvec);
+        }
+        else
+        {
+            cv::solvePnP(objectPoints, corners, camMat, dist, rvec, tvec);
+        }
+
+        lastDiagnostics.solveMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - solveStart).count();
+        return success;
+    }
+
+    // Find the corners on the half-resolution level and refine them at full resolution
+    bool detectCornersHalf(const cv::Mat &grayHalf, const cv::Mat &gray, std::vector<cv::Point2f> &corners)
+    {
+        if (!findCorners(grayHalf, corners))
+            return false;
+        for (auto &c : corners)
+            c = c * 2.0f + cv::Point2f(0.5f, 0.5f); // Half-res pixel centers back to full-res coordinates
+        refineCorners(gray, corners);
+        return true;
+    }
+
     // Estimate pose from the given frame
     bool estimatePose(const cv::Mat &frame, const cv::Mat &camMat, const cv::Mat &dist, cv::Mat &rvec, cv::Mat &tvec) override
     {
         // Convert to grayscale
-        cv::Mat gray;
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        return estimatePose(PreparedFrame::fromColor(frame), camMat, dist, rvec, tvec);
+    }
+
+    // Estimate pose from a preprocessed frame (detection on the half-resolution level when present)
+    bool estimatePose(const PreparedFrame &frame, const cv::Mat &camMat, const cv::Mat &dist, cv::Mat &rvec, cv::Mat &tvec) override
+    {
+        lastDiagnostics = PoseDiagnostics();
 
         // Find chessboard corners
         std::vector<cv::Point2f> corners;
-        bool found = cv::findChessboardCorners(gray, patternSize, corners, cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
-
-        if (found)
+        const bool found = frame.grayHalf.empty() ? detectCorners(frame.gray, corners)
+                                                  : detectCornersHalf(frame.grayHalf, frame.gray, corners);
+        if (!found)
         {
-            // Refine corners (Sub-pixel)
-            cv::cornerSubPix(gray, corners, cv::Size(11, 11), cv::Size(-1, -1),
-                             cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.1));
-            lastCorners = corners; // Store the detected corners
-
-            // Draw detected corners for debugging
-            cv::Mat debugImg = frame.clone();
-            cv::drawChessboardCorners(debugImg, patternSize, corners, found);
-            cv::imshow("Chessboard Detection", debugImg);
-
-            // Calculate Pose
-            cv::solvePnP(objectPoints, corners, camMat, dist, rvec, tvec);
-            return true;
+            temporal.reset();    // Next detection starts cold
+            lastCorners.clear(); // Clear if not found
+            return false;
         }
-        else
+        lastCorners = corners; // Store the detected corners
+
+        // Draw detected corners for debugging
+        if (showDebug)
         {
-            lastCorners.clear(); // Clear if not found
+            cv::Mat debugImg = frame.color.empty() ? frame.gray.clone() : frame.color.clone();
+            cv::drawChessboardCorners(debugImg, patternSize, corners, true);
+            cv::imshow("Chessboard Detection", debugImg);
         }
-        return false;
+
+        // Calculate Pose
+        return solvePose(corners, camMat, dist, rvec, tvec);
     }
 };
\ No newline at end of file
@@ -0,0 +1,40 @@
+# Writes OUTPUT, a C++ source holding every shader of SHADER_DIR as a string (see embedded_shaders.hpp)
+# Run at build time: cmake -DSHADER_DIR=<dir> -DOUTPUT=<file> -P embed_shaders.cmake
+file(GLOB shaders RELATIVE ${SHADER_DIR} ${SHADER_DIR}/*.vert ${SHADER_DIR}/*.frag)
+list(SORT shaders)
+
+set(entries "")
+foreach(name IN LISTS shaders)
+    file(READ ${SHADER_DIR}/${name} source)
+    string(APPEND entries "        {\"${name}\", R\"ar_glsl(${source})ar_glsl\"},\n")
+endforeach()
+
+file(WRITE ${OUTPUT}.tmp
+"// Generated from shaders/ by cmake/embed_shaders.cmake, do not edit
+#include \"embedded_shaders.hpp\"
+
+namespace
+{
+    struct Shader
+    {
+        const char *name;
+        const char *source;
+    };
+
+    const Shader kShaders[] = {
+${entries}    };
+}
+
+std::string_view embeddedShader(std::string_view name)
+{
+    for (const auto &shader : kShaders)
+    {
+        if (name == shader.name)
+            return shader.source;
+    }
+    return {};
+}
+")
+# Unchanged output keeps ar_core from recompiling
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
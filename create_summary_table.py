@@ -1,10 +1,11 @@
-import json
+import csv
 import os
 import matplotlib.pyplot as plt
 from matplotlib import table
 
 # --- Configuration ---
 OUTPUT_DIR = "data/figures"
+TESTS_CSV = "data/analytics/tests.csv"
 DPI = 300
 
 # --- Palette ---
@@ -21,54 +22,29 @@ def ensure_dir(directory):
     if not os.path.exists(directory):
         os.makedirs(directory)
 
-def load_summary(filepath):
-    """ Loads just the summary section of the JSON """
-    if not os.path.exists(filepath):
-        return None
-    try:
-        with open(filepath, 'r') as f:
-            data = json.load(f)
-        return data.get("summary", {})
-    except:
-        return None
-
 def get_comparison_data():
     """ 
     Aggregates data into a structured list for the table.
     Returns a list of rows: [Category, Test, MetricName, ChessVal, NFTVal, BetterDirection]
     """
     
-    files = [
-        # Checkerboard
-        ("data/statistics/Checkerboard/detection_robustness/session_stats_checkerboard_angle.json", "angle", "checkerboard"),
-        ("data/statistics/Checkerboard/detection_robustness/session_stats_checkerboard_lighting.json", "lighting", "checkerboard"),
-        ("data/statistics/Checkerboard/detection_robustness/session_stats_checkerboard_occlusion.json", "occlusion", "checkerboard"),
-        ("data/statistics/Checkerboard/pose_stability/session_stats_checkerboard.json", "static", "checkerboard"),
-        # NFT
-        ("data/statistics/NFT/detection_robustness/session_stats_nft_angle.json", "angle", "nft"),
-        ("data/statistics/NFT/detection_robustness/session_stats_nft_lighting.json", "lighting", "nft"),
-        ("data/statistics/NFT/detection_robustness/session_stats_nft_occlusion.json", "occlusion", "nft"),
-        ("data/statistics/NFT/pose_stability/session_stats_nft.json", "static", "nft"),
-    ]
+    # Per method and test aggregates written by ar_analytics
+    if not os.path.exists(TESTS_CSV):
+        print(f"Missing {TESTS_CSV}. Run ./build/ar_analytics first.")
+        return []
 
     raw_data = {} 
 
-    for path, test, method in files:
-        summary = load_summary(path)
-        if not summary: continue
-        
-        if test not in raw_data: raw_data[test] = {}
-        if method not in raw_data[test]: raw_data[test][method] = {}
-
-        perf = summary.get("performance", {})
-        raw_data[test][method]['time'] = perf.get("mean_frame_time_ms", 0.0)
-
-        rob = summary.get("robustness", {})
-        raw_data[test][method]['success'] = rob.get("success_rate", 0.0)
-
-        stab = summary.get("pose_stability", {})
-        raw_data[test][method]['trans_jitter'] = stab.get("translation_mean_error", 0.0)
-        raw_data[test][method]['rot_jitter'] = stab.get("rotation_mean_error_rad", 0.0)
+    with open(TESTS_CSV, newline='') as f:
+        for row in csv.DictReader(f):
+            test, method = row['test'], row['method']
+            if test not in raw_data: raw_data[test] = {}
+            raw_data[test][method] = {
+                'time': float(row['mean_frame_time_ms']),
+                'success': float(row['success_rate']),
+                'trans_jitter': float(row['translation_mean_error']),
+                'rot_jitter': float(row['rotation_mean_error_rad']),
+            }
 
     table_rows = []
 
@@ -0,0 +1,7 @@
+#pragma once
+#include <string_view>
+
+// GLSL source of shaders/<name> (e.g. "cube.frag"), compiled into the binary at build time so the
+// executables do not depend on the source tree; empty if there is no such shader.
+// The definition is generated by cmake/embed_shaders.cmake whenever a shader changes.
+std::string_view embeddedShader(std::string_view name);
@@ -0,0 +1,187 @@
+#include "feature_grid.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int kPatchSize = 31;               // ORB descriptor patch
+    constexpr int kHalfPatch = kPatchSize / 2;   // Radius of the orientation patch
+    constexpr int kEdge = kPatchSize;            // cv::ORB's default edgeThreshold
+    constexpr int kFastMargin = 4;               // FAST circle radius plus the non-maximum neighbour
+
+    bool sameOptions(const GridFeatureOptions &a, const GridFeatureOptions &b)
+    {
+        return a.maxFeatures == b.maxFeatures && a.gridCols == b.gridCols && a.gridRows == b.gridRows &&
+               a.levels == b.levels && a.scaleFactor == b.scaleFactor && a.fastThreshold == b.fastThreshold;
+    }
+
+    // Intensity centroid angle of the circular patch around pt (as computed by cv::ORB)
+    float icAngle(const cv::Mat &image, cv::Point2f pt, const std::vector<int> &umax)
+    {
+        const uchar *center = image.ptr<uchar>(cvRound(pt.y)) + cvRound(pt.x);
+        const int step = static_cast<int>(image.step1());
+        int m01 = 0, m10 = 0;
+        for (int u = -kHalfPatch; u <= kHalfPatch; ++u)
+            m10 += u * center[u];
+        for (int v = 1; v <= kHalfPatch; ++v)
+        {
+            int vSum = 0;
+            const int d = umax[v];
+            for (int u = -d; u <= d; ++u)
+            {
+                const int plus = center[u + v * step], minus = center[u - v * step];
+                vSum += plus - minus;
+                m10 += u * (plus + minus);
+            }
+            m01 += v * vSum;
+        }
+        return cv::fastAtan2(static_cast<float>(m01), static_cast<float>(m10));
+    }
+}
+
+GridFeatureExtractor::GridFeatureExtractor(const GridFeatureOptions &options, ThreadPool *pool)
+    : options(options), pool(pool)
+{
+    // Row extents of the circular patch, symmetric in u and v (cv::ORB's construction)
+    umax.resize(kHalfPatch + 2);
+    const int vmax = cvFloor(kHalfPatch * std::sqrt(2.0) / 2 + 1);
+    const int vmin = cvCeil(kHalfPatch * std::sqrt(2.0) / 2);
+    for (int v = 0; v <= vmax; ++v)
+        umax[v] = cvRound(std::sqrt(static_cast<double>(kHalfPatch * kHalfPatch - v * v)));
+    for (int v = kHalfPatch, v0 = 0; v >= vmin; --v)
+    {
+        while (umax[v0] == umax[v0 + 1])
+            ++v0;
+        umax[v] = v0;
+        ++v0;
+    }
+}
+
+void GridFeatureExtractor::prepare(cv::Size frameSize)
+{
+    if (frameSize == preparedSize && sameOptions(options, preparedOptions))
+        return;
+    preparedSize = frameSize;
+    preparedOptions = options;
+
+    const int levels = std::max(1, options.levels);
+    describer = cv::ORB::create(options.maxFeatures, options.scaleFactor, levels, kEdge, 0, 2, cv::ORB::HARRIS_SCORE, kPatchSize);
+    pyramid.resize(levels);
+    layout.assign(levels, Level());
+
+    // Features per level fall off with the level's area, like cv::ORB
+    const double factor = 1.0 / options.scaleFactor;
+    double perLevel = options.maxFeatures * (1.0 - factor) / (1.0 - std::pow(factor, levels));
+    int assigned = 0, cells = 0;
+    for (int l = 0; l < levels; ++l)
+    {
+        Level &level = layout[l];
+        level.scale = static_cast<float>(std::pow(options.scaleFactor, l));
+        const cv::Size size(cvRound(frameSize.width / level.scale), cvRound(frameSize.height / level.scale));
+        level.valid = cv::Rect(kEdge, kEdge, std::max(0, size.width - 2 * kEdge), std::max(0, size.height - 2 * kEdge));
+        // Cells no smaller than a descriptor patch
+        level.cols = std::max(1, std::min(options.gridCols, level.valid.width / kPatchSize));
+        level.rows = std::max(1, std::min(options.gridRows, level.valid.height / kPatchSize));
+        const int features = l + 1 == levels ? std::max(0, options.maxFeatures - assigned) : cvRound(perLevel);
+        assigned += features;
+        perLevel *= factor;
+        level.quota = (features + level.cols * level.rows - 1) / (level.cols * level.rows);
+        level.firstCell = cells;
+        cells += level.cols * level.rows;
+    }
+    thresholds.assign(cells, options.fastThreshold);
+}
+
+void GridFeatureExtractor::detectCell(int l, int cell, std::vector<cv::KeyPoint> &out)
+{
+    const Level &level = layout[l];
+    const cv::Mat &image = pyramid[l];
+    if (level.valid.area() == 0 || level.quota == 0)
+        return;
+
+    // Cell bounds inside the valid area; neighbours share edges, every pixel belongs to one cell
+    const int cx = cell % level.cols, cy = cell / level.cols;
+    const cv::Rect core(level.valid.x + level.valid.width * cx / level.cols,
+                        level.valid.y + level.valid.height * cy / level.rows,
+                        level.valid.width * (cx + 1) / level.cols - level.valid.width * cx / level.cols,
+                        level.valid.height * (cy + 1) / level.rows - level.valid.height * cy / level.rows);
+    const cv::Rect tile(core.x - kFastMargin, core.y - kFastMargin, core.width + 2 * kFastMargin, core.height + 2 * kFastMargin);
+
+    int &threshold = thresholds[level.firstCell + cell];
+    std::vector<cv::KeyPoint> corners;
+    auto detect = [&](int t)
+    {
+        corners.clear();
+        cv::FAST(image(tile), corners, t, true);
+        // Keep corners of this cell only; the margin belongs to the neighbours
+        corners.erase(std::remove_if(corners.begin(), corners.end(), [&](const cv::KeyPoint &kp)
+                                     {
+                                         const float x = kp.pt.x + tile.x, y = kp.pt.y + tile.y;
+                                         return x < core.x || y < core.y || x >= core.x + core.width || y >= core.y + core.height; }),
+                      corners.end());
+    };
+    detect(threshold);
+    const size_t found = corners.size();
+    if (found < static_cast<size_t>(level.quota) && threshold > options.minFastThreshold)
+        detect(options.minFastThreshold); // Starving cell: take what the minimum threshold gives this frame
+
+    // Adapt for the next frame
+    if (found < static_cast<size_t>(level.quota))
+        threshold = std::max(options.minFastThreshold, threshold - options.thresholdStep);
+    else if (found > static_cast<size_t>(4 * level.quota))
+        threshold = std::min(options.maxFastThreshold, threshold + options.thresholdStep);
+
+    cv::KeyPointsFilter::retainBest(corners, level.quota);
+    for (auto &kp : corners)
+    {
+        kp.pt.x += tile.x;
+        kp.pt.y += tile.y;
+        kp.angle = icAngle(image, kp.pt, umax);
+        // Level coordinates to full resolution, as cv::ORB reports them
+        kp.pt *= level.scale;
+        kp.size = kPatchSize * level.scale;
+        kp.octave = l;
+        out.push_back(kp);
+    }
+}
+
+void GridFeatureExtractor::detectAndCompute(const cv::Mat &gray, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors)
+{
+    keypoints.clear();
+    descriptors.release();
+    if (gray.empty())
+        return;
+    prepare(gray.size());
+
+    // Each level from the previous one, as cv::ORB builds the pyramid its descriptors are computed on,
+    // so the orientations below are measured on the same images
+    pyramid[0] = gray;
+    for (size_t l = 1; l < layout.size(); ++l)
+        cv::resize(pyramid[l - 1], pyramid[l], cv::Size(cvRound(gray.cols / layout[l].scale), cvRound(gray.rows / layout[l].scale)), 0, 0, cv::INTER_LINEAR);
+
+    // One task per (level, cell), each with its own output so the merge keeps a fixed order
+    std::vector<std::pair<int, int>> tasks;
+    for (int l = 0; l < static_cast<int>(layout.size()); ++l)
+        for (int c = 0; c < layout[l].cols * layout[l].rows; ++c)
+            tasks.emplace_back(l, c);
+    std::vector<std::vector<cv::KeyPoint>> found(tasks.size());
+    auto body = [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+            detectCell(tasks[i].first, tasks[i].second, found[i]);
+    };
+    if (pool)
+        pool->parallelFor(0, static_cast<int>(tasks.size()), body);
+    else
+        body(0, static_cast<int>(tasks.size()));
+
+    size_t total = 0;
+    for (const auto &cell : found)
+        total += cell.size();
+    keypoints.reserve(total);
+    for (const auto &cell : found)
+        keypoints.insert(keypoints.end(), cell.begin(), cell.end());
+
+    // Descriptors of the given keypoints only (cv::ORB skips detection and keeps their angles)
+    describer->compute(gray, keypoints, descriptors);
+}
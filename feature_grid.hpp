@@ -0,0 +1,62 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "thread_pool.hpp"
+
+// Settings of the grid feature extractor
+struct GridFeatureOptions
+{
+    int maxFeatures = 2000;      // Total feature budget, split over levels and cells
+    int gridCols = 8;            // Cells per row on every pyramid level
+    int gridRows = 6;            // Cells per column on every pyramid level
+    int levels = 8;              // Pyramid levels (same pyramid as cv::ORB)
+    float scaleFactor = 1.2f;    // Scale between pyramid levels
+    int fastThreshold = 20;      // Initial FAST threshold of every cell
+    int minFastThreshold = 7;    // Lower bound of the adaptive threshold (also the retry threshold)
+    int maxFastThreshold = 60;   // Upper bound of the adaptive threshold
+    int thresholdStep = 2;       // Threshold change per frame for starving / flooded cells
+};
+
+// ORB features spread evenly over the frame
+// The valid area of every pyramid level is split into a grid of cells; each (level, cell) pair
+// runs FAST on its own tile of the ThreadPool and keeps its best responses up to a per-cell quota.
+// Tiles overlap by the FAST radius plus one, so corners and non-maximum suppression come out exactly
+// as on the whole image, and a corner is kept only by the cell it lies in (no duplicates at tile
+// borders). Each cell adapts its FAST threshold over frames: lowered while it cannot fill its quota
+// (with an immediate retry at the minimum), raised while it finds far more than it keeps.
+// Orientation is the intensity centroid of cv::ORB, so the descriptors computed by cv::ORB from these
+// keypoints match descriptors of a plain cv::ORB reference.
+class GridFeatureExtractor
+{
+public:
+    explicit GridFeatureExtractor(const GridFeatureOptions &options = {}, ThreadPool *pool = &ThreadPool::shared());
+
+    // Keypoints in full-resolution coordinates with octave, size and angle set, and their ORB descriptors
+    void detectAndCompute(const cv::Mat &gray, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors);
+
+    GridFeatureOptions options;
+
+private:
+    // Grid and threshold state for the current frame size and options
+    void prepare(cv::Size frameSize);
+    // FAST, quota and orientation of one cell of one level
+    void detectCell(int level, int cell, std::vector<cv::KeyPoint> &out);
+
+    struct Level
+    {
+        float scale = 1.0f;    // Level size = frame size / scale
+        cv::Rect valid;        // Area whose corners have a full descriptor patch
+        int cols = 1, rows = 1; // Grid of this level (coarse levels use fewer cells)
+        int quota = 0;         // Features kept per cell
+        int firstCell = 0;     // Index of the level's first cell in thresholds
+    };
+
+    ThreadPool *pool;                 // nullptr = single-threaded
+    cv::Ptr<cv::ORB> describer;       // Descriptors only
+    std::vector<cv::Mat> pyramid;     // Level images, reused between frames
+    std::vector<Level> layout;
+    std::vector<int> thresholds;      // Adaptive FAST threshold per cell of every level
+    std::vector<int> umax;            // Row extents of the circular orientation patch
+    cv::Size preparedSize;
+    GridFeatureOptions preparedOptions;
+};
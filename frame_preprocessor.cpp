@@ -0,0 +1,153 @@
+#include "frame_preprocessor.hpp"
+#include <algorithm>
+
+namespace
+{
+    // BT.601 luma in 8-bit fixed point (weights sum to 256), within 1 LSB of cv::COLOR_BGR2GRAY
+    constexpr unsigned kWeightB = 29, kWeightG = 150, kWeightR = 77;
+
+    // Luma of one BGR row, plus its RGB copy when rgb is not null
+    inline void convertRow(const uchar *__restrict bgr, uchar *__restrict gray, uchar *__restrict rgb, int width)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const unsigned b = bgr[3 * x], g = bgr[3 * x + 1], r = bgr[3 * x + 2];
+            gray[x] = static_cast<uchar>((kWeightB * b + kWeightG * g + kWeightR * r + 128) >> 8);
+        }
+        if (rgb)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                rgb[3 * x] = bgr[3 * x + 2];
+                rgb[3 * x + 1] = bgr[3 * x + 1];
+                rgb[3 * x + 2] = bgr[3 * x];
+            }
+        }
+    }
+
+    // 2x2 box average of two luma rows
+    inline void halveRows(const uchar *__restrict row0, const uchar *__restrict row1, uchar *__restrict half, int halfWidth)
+    {
+        for (int x = 0; x < halfWidth; ++x)
+            half[x] = static_cast<uchar>((row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+    }
+
+    // A gray view of the previous input (capture plane, read-only ring slot) must not be written
+    // into: detach from it so the next create() / cvtColor allocates a buffer of our own
+    void releaseView(PreparedFrame &out)
+    {
+        if (!out.ownsGray)
+            out.gray.release();
+        out.ownsGray = true;
+    }
+}
+
+PreparedFrame PreparedFrame::fromColor(const cv::Mat &bgr)
+{
+    PreparedFrame frame;
+    FramePreprocessor(PreprocessOptions{false, false, false}).process(bgr, frame);
+    return frame;
+}
+
+void FramePreprocessor::process(const cv::Mat &bgr, PreparedFrame &out) const
+{
+    out.color = bgr;
+    if (bgr.empty())
+    {
+        out.gray.release();
+        out.ownsGray = false;
+        out.grayHalf.release();
+        out.upload.release();
+        return;
+    }
+
+    if (bgr.type() != CV_8UC3)
+    {
+        // Grayscale or unusual cameras: plain OpenCV conversions
+        if (bgr.channels() == 1)
+        {
+            out.gray = bgr;
+            out.ownsGray = false;
+        }
+        else
+        {
+            releaseView(out);
+            cv::cvtColor(bgr, out.gray, bgr.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+        }
+        if (options.halfResolution)
+            cv::resize(out.gray, out.grayHalf, cv::Size(out.gray.cols / 2, out.gray.rows / 2), 0, 0, cv::INTER_AREA);
+        else
+            out.grayHalf.release();
+        if (options.uploadBuffer)
+        {
+            cv::cvtColor(bgr, out.upload, bgr.channels() == 1 ? cv::COLOR_GRAY2RGB : cv::COLOR_BGRA2RGB);
+            cv::flip(out.upload, out.upload, 0);
+        }
+        else
+            out.upload.release();
+        return;
+    }
+
+    // create() keeps the existing buffers when the size does not change
+    const int width = bgr.cols, height = bgr.rows;
+    releaseView(out);
+    out.gray.create(height, width, CV_8UC1);
+    if (options.halfResolution)
+        out.grayHalf.create(height / 2, width / 2, CV_8UC1);
+    else
+        out.grayHalf.release();
+    if (options.uploadBuffer)
+        out.upload.create(height, width, CV_8UC3);
+    else
+        out.upload.release();
+
+    // Row pairs are the unit of work so every half-resolution row comes from a single task
+    const int pairs = (height + 1) / 2;
+    cv::Mat &gray = out.gray, &half = out.grayHalf, &upload = out.upload;
+    auto convert = [&](int y)
+    {
+        convertRow(bgr.ptr<uchar>(y), gray.ptr<uchar>(y), upload.empty() ? nullptr : upload.ptr<uchar>(height - 1 - y), width);
+    };
+    auto body = [&](const cv::Range &range)
+    {
+        for (int p = range.start; p < range.end; ++p)
+        {
+            const int y0 = 2 * p, y1 = std::min(2 * p + 1, height - 1);
+            convert(y0);
+            if (y1 != y0)
+                convert(y1); // Odd heights end with a single row
+            if (!half.empty() && p < half.rows)
+                halveRows(gray.ptr<uchar>(y0), gray.ptr<uchar>(y1), half.ptr<uchar>(p), half.cols);
+        }
+    };
+
+    if (options.parallel)
+        cv::parallel_for_(cv::Range(0, pairs), body, std::max(1.0, height / 64.0));
+    else
+        body(cv::Range(0, pairs));
+}
+
+void FramePreprocessor::processGray(const cv::Mat &gray, PreparedFrame &out) const
+{
+    out.color.release();
+    out.upload.release();
+    out.gray = gray;
+    out.ownsGray = false;
+    if (!options.halfResolution || gray.empty())
+    {
+        out.grayHalf.release();
+        return;
+    }
+
+    out.grayHalf.create(gray.rows / 2, gray.cols / 2, CV_8UC1);
+    cv::Mat &half = out.grayHalf;
+    auto body = [&](const cv::Range &range)
+    {
+        for (int y = range.start; y < range.end; ++y)
+            halveRows(gray.ptr<uchar>(2 * y), gray.ptr<uchar>(2 * y + 1), half.ptr<uchar>(y), half.cols);
+    };
+    if (options.parallel)
+        cv::parallel_for_(cv::Range(0, half.rows), body, std::max(1.0, half.rows / 32.0));
+    else
+        body(cv::Range(0, half.rows));
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+
+// One camera frame with everything the trackers and the renderer read from it
+// Filled once per frame by FramePreprocessor, so no consumer converts the frame again.
+struct PreparedFrame
+{
+    cv::Mat color;    // Undistorted BGR frame (shared, not copied)
+    cv::Mat gray;     // Full-resolution luma
+    cv::Mat grayHalf; // Half-resolution luma (2x2 box), empty unless requested
+    cv::Mat upload;   // RGB with rows bottom-up, ready for glTexSubImage2D; empty unless requested
+    bool ownsGray = false; // gray is our own buffer, not a view of the caller's (capture plane, ring slot)
+
+    // Wrap a BGR frame and compute only its grayscale image (callers without a preprocessor)
+    static PreparedFrame fromColor(const cv::Mat &bgr);
+};
+
+// Settings of the frame preprocessor
+struct PreprocessOptions
+{
+    bool halfResolution = false; // Also produce grayHalf
+    bool uploadBuffer = true;    // Also produce the RGB upload buffer
+    bool parallel = true;        // Split rows over OpenCV's threads (off inside worker pools)
+};
+
+// Single pass over a BGR frame producing gray, the half-resolution level and the upload buffer
+// Each row is read once: its luma, its flipped RGB copy and (every second row) the half-resolution
+// row are written while the source row is still in cache. The per-pixel loops are branch free
+// with unit-stride stores so the compiler vectorizes them.
+class FramePreprocessor
+{
+public:
+    explicit FramePreprocessor(const PreprocessOptions &options = {}) : options(options) {}
+
+    // Fill out from bgr; out's buffers are reused between calls of the same frame size
+    void process(const cv::Mat &bgr, PreparedFrame &out) const;
+
+    // Fill out from a luma image (YUV capture): gray is the given view, no color and no upload buffer
+    void processGray(const cv::Mat &gray, PreparedFrame &out) const;
+
+    PreprocessOptions options;
+};
@@ -0,0 +1,83 @@
+#include "frame_reader.hpp"
+#include <algorithm>
+#include <cctype>
+
+// Natural ordering so capture_2.png sorts before capture_10.png
+bool naturalLess(const std::string &a, const std::string &b)
+{
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        if (std::isdigit(static_cast<unsigned char>(a[i])) && std::isdigit(static_cast<unsigned char>(b[j])))
+        {
+            // Compare whole digit runs by value
+            size_t iEnd = i, jEnd = j;
+            while (iEnd < a.size() && std::isdigit(static_cast<unsigned char>(a[iEnd])))
+                iEnd++;
+            while (jEnd < b.size() && std::isdigit(static_cast<unsigned char>(b[jEnd])))
+                jEnd++;
+            const unsigned long long na = std::stoull(a.substr(i, iEnd - i));
+            const unsigned long long nb = std::stoull(b.substr(j, jEnd - j));
+            if (na != nb)
+                return na < nb;
+            i = iEnd;
+            j = jEnd;
+        }
+        else
+        {
+            if (a[i] != b[j])
+                return a[i] < b[j];
+            i++;
+            j++;
+        }
+    }
+    return a.size() - i < b.size() - j;
+}
+
+std::vector<std::filesystem::path> listImages(const std::filesystem::path &dir)
+{
+    std::vector<std::filesystem::path> images;
+    for (const auto &entry : std::filesystem::directory_iterator(dir))
+    {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp")
+            images.push_back(entry.path());
+    }
+    std::sort(images.begin(), images.end(), [](const auto &a, const auto &b)
+              { return naturalLess(a.filename().string(), b.filename().string()); });
+    return images;
+}
+
+FrameReader::FrameReader(const std::filesystem::path &input)
+{
+    if (std::filesystem::is_directory(input))
+    {
+        // Collect image files in natural order
+        images = listImages(input);
+        opened = !images.empty();
+    }
+    else
+    {
+        opened = video.open(input.string());
+        if (opened)
+        {
+            const double reportedFps = video.get(cv::CAP_PROP_FPS);
+            if (reportedFps > 0)
+                fps = reportedFps;
+        }
+    }
+}
+
+// Read the next frame, false at the end of the input
+bool FrameReader::read(cv::Mat &frame)
+{
+    if (!images.empty())
+    {
+        if (nextImage >= images.size())
+            return false;
+        frame = cv::imread(images[nextImage++].string(), cv::IMREAD_COLOR);
+        return !frame.empty();
+    }
+    return video.read(frame) && !frame.empty();
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Natural ordering so capture_2.png sorts before capture_10.png
+bool naturalLess(const std::string &a, const std::string &b);
+
+// Image files (png, jpg, jpeg, bmp) of a directory in natural order
+std::vector<std::filesystem::path> listImages(const std::filesystem::path &dir);
+
+// Sequential frame reader for a video file or a directory of images
+class FrameReader
+{
+public:
+    explicit FrameReader(const std::filesystem::path &input);
+
+    bool isOpened() const { return opened; }
+
+    // Read the next frame, false at the end of the input
+    bool read(cv::Mat &frame);
+
+    // Session timestamp of a frame (image sequences are assumed to be 30 fps)
+    double timestamp(int index) const { return index / fps; }
+
+private:
+    cv::VideoCapture video;                    // Video input
+    std::vector<std::filesystem::path> images; // Image sequence input
+    size_t nextImage = 0;                      // Next image to load
+    double fps = 30.0;                         // Frame rate used for timestamps
+    bool opened = false;
+};
@@ -0,0 +1,242 @@
+#include "frame_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+namespace
+{
+    constexpr std::uint32_t kRingMagic = 0x474e4952; // "RING"
+    constexpr std::uint32_t kRingVersion = 1;
+    constexpr size_t kAlign = 64; // Slots start on their own cache line
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ring counters must be lock-free to live in shared memory");
+
+    // Start of the segment
+    struct RingHeader
+    {
+        std::atomic<std::uint32_t> magic; // Written last, once the rest of the header is valid
+        std::uint32_t version;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t format; // CaptureFormat
+        std::int32_t slots;
+        std::uint64_t frameBytes;         // Packed bytes of one frame
+        std::uint64_t slotStride;         // Bytes from one slot header to the next
+        std::atomic<std::uint64_t> head;  // Sequence of the newest published frame, 0 before the first
+        std::atomic<std::uint32_t> closed; // Producer finished
+    };
+
+    // Start of every slot, followed by the frame bytes
+    struct SlotHeader
+    {
+        std::atomic<std::uint64_t> sequence; // Frame in the slot, 0 while it is being written
+        double timestamp;
+    };
+
+    size_t alignUp(size_t bytes)
+    {
+        return (bytes + kAlign - 1) / kAlign * kAlign;
+    }
+
+    const size_t kHeaderBytes = alignUp(sizeof(RingHeader));
+    const size_t kSlotHeaderBytes = alignUp(sizeof(SlotHeader));
+
+    size_t frameBytesOf(cv::Size size, CaptureFormat format)
+    {
+        const size_t pixels = static_cast<size_t>(size.area());
+        switch (format)
+        {
+        case CaptureFormat::NV12:
+            return pixels * 3 / 2;
+        case CaptureFormat::YUYV:
+            return pixels * 2;
+        default:
+            return pixels * 3;
+        }
+    }
+
+    RingHeader *headerOf(const SharedMemory &memory)
+    {
+        return reinterpret_cast<RingHeader *>(memory.data());
+    }
+
+    SlotHeader *slotOf(const SharedMemory &memory, std::uint64_t sequence)
+    {
+        const RingHeader *header = headerOf(memory);
+        const size_t index = static_cast<size_t>(sequence % static_cast<std::uint64_t>(header->slots));
+        return reinterpret_cast<SlotHeader *>(memory.data() + kHeaderBytes + index * header->slotStride);
+    }
+}
+
+double frameRingClock()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameRingWriter::~FrameRingWriter()
+{
+    close();
+}
+
+bool FrameRingWriter::create(const std::string &name, cv::Size size, CaptureFormat format, int slots)
+{
+    memory.close();
+    if (size.area() <= 0 || slots < 2)
+        return false;
+    const size_t frameBytes = frameBytesOf(size, format);
+    const size_t stride = kSlotHeaderBytes + alignUp(frameBytes);
+    SharedMemory::remove(name);
+    if (!memory.create(name, kHeaderBytes + stride * static_cast<size_t>(slots)))
+    {
+        std::cerr << "Unable to create frame ring " << name << std::endl;
+        return false;
+    }
+
+    // The segment starts zeroed: every slot is empty and head is 0
+    RingHeader *header = new (memory.data()) RingHeader();
+    header->version = kRingVersion;
+    header->width = size.width;
+    header->height = size.height;
+    header->format = static_cast<std::int32_t>(format);
+    header->slots = slots;
+    header->frameBytes = frameBytes;
+    header->slotStride = stride;
+    for (int i = 0; i < slots; ++i)
+        new (memory.data() + kHeaderBytes + static_cast<size_t>(i) * stride) SlotHeader();
+    header->magic.store(kRingMagic, std::memory_order_release);
+    return true;
+}
+
+bool FrameRingWriter::publish(const CapturedFrame &frame, double timestamp)
+{
+    if (!memory.isOpen())
+        return false;
+    RingHeader *header = headerOf(memory);
+    const cv::Mat &image = frame.format == CaptureFormat::BGR ? frame.bgr : frame.raw;
+    if (static_cast<std::int32_t>(frame.format) != header->format || frame.size != cv::Size(header->width, header->height) ||
+        image.empty() || image.total() * image.elemSize() != header->frameBytes)
+        return false;
+
+    const std::uint64_t sequence = header->head.load(std::memory_order_relaxed) + 1;
+    SlotHeader *slot = slotOf(memory, sequence);
+    // Invalidate the slot before touching its bytes, so readers of the old frame notice
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    unsigned char *bytes = reinterpret_cast<unsigned char *>(slot) + kSlotHeaderBytes;
+    const size_t rowBytes = image.cols * image.elemSize();
+    for (int y = 0; y < image.rows; ++y)
+        std::memcpy(bytes + y * rowBytes, image.ptr(y), rowBytes);
+    slot->timestamp = timestamp;
+
+    slot->sequence.store(sequence, std::memory_order_release);
+    header->head.store(sequence, std::memory_order_release);
+    return true;
+}
+
+void FrameRingWriter::close()
+{
+    if (memory.isOpen())
+        headerOf(memory)->closed.store(1, std::memory_order_release);
+    memory.close(); // Consumers keep their mappings; the name goes away
+}
+
+std::uint64_t FrameRingWriter::published() const
+{
+    return memory.isOpen() ? headerOf(memory)->head.load(std::memory_order_relaxed) : 0;
+}
+
+bool FrameRingReader::open(const std::string &name)
+{
+    lastSequence = 0;
+    if (!memory.open(name))
+        return false;
+    const RingHeader *header = headerOf(memory);
+    if (memory.size() < kHeaderBytes || header->magic.load(std::memory_order_acquire) != kRingMagic || header->version != kRingVersion ||
+        header->slots < 2 || memory.size() < kHeaderBytes + header->slotStride * static_cast<size_t>(header->slots))
+    {
+        std::cerr << "Shared memory " << name << " is not a frame ring" << std::endl;
+        memory.close();
+        return false;
+    }
+    return true;
+}
+
+bool FrameRingReader::next(FrameRingFrame &frame, int timeoutMs)
+{
+    if (!memory.isOpen())
+        return false;
+    const RingHeader *header = headerOf(memory);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;)
+    {
+        const std::uint64_t head = header->head.load(std::memory_order_acquire);
+        if (head > lastSequence)
+        {
+            // The newest frame; if its slot is already being rewritten, head has moved on and the loop retries
+            SlotHeader *slot = slotOf(memory, head);
+            if (slot->sequence.load(std::memory_order_acquire) != head)
+                continue;
+            const double timestamp = slot->timestamp;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) != head)
+                continue;
+
+            frame.sequence = head;
+            frame.timestamp = timestamp;
+            frame.skipped = lastSequence > 0 ? head - lastSequence - 1 : 0;
+            lastSequence = head;
+
+            // Views over the slot; the mapping is read-only
+            CapturedFrame &captured = frame.frame;
+            captured.format = format();
+            captured.size = size();
+            unsigned char *bytes = reinterpret_cast<unsigned char *>(slot) + kSlotHeaderBytes;
+            captured.bgr.release();
+            captured.raw.release();
+            switch (captured.format)
+            {
+            case CaptureFormat::NV12:
+                captured.raw = cv::Mat(captured.size.height * 3 / 2, captured.size.width, CV_8UC1, bytes);
+                break;
+            case CaptureFormat::YUYV:
+                captured.raw = cv::Mat(captured.size, CV_8UC2, bytes);
+                break;
+            default:
+                captured.bgr = cv::Mat(captured.size, CV_8UC3, bytes);
+                break;
+            }
+            return true;
+        }
+        if (isClosed() || std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+bool FrameRingReader::isCurrent(std::uint64_t sequence) const
+{
+    if (!memory.isOpen() || sequence == 0)
+        return false;
+    // Order the caller's reads of the frame before the check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slotOf(memory, sequence)->sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool FrameRingReader::isClosed() const
+{
+    return !memory.isOpen() || headerOf(memory)->closed.load(std::memory_order_acquire) != 0;
+}
+
+cv::Size FrameRingReader::size() const
+{
+    return memory.isOpen() ? cv::Size(headerOf(memory)->width, headerOf(memory)->height) : cv::Size();
+}
+
+CaptureFormat FrameRingReader::format() const
+{
+    return memory.isOpen() ? static_cast<CaptureFormat>(headerOf(memory)->format) : CaptureFormat::BGR;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include "frame_source.hpp"
+#include "shared_memory.hpp"
+
+// Ring of captured frames in POSIX shared memory: one producer, any number of consumers
+// The producer writes frame N into slot N % slots and never waits for anyone. Consumers map the ring
+// read-only, always take the newest frame (skipping those they were too slow for) and read it in place.
+// Every slot carries the sequence number of its frame, cleared while the slot is rewritten, so a consumer
+// can check after use that its frame was not overwritten meanwhile (which takes slots - 1 newer frames).
+
+// Frame handed to a consumer
+struct FrameRingFrame
+{
+    std::uint64_t sequence = 0; // Producer frame number, from 1
+    double timestamp = 0.0;     // Producer capture time, steady clock seconds (comparable across processes)
+    std::uint64_t skipped = 0;  // Frames published since the previous frame this consumer took
+    CapturedFrame frame;        // Read-only views into the slot
+};
+
+// Seconds on the clock of FrameRingFrame::timestamp
+double frameRingClock();
+
+// Producer side; creates the segment and removes its name when destroyed
+class FrameRingWriter
+{
+public:
+    ~FrameRingWriter();
+
+    // Create the ring for frames of one size and format (replaces a segment left by a crashed producer)
+    bool create(const std::string &name, cv::Size size, CaptureFormat format, int slots = 8);
+    // Copy a frame into the next slot and publish it; false if its size or format differs from the ring's
+    bool publish(const CapturedFrame &frame, double timestamp);
+    // Tell consumers that no more frames will come
+    void close();
+
+    bool isOpen() const { return memory.isOpen(); }
+    std::uint64_t published() const;
+
+private:
+    SharedMemory memory;
+};
+
+// Consumer side
+class FrameRingReader
+{
+public:
+    // Attach to a ring created by FrameRingWriter
+    bool open(const std::string &name);
+    // Newest frame after the last one taken, waiting up to timeoutMs; false on timeout or once the producer closed
+    bool next(FrameRingFrame &frame, int timeoutMs = 2000);
+    // False once the slot of the given frame has been rewritten (its views then hold another frame)
+    bool isCurrent(std::uint64_t sequence) const;
+    bool isClosed() const;
+
+    bool isOpen() const { return memory.isOpen(); }
+    cv::Size size() const;
+    CaptureFormat format() const;
+
+private:
+    SharedMemory memory;
+    std::uint64_t lastSequence = 0;
+};
@@ -0,0 +1,169 @@
+#include "frame_source.hpp"
+#include "frame_ring.hpp"
+#include <iostream>
+
+cv::Mat CapturedFrame::luma() const
+{
+    cv::Mat gray;
+    switch (format)
+    {
+    case CaptureFormat::NV12:
+        return raw.rowRange(0, size.height); // The Y plane, shared with the capture buffer
+    case CaptureFormat::YUYV:
+        cv::extractChannel(raw, gray, 0); // Y of every (Y, U) / (Y, V) pair
+        return gray;
+    default:
+        cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+        return gray;
+    }
+}
+
+bool parseCaptureFormat(const std::string &text, CaptureFormat &format)
+{
+    if (text == "bgr")
+        format = CaptureFormat::BGR;
+    else if (text == "yuyv")
+        format = CaptureFormat::YUYV;
+    else if (text == "nv12")
+        format = CaptureFormat::NV12;
+    else
+        return false;
+    return true;
+}
+
+static int fourccOf(CaptureFormat format)
+{
+    return format == CaptureFormat::NV12 ? cv::VideoWriter::fourcc('N', 'V', '1', '2') : cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V');
+}
+
+FrameSource::FrameSource() = default;
+FrameSource::~FrameSource() = default;
+
+bool FrameSource::open(int camera, CaptureFormat preferred)
+{
+    rawFile.close();
+    ring.reset();
+    if (!capture.open(camera))
+        return false;
+    frameSize = cv::Size(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    activeFormat = CaptureFormat::BGR;
+    if (preferred == CaptureFormat::BGR)
+        return true;
+
+    // Ask for the raw FOURCC and check that the backend actually switched
+    const int fourcc = fourccOf(preferred);
+    const bool accepted = capture.set(cv::CAP_PROP_FOURCC, fourcc) &&
+                          static_cast<int>(capture.get(cv::CAP_PROP_FOURCC)) == fourcc &&
+                          capture.set(cv::CAP_PROP_CONVERT_RGB, 0);
+    if (accepted)
+    {
+        activeFormat = preferred;
+        frameSize = cv::Size(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    }
+    else
+    {
+        capture.set(cv::CAP_PROP_CONVERT_RGB, 1);
+        std::cerr << "Camera does not deliver raw " << (preferred == CaptureFormat::NV12 ? "NV12" : "YUYV") << ", capturing BGR" << std::endl;
+    }
+    return true;
+}
+
+bool FrameSource::openRaw(const std::filesystem::path &path, cv::Size size, CaptureFormat format)
+{
+    capture.release();
+    if (format == CaptureFormat::BGR || size.width % 2 != 0 || size.height % 2 != 0)
+    {
+        std::cerr << "Raw input needs YUYV or NV12 frames of even size" << std::endl;
+        return false;
+    }
+    rawFile.close();
+    ring.reset();
+    rawFile.open(path, std::ios::binary);
+    activeFormat = format;
+    frameSize = size;
+    return rawFile.is_open();
+}
+
+bool FrameSource::openRing(const std::string &name)
+{
+    capture.release();
+    rawFile.close();
+    ring = std::make_unique<FrameRingReader>();
+    if (!ring->open(name))
+    {
+        ring.reset();
+        return false;
+    }
+    activeFormat = ring->format();
+    frameSize = ring->size();
+    ringSequence = 0;
+    skipped = 0;
+    return true;
+}
+
+bool FrameSource::isCurrent() const
+{
+    return !ring || ring->isCurrent(ringSequence);
+}
+
+size_t FrameSource::rawFrameBytes() const
+{
+    const size_t pixels = static_cast<size_t>(frameSize.area());
+    return activeFormat == CaptureFormat::NV12 ? pixels * 3 / 2 : pixels * 2;
+}
+
+bool FrameSource::read(CapturedFrame &frame)
+{
+    if (ring)
+    {
+        FrameRingFrame ringFrame;
+        if (!ring->next(ringFrame))
+            return false;
+        ringSequence = ringFrame.sequence;
+        skipped += ringFrame.skipped;
+        frame = ringFrame.frame;
+        return true;
+    }
+
+    frame.format = activeFormat;
+    frame.size = frameSize;
+
+    if (rawFile.is_open())
+    {
+        // create() keeps the buffer between frames
+        if (activeFormat == CaptureFormat::NV12)
+            frame.raw.create(frameSize.height * 3 / 2, frameSize.width, CV_8UC1);
+        else
+            frame.raw.create(frameSize, CV_8UC2);
+        return static_cast<bool>(rawFile.read(reinterpret_cast<char *>(frame.raw.data), static_cast<std::streamsize>(rawFrameBytes())));
+    }
+
+    if (activeFormat == CaptureFormat::BGR)
+    {
+        if (!capture.read(frame.bgr) || frame.bgr.empty())
+            return false;
+        frame.size = frame.bgr.size();
+        return true;
+    }
+
+    cv::Mat buffer;
+    if (!capture.read(buffer) || buffer.empty())
+        return false;
+    if (buffer.type() == CV_8UC3)
+    {
+        // The backend converted after all
+        frame.format = CaptureFormat::BGR;
+        frame.bgr = buffer;
+        frame.size = buffer.size();
+        return true;
+    }
+    // Backends return either the final layout or one row of bytes
+    if (!buffer.isContinuous() || buffer.total() * buffer.elemSize() != rawFrameBytes())
+    {
+        std::cerr << "Unexpected raw frame of " << buffer.total() * buffer.elemSize() << " bytes" << std::endl;
+        return false;
+    }
+    frame.raw = activeFormat == CaptureFormat::NV12 ? buffer.reshape(1, frameSize.height * 3 / 2)
+                                                     : buffer.reshape(2, frameSize.height);
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+
+// Pixel layout of captured frames
+enum class CaptureFormat
+{
+    BGR,  // OpenCV's converted capture (default)
+    YUYV, // Packed 4:2:2, Y0 U Y1 V per pixel pair
+    NV12  // Planar 4:2:0, full-resolution Y plane followed by interleaved UV at half resolution
+};
+
+// One captured frame in its native layout
+struct CapturedFrame
+{
+    CaptureFormat format = CaptureFormat::BGR;
+    cv::Size size;  // Frame size in pixels
+    cv::Mat bgr;    // BGR image (BGR format only)
+    cv::Mat raw;    // YUYV: size.height x size.width CV_8UC2; NV12: (size.height * 3 / 2) x size.width CV_8UC1
+
+    // Grayscale view: the Y plane itself for NV12 (no copy), one deinterleave for YUYV, a conversion for BGR
+    cv::Mat luma() const;
+};
+
+// Parse "bgr", "yuyv" or "nv12"
+bool parseCaptureFormat(const std::string &text, CaptureFormat &format);
+
+class FrameRingReader;
+
+// Camera or raw-file frame source that can keep frames in YUV
+// YUV capture asks the VideoCapture backend for the FOURCC with CAP_PROP_CONVERT_RGB off, so OpenCV
+// hands over the driver's buffer instead of converting it to BGR. Backends that refuse fall back to BGR.
+class FrameSource
+{
+public:
+    FrameSource();
+    ~FrameSource();
+
+    // Open a camera, preferring the given format
+    bool open(int camera, CaptureFormat preferred);
+
+    // Open a file of raw frames (concatenated YUYV or NV12 images of the given size)
+    bool openRaw(const std::filesystem::path &path, cv::Size size, CaptureFormat format);
+
+    // Attach to a shared-memory frame ring (FrameRingWriter); frames are views into the ring
+    bool openRing(const std::string &name);
+
+    // Next frame; false on a camera error, at the end of a raw file or when the ring producer stops
+    bool read(CapturedFrame &frame);
+
+    // Ring input: false once the producer has overwritten the last frame read (always true otherwise)
+    bool isCurrent() const;
+    // Ring input: frames skipped because newer ones were already published
+    std::uint64_t skippedFrames() const { return skipped; }
+
+    bool isOpened() const { return capture.isOpened() || rawFile.is_open() || ring; }
+    CaptureFormat format() const { return activeFormat; }
+    cv::Size size() const { return frameSize; }
+
+private:
+    // Bytes of one raw frame
+    size_t rawFrameBytes() const;
+
+    cv::VideoCapture capture;
+    std::ifstream rawFile;
+    std::unique_ptr<FrameRingReader> ring;
+    std::uint64_t ringSequence = 0; // Last frame read from the ring
+    std::uint64_t skipped = 0;
+    CaptureFormat activeFormat = CaptureFormat::BGR;
+    cv::Size frameSize;
+};
@@ -27,6 +27,16 @@ namespace ar
     bool loadCalibrationData(const std::filesystem::path &path,
                              cv::Mat &cameraMatrix,
                              cv::Mat &distCoeffs)
+    {
+        cv::Size imageSize;
+        return loadCalibrationData(path, cameraMatrix, distCoeffs, imageSize);
+    }
+
+    // Load calibration data and the calibrated image size from JSON file
+    bool loadCalibrationData(const std::filesystem::path &path,
+                             cv::Mat &cameraMatrix,
+                             cv::Mat &distCoeffs,
+                             cv::Size &imageSize)
     {
         if (!std::filesystem::exists(path))
         {
@@ -44,6 +54,11 @@ namespace ar
 
         cameraMatrix = jsonToMat(data["camera_matrix"]);
         distCoeffs = jsonToMat(data["distortion_coefficients"]);
+        imageSize = cv::Size();
+        if (data.contains("image_size"))
+        {
+            imageSize = cv::Size(data["image_size"][0].get<int>(), data["image_size"][1].get<int>());
+        }
 
         return !cameraMatrix.empty() && !distCoeffs.empty();
     }
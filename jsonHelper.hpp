@@ -11,6 +11,12 @@ namespace ar
     bool loadCalibrationData(const std::filesystem::path &path,
                              cv::Mat &cameraMatrix,
                              cv::Mat &distCoeffs);
+
+    // Same, plus the calibrated image size (empty when the file does not record it)
+    bool loadCalibrationData(const std::filesystem::path &path,
+                             cv::Mat &cameraMatrix,
+                             cv::Mat &distCoeffs,
+                             cv::Size &imageSize);
 } // namespace ar
 
 #endif // JSON_HELPERS_HPP
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer / single-consumer slot that always holds the newest value.
+// Triple buffering: the producer fills its back buffer and swaps it with the shared middle one,
+// the consumer swaps the middle into its front buffer when something new was published.
+// Neither side ever blocks or sees a half-written value; values the consumer missed are dropped.
+template <typename T>
+class LatestValue
+{
+public:
+    // Producer: publish a new value
+    void publish(T value)
+    {
+        buffers[back] = std::move(value);
+        // Hand the back buffer over as the middle one and mark it fresh
+        const std::uint8_t previous = middle.exchange(static_cast<std::uint8_t>(back | freshBit), std::memory_order_acq_rel);
+        back = previous & indexMask;
+    }
+
+    // Consumer: take the newest value if one was published since the last call
+    bool consume(T &value)
+    {
+        if (!(middle.load(std::memory_order_relaxed) & freshBit))
+            return false;
+        const std::uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & indexMask;
+        value = buffers[front];
+        return true;
+    }
+
+    // Consumer: the last value consume() returned
+    const T &current() const { return buffers[front]; }
+
+private:
+    static constexpr std::uint8_t freshBit = 0x4;
+    static constexpr std::uint8_t indexMask = 0x3;
+
+    T buffers[3];
+    std::uint8_t back = 0;               // Owned by the producer
+    std::uint8_t front = 1;              // Owned by the consumer
+    std::atomic<std::uint8_t> middle{2}; // Shared: buffer index | freshBit
+};
@@ -7,17 +7,24 @@
 int main()
 {
     bool useNft = true;          // Set to true to use NFT, false for chessboard
-    cv::VideoCapture capture(0); // Open camera here
+    std::string frameRing = "";  // Ring of an "ar_ring produce" process (e.g. "/ar_frames"); empty opens the camera here
+    cv::VideoCapture capture;
 
-    if (!capture.isOpened())
+    // With a frame ring the producer owns the camera
+    if (frameRing.empty())
     {
-        std::cerr << "Could not open camera!" << std::endl;
-        return -1;
+        capture.open(0); // Open camera here
+        if (!capture.isOpened())
+        {
+            std::cerr << "Could not open camera!" << std::endl;
+            return -1;
+        }
     }
 
     cv::Size patternSize(8, 6); // Number of inner corners per a chessboard row and column
     float squareSize = 25.0f;   // Set your physical square size here
     int requiredSamples = 15;   // Number of samples for calibration
+    bool autoSelect = false;    // Set to true to capture informative views automatically instead of on space
 
     // Check if calibration data exists; if not, run calibration
     // Build calibration folder path
@@ -27,7 +34,12 @@ int main()
     const std::filesystem::path calibrationJson = calibrationDir / "calibration.json";
     if (!std::filesystem::exists(calibrationJson))
     {
-        calibrateCamera(capture, requiredSamples, "calibration", patternSize, squareSize);
+        if (!frameRing.empty())
+        {
+            std::cerr << "No calibration at " << calibrationJson << "; calibrate with the camera or ar_calibrate first" << std::endl;
+            return -1;
+        }
+        calibrateCamera(capture, requiredSamples, "calibration", patternSize, squareSize, autoSelect);
     }
 
     // Check for reference image if using NFT
@@ -36,6 +48,11 @@ int main()
     {
         if (!std::filesystem::exists("data/reference/reference.png"))
         {
+            if (!frameRing.empty())
+            {
+                std::cerr << "No reference image at data/reference/reference.png" << std::endl;
+                return -1;
+            }
             std::cout << "No reference image found for NFT. Capturing one now." << std::endl;
             captureReferenceImage(capture, "data/reference/");
         }
@@ -43,7 +60,11 @@ int main()
 
     // Run augmentation loop
     // Last two parameters are subfolder names for saving results for experiments
-    augmentLoop(capture, useNft, patternSize, squareSize, "Demo", "Test");
+    // augmentLoop opens its own frame source, so the calibration camera has to be closed first
+    capture.release();
+    AugmentOptions options;
+    options.frameRing = frameRing;
+    augmentLoop(useNft, patternSize, squareSize, "Demo", "Test", options);
 
     return 0;
 }
\ No newline at end of file
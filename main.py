@@ -1,4 +1,3 @@
-import json
 import os
 import matplotlib.pyplot as plt
 import pandas as pd
@@ -7,6 +6,7 @@ import seaborn as sns
 # --- Configuration ---
 DPI = 300
 OUTPUT_DIR = "data/figures"
+ANALYTICS_DIR = "data/analytics"
 
 # Set a consistent color scheme
 COLORS = {'checkerboard': '#1f77b4', 'nft': '#ff7f0e'} # Blue vs Orange
@@ -15,27 +15,22 @@ def ensure_dir(directory):
     if not os.path.exists(directory):
         os.makedirs(directory)
 
-def load_json_df(filepath, test_type, method):
-    if not os.path.exists(filepath):
-        print(f"Warning: File {filepath} not found. Skipping.")
-        return None
-    
-    try:
-        with open(filepath, 'r') as f:
-            data = json.load(f)
-    except Exception as e:
-        print(f"Error reading {filepath}: {e}")
-        return None
-
-    frames = data.get("frames", [])
-    if not frames:
-        return None
-
-    df = pd.DataFrame(frames)
-    df['test_type'] = test_type
-    df['method'] = method
-    df['label'] = f"{method.capitalize()} ({test_type.capitalize()})"
-    return df
+def load_analytics():
+    """ Reads the tables written by ar_analytics (build/ar_analytics data/statistics) """
+    paths = [os.path.join(ANALYTICS_DIR, name) for name in ("sessions.csv", "frames.csv", "intervals.csv")]
+    missing = [p for p in paths if not os.path.exists(p)]
+    if missing:
+        print(f"Missing {', '.join(missing)}. Run ./build/ar_analytics first.")
+        return None, None
+
+    sessions = pd.read_csv(paths[0], usecols=['session', 'method', 'test'])
+    sessions = sessions.rename(columns={'test': 'test_type'})
+    sessions['label'] = sessions['method'].str.capitalize() + " (" + sessions['test_type'].str.capitalize() + ")"
+
+    frames = pd.read_csv(paths[1]).merge(sessions, on='session')
+    frames['success'] = frames['success'].astype(bool)
+    intervals = pd.read_csv(paths[2]).merge(sessions, on='session')
+    return frames, intervals
 
 def plot_performance_all(df):
     # Get unique test types to determine grid layout
@@ -136,7 +131,7 @@ def plot_stability_comparison(df):
     plt.close()
     print(f"Saved: {path}")
 
-def plot_robustness_gantt(df):
+def plot_robustness_gantt(df, intervals_df):
     """ 3. Gantt/Step chart for Occlusion, Lighting, Angle """
     tests = ['occlusion', 'lighting', 'angle']
     
@@ -150,35 +145,15 @@ def plot_robustness_gantt(df):
             ax.text(0.5, 0.5, "No Data", ha='center', va='center')
             continue
 
-        # Helper to calculate intervals
-        def get_intervals(data):
-            intervals = []
-            start = None
-            # Ensure sorted by frame_id
-            data = data.sort_values('frame_id')
-            
-            for _, row in data.iterrows():
-                fid = row['frame_id']
-                is_success = row['success']
-                
-                if is_success:
-                    if start is None:
-                        start = fid
-                else:
-                    if start is not None:
-                        intervals.append((start, fid - start))
-                        start = None
-            
-            # Close last interval if active
-            if start is not None:
-                last_fid = data.iloc[-1]['frame_id']
-                intervals.append((start, last_fid - start + 1))
-            return intervals
+        # Success intervals come precomputed from ar_analytics
+        def get_intervals(method):
+            rows = intervals_df[(intervals_df['test_type'] == test) & (intervals_df['method'] == method)]
+            return list(zip(rows['start'], rows['length']))
 
         # Plot Checkerboard Track (Top)
         chess_data = test_data[test_data['method'] == 'checkerboard']
         if not chess_data.empty:
-            intervals = get_intervals(chess_data)
+            intervals = get_intervals('checkerboard')
             if intervals:
                 # y=10, height=8
                 ax.broken_barh(intervals, (10, 8), facecolors=COLORS['checkerboard'], label='Checkerboard')
@@ -186,7 +161,7 @@ def plot_robustness_gantt(df):
         # Plot NFT Track (Bottom)
         nft_data = test_data[test_data['method'] == 'nft']
         if not nft_data.empty:
-            intervals = get_intervals(nft_data)
+            intervals = get_intervals('nft')
             if intervals:
                 # y=0, height=8
                 ax.broken_barh(intervals, (0, 8), facecolors=COLORS['nft'], label='NFT')
@@ -216,38 +191,16 @@ def plot_robustness_gantt(df):
 def main():
     ensure_dir(OUTPUT_DIR)
 
-    # Define the file map
-    # Structure: (FilePath, TestType, Method)
-    files = [
-        # Checkerboard
-        ("data/statistics/Checkerboard/detection_robustness/session_stats_checkerboard_angle.json", "angle", "checkerboard"),
-        ("data/statistics/Checkerboard/detection_robustness/session_stats_checkerboard_lighting.json", "lighting", "checkerboard"),
-        ("data/statistics/Checkerboard/detection_robustness/session_stats_checkerboard_occlusion.json", "occlusion", "checkerboard"),
-        ("data/statistics/Checkerboard/pose_stability/session_stats_checkerboard.json", "static", "checkerboard"),
-        # NFT
-        ("data/statistics/NFT/detection_robustness/session_stats_nft_angle.json", "angle", "nft"),
-        ("data/statistics/NFT/detection_robustness/session_stats_nft_lighting.json", "lighting", "nft"),
-        ("data/statistics/NFT/detection_robustness/session_stats_nft_occlusion.json", "occlusion", "nft"),
-        ("data/statistics/NFT/pose_stability/session_stats_nft.json", "static", "nft"),
-    ]
-
-    dfs = []
-    for path, test, method in files:
-        df = load_json_df(path, test, method)
-        if df is not None:
-            dfs.append(df)
-
-    if not dfs:
+    # Per-frame rows of every session, already tagged with method and test
+    all_data, intervals = load_analytics()
+    if all_data is None or all_data.empty:
         print("No valid data files loaded. Check paths.")
         return
 
-    # Merge all into one big dataframe
-    all_data = pd.concat(dfs, ignore_index=True)
-
     # Generate the 3 requested plots
     plot_performance_all(all_data)
     plot_stability_comparison(all_data)
-    plot_robustness_gantt(all_data)
+    plot_robustness_gantt(all_data, intervals)
 
     print("\nProcessing Complete.")
 
@@ -0,0 +1,34 @@
+#include "motion_gate.hpp"
+#include <algorithm>
+
+bool MotionGate::needsTracking(const cv::Mat &gray)
+{
+    const int width = std::max(8, std::min(options.thumbnailWidth, gray.cols));
+    const int height = std::max(1, gray.rows * width / std::max(1, gray.cols));
+    cv::resize(gray, thumbnail, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+
+    // Nothing to hold on to: no reference, a changed size or a lost target
+    if (!lastSuccess || reference.size() != thumbnail.size())
+    {
+        motion = 0.0;
+        return true;
+    }
+    motion = cv::norm(thumbnail, reference, cv::NORM_L1) / thumbnail.total();
+    if (motion > options.threshold)
+        return true;
+    if (sinceTracked >= options.maxSkipFrames)
+    {
+        forced++;
+        return true;
+    }
+    sinceTracked++;
+    return false;
+}
+
+void MotionGate::tracked(bool success)
+{
+    lastSuccess = success;
+    sinceTracked = 0;
+    // The new reference; swap keeps both buffers allocated
+    cv::swap(reference, thumbnail);
+}
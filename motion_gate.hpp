@@ -0,0 +1,40 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+
+// Settings of the motion gate
+struct MotionGateOptions
+{
+    int thumbnailWidth = 64;  // Width of the grey thumbnail frames are compared on (height keeps the aspect ratio)
+    double threshold = 1.5;   // Mean absolute thumbnail difference, in grey levels, that counts as motion
+    int maxSkipFrames = 30;   // Re-estimate after this many skipped frames even without motion
+};
+
+// Decides whether a frame needs the tracker or the previous pose still holds
+// Each frame is shrunk to a small area-averaged thumbnail (sensor noise averages out) and compared
+// with the thumbnail of the last frame the tracker ran on, not with the previous frame, so slow
+// drift adds up until it crosses the threshold. A failed last estimate, and every maxSkipFrames
+// skipped frames, force the tracker to run. The check costs a resize and a difference on a few
+// thousand pixels instead of a board search or ORB + RANSAC.
+class MotionGate
+{
+public:
+    explicit MotionGate(const MotionGateOptions &options = {}) : options(options) {}
+
+    // True when the tracker has to run on this frame (grey, any size)
+    bool needsTracking(const cv::Mat &gray);
+    // Result of the tracker on the frame last passed to needsTracking
+    void tracked(bool success);
+
+    double lastMotion() const { return motion; }  // Difference measured on the last frame
+    int forcedCount() const { return forced; }    // Re-estimates forced by maxSkipFrames
+
+    MotionGateOptions options;
+
+private:
+    cv::Mat thumbnail;         // Thumbnail of the current frame
+    cv::Mat reference;         // Thumbnail of the last tracked frame
+    bool lastSuccess = false;  // Last estimate succeeded
+    int sinceTracked = 0;      // Frames skipped since the tracker last ran
+    double motion = 0.0;
+    int forced = 0;
+};
@@ -0,0 +1,303 @@
+#include "multi_camera.hpp"
+#include "batch_processor.hpp"
+#include "calibration_store.hpp"
+#include "frame_preprocessor.hpp"
+#include "frame_reader.hpp"
+#include "frame_source.hpp"
+#include "statistics.hpp"
+#include "tracker_factory.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+// Pin the calling thread to one core; false where unsupported
+static bool pinCurrentThread(unsigned core)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+// Calibration of a camera: explicit path, its own folder, then the shared folder keyed by pattern size
+static std::filesystem::path resolveCalibration(const CameraConfig &camera)
+{
+    if (!camera.calibrationPath.empty())
+        return camera.calibrationPath;
+    const std::filesystem::path own = std::filesystem::path("data/calibration") / camera.name / "calibration.json";
+    if (std::filesystem::exists(own))
+        return own;
+    std::string patternStr = std::to_string(camera.patternSize.width) + "x" + std::to_string(camera.patternSize.height);
+    return std::filesystem::path("data/calibration") / patternStr / "calibration.json";
+}
+
+CameraResult MultiCameraRunner::runCamera(const CameraConfig &camera, int core, const std::atomic<bool> &stop) const
+{
+    CameraResult result;
+    result.name = camera.name;
+    result.core = core;
+    result.calibration = resolveCalibration(camera);
+
+    CalibrationStore calibration;
+    bool loaded;
+    {
+        // Cameras sharing a calibration would race on its sidecar file
+        std::lock_guard<std::mutex> lock(calibrationMutex);
+        loaded = calibration.load(result.calibration);
+    }
+    if (!loaded)
+    {
+        std::cerr << camera.name << ": unable to read " << result.calibration << std::endl;
+        return result;
+    }
+    auto tracker = createTracker(camera.useNft, camera.patternSize, camera.squareSize, camera.referencePath);
+    tracker->showDebug = false; // No HighGUI windows from camera threads
+    tracker->solver = camera.solver;
+    tracker->setThreadPool(nullptr); // Stays on this (pinned) thread instead of the shared pool
+
+    // Recordings through FrameReader, live cameras and rings through FrameSource
+    std::unique_ptr<FrameReader> reader;
+    FrameSource source;
+    bool opened = false;
+    if (camera.device >= 0)
+        opened = source.open(camera.device, CaptureFormat::BGR);
+    else if (!camera.input.empty())
+    {
+        reader = std::make_unique<FrameReader>(camera.input);
+        opened = reader->isOpened();
+    }
+    else if (!camera.frameRing.empty())
+        opened = source.openRing(camera.frameRing);
+    if (!opened)
+    {
+        std::cerr << camera.name << ": unable to open its frame source" << std::endl;
+        return result;
+    }
+    result.opened = true;
+
+    // The pipeline of augmentLoop: BGR undistorted and tracked as a pinhole camera, YUV luma tracked with the real distortion
+    PreprocessOptions preprocessOptions;
+    preprocessOptions.uploadBuffer = false;
+    preprocessOptions.parallel = false; // Parallelism comes from running cameras side by side
+    FramePreprocessor preprocessor(preprocessOptions);
+    PreparedFrame prepared;
+    const cv::Mat zeroDist = cv::Mat::zeros(4, 1, CV_64F);
+    const ResolutionIntrinsics *intrinsics = nullptr;
+
+    SessionStats stats;
+    CapturedFrame captured;
+    cv::Mat undistorted;
+    const auto wallStart = std::chrono::steady_clock::now();
+    int index = 0;
+    while (!stop.load() && (options.maxFrames <= 0 || index < options.maxFrames))
+    {
+        if (reader)
+        {
+            captured.format = CaptureFormat::BGR;
+            if (!reader->read(captured.bgr))
+                break;
+            captured.size = captured.bgr.size();
+        }
+        else if (!source.read(captured))
+            break;
+        const double timestamp = reader ? reader->timestamp(index)
+                                        : std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        if (!intrinsics || captured.size != intrinsics->size)
+        {
+            std::lock_guard<std::mutex> lock(calibrationMutex);
+            intrinsics = &calibration.at(captured.size);
+        }
+        const cv::Mat *dist = &zeroDist;
+        if (captured.format == CaptureFormat::BGR)
+        {
+            cv::remap(captured.bgr, undistorted, intrinsics->map1, intrinsics->map2, cv::INTER_LINEAR);
+            preprocessor.process(undistorted, prepared);
+        }
+        else
+        {
+            preprocessor.processGray(captured.luma(), prepared);
+            dist = &calibration.distCoeffs;
+        }
+
+        cv::Mat rvec, tvec;
+        tracker->lastDiagnostics = PoseDiagnostics();
+        auto trackStart = std::chrono::high_resolution_clock::now();
+        bool success = tracker->estimatePose(prepared, intrinsics->cameraMatrix, *dist, rvec, tvec);
+        auto frameEnd = std::chrono::high_resolution_clock::now();
+        success = success && source.isCurrent(); // Ring slots are read in place
+
+        FrameStats frame{
+            index,
+            timestamp,
+            success,
+            ar::Pose::fromCv(rvec, tvec),
+            std::chrono::duration<double, std::milli>(frameEnd - frameStart).count()};
+        frame.solverIterations = tracker->lastDiagnostics.iterations;
+        frame.solveMs = tracker->lastDiagnostics.solveMs;
+        frame.warmStarted = tracker->lastDiagnostics.warmStarted;
+        frame.trackMs = std::chrono::duration<double, std::milli>(frameEnd - trackStart).count();
+        stats.frames.push_back(frame);
+        index++;
+    }
+
+    result.frames = static_cast<size_t>(index);
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    result.framesPerSecond = result.wallSeconds > 0 ? result.frames / result.wallSeconds : 0.0;
+    result.performance = stats.computePerformance();
+    result.robustness = stats.computeDetectionRobustness();
+
+    // Same format augmentLoop and ar_batch write
+    result.output = options.outputDir / (camera.name + ".json");
+    std::ofstream out(result.output);
+    if (out.is_open())
+        out << stats.toJson().dump(4);
+    else
+        std::cerr << "Unable to open " << result.output << " to save session statistics." << std::endl;
+    return result;
+}
+
+std::vector<CameraResult> MultiCameraRunner::run(const std::vector<CameraConfig> &cameras, const std::atomic<bool> &stop)
+{
+    std::filesystem::create_directories(options.outputDir);
+    std::vector<CameraResult> results(cameras.size());
+    std::vector<std::thread> threads;
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    if (cameras.size() > cores)
+        std::cerr << cameras.size() << " cameras on " << cores << " cores: per-camera throughput will drop" << std::endl;
+
+    for (size_t i = 0; i < cameras.size(); ++i)
+    {
+        threads.emplace_back([this, &cameras, &results, &stop, i, cores]
+                             {
+                                 const unsigned target = static_cast<unsigned>(i % cores);
+                                 const int core = options.pinThreads && pinCurrentThread(target) ? static_cast<int>(target) : -1;
+                                 results[i] = runCamera(cameras[i], core, stop); });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    return results;
+}
+
+nlohmann::json MultiCameraRunner::report(const std::vector<CameraResult> &results)
+{
+    nlohmann::json root;
+    root["cameras"] = nlohmann::json::array();
+    size_t totalFrames = 0;
+    double aggregateFps = 0.0;
+    std::vector<double> perCameraFps;
+    for (const auto &r : results)
+    {
+        root["cameras"].push_back({{"name", r.name},
+                                   {"calibration", r.calibration.string()},
+                                   {"session", r.output.string()},
+                                   {"opened", r.opened},
+                                   {"core", r.core},
+                                   {"frames", r.frames},
+                                   {"wall_seconds", r.wallSeconds},
+                                   {"fps", r.framesPerSecond},
+                                   {"performance", r.performance},
+                                   {"detection_robustness", r.robustness}});
+        if (!r.opened)
+            continue;
+        totalFrames += r.frames;
+        aggregateFps += r.framesPerSecond;
+        perCameraFps.push_back(r.framesPerSecond);
+    }
+
+    // Spread of per-camera throughput: min close to max means adding cameras did not slow the others
+    double minFps = 0.0, maxFps = 0.0, meanFps = 0.0;
+    if (!perCameraFps.empty())
+    {
+        minFps = *std::min_element(perCameraFps.begin(), perCameraFps.end());
+        maxFps = *std::max_element(perCameraFps.begin(), perCameraFps.end());
+        meanFps = aggregateFps / perCameraFps.size();
+    }
+    root["summary"] = {{"cameras", results.size()},
+                       {"cameras_running", perCameraFps.size()},
+                       {"cores", std::max(1u, std::thread::hardware_concurrency())},
+                       {"total_frames", totalFrames},
+                       {"aggregate_fps", aggregateFps},
+                       {"mean_camera_fps", meanFps},
+                       {"min_camera_fps", minFps},
+                       {"max_camera_fps", maxFps}};
+    return root;
+}
+
+bool loadCameraConfigs(const std::filesystem::path &path, std::vector<CameraConfig> &cameras)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        std::cerr << "Unable to open " << path << std::endl;
+        return false;
+    }
+    try
+    {
+        const nlohmann::json root = nlohmann::json::parse(in);
+        for (const auto &entry : root.at("cameras"))
+        {
+            CameraConfig camera;
+            camera.name = entry.value("name", "camera" + std::to_string(cameras.size()));
+            camera.device = entry.value("device", -1);
+            camera.input = entry.value("input", std::string());
+            camera.frameRing = entry.value("ring", std::string());
+            camera.calibrationPath = entry.value("calibration", std::string());
+            camera.useNft = entry.value("nft", false);
+            camera.squareSize = entry.value("square", camera.squareSize);
+            camera.referencePath = entry.value("reference", camera.referencePath);
+            if (entry.contains("pattern") && !parsePatternSize(entry["pattern"].get<std::string>(), camera.patternSize))
+            {
+                std::cerr << camera.name << ": invalid pattern size, expected WxH" << std::endl;
+                return false;
+            }
+            const std::string solver = entry.value("solver", std::string("opencv"));
+            if (solver == "opencv")
+                camera.solver = PoseSolver::OpenCV;
+            else if (solver == "robust")
+                camera.solver = PoseSolver::Robust;
+            else if (solver == "planar")
+                camera.solver = PoseSolver::Planar;
+            else if (solver == "temporal")
+                camera.solver = PoseSolver::Temporal;
+            else
+            {
+                std::cerr << camera.name << ": unknown solver " << solver << std::endl;
+                return false;
+            }
+            if (camera.device < 0 && camera.input.empty() && camera.frameRing.empty())
+            {
+                std::cerr << camera.name << ": needs a device, input or ring" << std::endl;
+                return false;
+            }
+            cameras.push_back(camera);
+        }
+        // Names become session file names
+        std::set<std::string> names;
+        for (const auto &camera : cameras)
+            if (!names.insert(camera.name).second)
+            {
+                std::cerr << "Camera name " << camera.name << " is used twice" << std::endl;
+                return false;
+            }
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+        std::cerr << "Invalid camera configuration " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "tracker.hpp"
+
+// One camera or recorded stream of a multi-camera run
+// The frame source is the first of device, input and frameRing that is set.
+struct CameraConfig
+{
+    std::string name;                                        // Label in the report, file name of its session
+    int device = -1;                                         // Camera index (-1: none)
+    std::filesystem::path input;                             // Video file or image directory
+    std::string frameRing;                                   // Shared-memory frame ring (ar_ring produce)
+    std::filesystem::path calibrationPath;                   // Empty: data/calibration/<name>, then data/calibration/<WxH>
+    bool useNft = false;                                     // NFT or chessboard tracking
+    PoseSolver solver = PoseSolver::OpenCV;                  // Pose solver of the tracker
+    cv::Size patternSize{8, 6};                              // Inner corners of the chessboard
+    float squareSize = 25.0f;                                // Physical square size
+    std::string referencePath = "data/reference/reference.png"; // NFT reference image
+};
+
+// Settings of a multi-camera run
+struct MultiCameraOptions
+{
+    std::filesystem::path outputDir = "data/statistics/MultiCamera"; // Per-camera sessions and the aggregated report
+    int maxFrames = 0;     // Frames per camera (0: until the source ends)
+    bool pinThreads = true; // Pin camera i to core i % cores (Linux)
+};
+
+// Outcome of one camera
+struct CameraResult
+{
+    std::string name;
+    std::filesystem::path calibration; // calibration.json used
+    std::filesystem::path output;      // Written session statistics
+    bool opened = false;               // Calibration, tracker and source were ready
+    int core = -1;                     // Core the camera thread was pinned to (-1: not pinned)
+    size_t frames = 0;                 // Frames processed
+    double wallSeconds = 0.0;          // First frame to last
+    double framesPerSecond = 0.0;      // Throughput
+    nlohmann::json performance;        // SessionStats::computePerformance of the session
+    nlohmann::json robustness;         // SessionStats::computeDetectionRobustness of the session
+};
+
+// Runs several cameras at once, each on its own thread with its own calibration, tracker and
+// statistics session. A camera pipeline is sequential (read, undistort, track), so one thread per
+// camera keeps cameras from contending for a shared pool; threads are spread over the cores.
+// Trackers run their parallel stages (robust PnP, grid FAST, ChESS) serially on that thread.
+class MultiCameraRunner
+{
+public:
+    explicit MultiCameraRunner(const MultiCameraOptions &options = {}) : options(options) {}
+
+    // Run every camera until its source ends, maxFrames or stop; writes <outputDir>/<name>.json for each
+    std::vector<CameraResult> run(const std::vector<CameraConfig> &cameras, const std::atomic<bool> &stop);
+
+    // Aggregated report: every camera's summary plus totals and the per-camera throughput spread
+    static nlohmann::json report(const std::vector<CameraResult> &results);
+
+    MultiCameraOptions options;
+
+private:
+    CameraResult runCamera(const CameraConfig &camera, int core, const std::atomic<bool> &stop) const;
+
+    mutable std::mutex calibrationMutex; // CalibrationStore writes its sidecar next to calibration.json
+};
+
+// Read cameras from a JSON file: {"cameras": [{"name": ..., "device" | "input" | "ring": ..., "calibration": ...,
+// "nft": ..., "pattern": "8x6", "square": ..., "reference": ..., "solver": "opencv" | "robust" | "planar" | "temporal"}]}
+bool loadCameraConfigs(const std::filesystem::path &path, std::vector<CameraConfig> &cameras);
@@ -1,6 +1,25 @@
+#pragma once
 #include "tracker.hpp"
+#include "robust_pose.hpp"
+#include "planar_pose.hpp"
+#include "temporal_pose.hpp"
+#include "feature_grid.hpp"
+#include "reference_database.hpp"
 #include <opencv2/features2d.hpp>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
+
+// Correspondences between the reference image and one frame
+struct NFTMatches
+{
+    std::vector<cv::KeyPoint> keypoints;   // Keypoints detected in the frame
+    std::vector<cv::DMatch> matches;       // Matches that passed the ratio test
+    std::vector<cv::Point3f> objectPoints; // Reference points of the matches
+    std::vector<cv::Point2f> imagePoints;  // Frame points of the matches
+    std::vector<float> distances;          // Descriptor distance of each match (lower is better)
+};
 
 // Implements pose estimation using Natural Feature Tracking (NFT)
 class NFTTracker : public PoseTracker
@@ -11,15 +30,141 @@ class NFTTracker : public PoseTracker
     std::vector<cv::KeyPoint> refKeypoints;   // Keypoints of reference image
     std::vector<cv::Point3f> refObjectPoints; // The "3D" representation of the image pixels
 
-    cv::Ptr<cv::Feature2D> detector;        // Feature detector (ORB)
+    cv::Ptr<cv::ORB> detector;              // Feature detector
     cv::Ptr<cv::DescriptorMatcher> matcher; // Descriptor matcher
 
     // Scale factor to convert pixels to "World Units"
     float scaleFactor = 0.1f;
 
+    bool hasPrior = false; // Last call produced a pose (seeds the robust solver)
+    GridFeatureExtractor grid; // Used when gridFeatures is set
+
+    std::shared_ptr<const ReferenceDatabase> database; // Multi-scale / multi-view features (built on first use)
+    std::vector<cv::Point3f> databaseObjectPoints;     // Object point of every database feature
+    size_t probeCursor = 0;                            // Rotation through the tilted views while lost
+    cv::Mat priorRvec, priorTvec, priorCamera;     // Last accepted pose, picks the database views
+
+    // Reference pixel -> object point (origin at the image center)
+    cv::Point3f toObjectPoint(const cv::Point2f &pt) const
+    {
+        return cv::Point3f((pt.x - refImage.cols * 0.5f) * scaleFactor, (pt.y - refImage.rows * 0.5f) * scaleFactor, 0.0f);
+    }
+
+    // Local affine of the reference around its center under the prior pose (reference pixels -> frame pixels)
+    cv::Matx22d priorJacobian() const
+    {
+        cv::Matx33d R;
+        cv::Rodrigues(priorRvec, R);
+        const cv::Vec3d t = priorTvec;
+        const cv::Matx33d K = priorCamera;
+        const double cx = refImage.cols * 0.5, cy = refImage.rows * 0.5;
+        const cv::Matx33d H = K * cv::Matx33d(R(0, 0), R(0, 1), t[0], R(1, 0), R(1, 1), t[1], R(2, 0), R(2, 1), t[2]) *
+                              cv::Matx33d(scaleFactor, 0, -cx * scaleFactor, 0, scaleFactor, -cy * scaleFactor, 0, 0, 1);
+        const cv::Vec3d p = H * cv::Vec3d(cx, cy, 1.0);
+        cv::Matx22d J;
+        for (int i = 0; i < 2; ++i)
+            for (int j = 0; j < 2; ++j)
+                J(i, j) = (H(i, j) - p[i] / p[2] * H(2, j)) / p[2];
+        return J;
+    }
+
+    // Match against the database views consistent with the prior pose, or the probe set while lost.
+    // Views overlap, so each frame keypoint keeps only its closest reference feature.
+    void matchDatabase(const cv::Mat &currDescriptors, NFTMatches &out)
+    {
+        if (!database)
+            buildDatabase();
+
+        const std::vector<int> views = hasPrior && !priorRvec.empty() ? database->select(priorJacobian()) : database->probe(probeCursor);
+        std::vector<int> slot(out.keypoints.size(), -1);
+        std::vector<cv::DMatch> kept;
+        for (int id : views)
+        {
+            const ReferenceView &view = database->views[id];
+            if (view.end == view.begin)
+                continue;
+            std::vector<std::vector<cv::DMatch>> knn_matches;
+            matcher->knnMatch(database->descriptors.rowRange(view.begin, view.end), currDescriptors, knn_matches, 2);
+            for (const auto &match_pair : knn_matches)
+            {
+                if (match_pair.size() < 2 || match_pair[0].distance >= quality.matchRatio * match_pair[1].distance)
+                    continue;
+                cv::DMatch match = match_pair[0];
+                match.queryIdx += view.begin; // Row in the whole database
+                int &index = slot[match.trainIdx];
+                if (index < 0)
+                {
+                    index = static_cast<int>(kept.size());
+                    kept.push_back(match);
+                }
+                else if (match.distance < kept[index].distance)
+                    kept[index] = match;
+            }
+        }
+
+        for (const auto &match : kept)
+        {
+            out.matches.push_back(match);
+            out.objectPoints.push_back(databaseObjectPoints[match.queryIdx]);
+            out.imagePoints.push_back(out.keypoints[match.trainIdx].pt);
+            out.distances.push_back(match.distance);
+        }
+    }
+
 public:
+    // Robust solver (same iterations / threshold / inlier count as the solvePnPRansac call)
+    RobustPoseEstimator robust;
+    // Planar solver (RANSAC homography with the same threshold)
+    PlanarPoseEstimator planar{PlanarPoseOptions{true, 8.0, 3, 8}};
+    // Warm-started solver, gated to matches within the RANSAC threshold of the predicted pose
+    TemporalPoseSolver temporal{TemporalPoseOptions{true, 2, 10, 8.0, 8, 4.0}};
+    // Frame features from the tile-parallel grid extractor instead of a single ORB pass
+    // (the reference keeps plain ORB; the descriptors are the same)
+    bool gridFeatures = false;
+    GridFeatureOptions gridOptions; // Its budget is capped by quality.orbFeatures
+    // Match against synthetic zoom-outs and affine tilts of the reference, searching only the views
+    // closest to the previous pose (better at distance and at steep angles, fewer descriptors per frame)
+    bool multiView = false;
+    ReferenceDatabaseOptions databaseOptions;
+
     NFTTracker(std::string path) : imagePath(path) {}
 
+    // Object units per reference pixel (object points are centred on the reference)
+    float objectScale() const { return scaleFactor; }
+
+    // Build the multi-view database now instead of on the first frame
+    void buildDatabase()
+    {
+        auto built = std::make_shared<ReferenceDatabase>(databaseOptions);
+        built->build(refImage);
+        useDatabase(built);
+    }
+
+    // Use a database built by another tracker of the same reference (read-only, safe to share across threads)
+    void useDatabase(std::shared_ptr<const ReferenceDatabase> shared)
+    {
+        database = std::move(shared);
+        databaseObjectPoints.clear();
+        for (const auto &kp : database->keypoints)
+            databaseObjectPoints.push_back(toObjectPoint(kp.pt));
+        probeCursor = 0;
+    }
+
+    std::shared_ptr<const ReferenceDatabase> sharedDatabase() const { return database; }
+
+    void setThreadPool(ThreadPool *pool) override
+    {
+        grid = GridFeatureExtractor(grid.options, pool);
+        robust = RobustPoseEstimator(robust.options, pool);
+    }
+
+    // Forget the previous pose so the next frame solves from scratch
+    void lostTrack()
+    {
+        hasPrior = false;
+        temporal.reset();
+    }
+
     void init() override
     {
         // Load Reference Image
@@ -49,69 +194,170 @@ public:
         }
     }
 
-    bool estimatePose(const cv::Mat &frame, const cv::Mat &camMat, const cv::Mat &dist, cv::Mat &rvec, cv::Mat &tvec) override
+    // Detect features in a grayscale frame and match them against the reference
+    // imageScale maps gray back to frame coordinates (2 for the half-resolution level)
+    bool matchFrame(const cv::Mat &gray, NFTMatches &out, float imageScale = 1.0f)
     {
-        // convert to grayscale
-        cv::Mat gray;
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        out = NFTMatches();
 
         // Detect features in current frame
-        std::vector<cv::KeyPoint> currKeypoints;
         // Compute descriptors
+        // (feature budget of the current quality level; the reference keeps its full set)
         cv::Mat currDescriptors;
-        detector->detectAndCompute(gray, cv::noArray(), currKeypoints, currDescriptors);
+        if (gridFeatures)
+        {
+            grid.options = gridOptions;
+            grid.options.maxFeatures = std::min(gridOptions.maxFeatures, quality.orbFeatures);
+            grid.options.levels = quality.orbLevels;
+            grid.detectAndCompute(gray, out.keypoints, currDescriptors);
+        }
+        else
+        {
+            detector->setMaxFeatures(quality.orbFeatures);
+            detector->setNLevels(quality.orbLevels);
+            detector->detectAndCompute(gray, cv::noArray(), out.keypoints, currDescriptors);
+        }
+        if (imageScale != 1.0f)
+        {
+            const float offset = 0.5f * (imageScale - 1.0f); // Pixel centers of the level back to full resolution
+            for (auto &kp : out.keypoints)
+            {
+                kp.pt = kp.pt * imageScale + cv::Point2f(offset, offset);
+                kp.size *= imageScale;
+            }
+        }
 
         if (currDescriptors.empty())
             return false;
 
+        if (multiView)
+        {
+            matchDatabase(currDescriptors, out);
+            return true;
+        }
+
         // Match against reference
         std::vector<std::vector<cv::DMatch>> knn_matches;
         matcher->knnMatch(refDescriptors, currDescriptors, knn_matches, 2);
 
         // Filter good matches (Simple distance check)
-        std::vector<cv::DMatch> goodMatches;
-        std::vector<cv::Point3f> goodObjectPoints;
-        std::vector<cv::Point2f> goodScenePoints;
-
-        const float ratio_thresh = 0.75f; // Lowe's ratio test
+        const float ratio_thresh = quality.matchRatio; // Lowe's ratio test
         for (const auto &match_pair : knn_matches)
         {
             if (match_pair.size() == 2 && match_pair[0].distance < ratio_thresh * match_pair[1].distance)
             {
                 // map the 3D point of the Reference to the 2D point of the Scene
-                goodMatches.push_back(match_pair[0]);
-                goodObjectPoints.push_back(refObjectPoints[match_pair[0].queryIdx]);
-                goodScenePoints.push_back(currKeypoints[match_pair[0].trainIdx].pt);
+                out.matches.push_back(match_pair[0]);
+                out.objectPoints.push_back(refObjectPoints[match_pair[0].queryIdx]);
+                out.imagePoints.push_back(out.keypoints[match_pair[0].trainIdx].pt);
+                out.distances.push_back(match_pair[0].distance);
             }
         }
+        return true;
+    }
 
-        // RANSAC & PnP
-        // We need at least 4 points to solve PnP, but ask for 10 for stability
-        if (goodScenePoints.size() < 10)
-            return false;
+    // Solve the pose from matched correspondences with the selected solver
+    bool solvePose(const NFTMatches &m, const cv::Mat &camMat, const cv::Mat &dist, cv::Mat &rvec, cv::Mat &tvec)
+    {
+        auto solveStart = std::chrono::high_resolution_clock::now();
+        bool success = false;
+        int inlierCount = 0;
 
-        // Draw the matches visually
-        drawMatches(refImage, refKeypoints, frame, currKeypoints, goodMatches);
+        if (solver == PoseSolver::Temporal)
+        {
+            // Refine from the previous pose; cold RANSAC below on the first frame or on divergence
+            TemporalPoseResult result = temporal.refine(m.objectPoints, m.imagePoints, camMat, dist, rvec, tvec);
+            success = result.success;
+            inlierCount = result.inliers;
+            lastDiagnostics.warmStarted = result.success;
+            lastDiagnostics.iterations = result.iterations;
+        }
 
-        // solvePnPRansac is robust against outliers
-        // It will return the inliers used for the final pose estimation
-        cv::Mat inlierMask;
-        bool success = cv::solvePnPRansac(goodObjectPoints, goodScenePoints, camMat, dist, rvec, tvec, false, 100, 8.0f, 0.99, inlierMask);
+        if (solver == PoseSolver::Robust)
+        {
+            // Parallel PROSAC, skipped when the previous pose still fits
+            robust.options.maxIterations = quality.ransacIterations;
+            RobustPoseResult result = robust.estimate(m.objectPoints, m.imagePoints, m.distances, camMat, dist, rvec, tvec, hasPrior);
+            success = result.success;
+            inlierCount = result.inliers;
+            lastDiagnostics.hypotheses = result.hypotheses;
+            lastDiagnostics.reusedPrior = result.reusedPrior;
+        }
+        else if (solver == PoseSolver::Planar)
+        {
+            // The reference is a flat image, so a homography explains every inlier
+            PlanarPoseResult result = planar.estimate(m.objectPoints, m.imagePoints, camMat, dist, rvec, tvec);
+            success = result.success;
+            inlierCount = result.inliers;
+            lastDiagnostics.iterations = result.iterations;
+        }
+        else if (!success)
+        {
+            // solvePnPRansac is robust against outliers (also the cold start of the temporal solver)
+            // It will return the inliers used for the final pose estimation
+            cv::Mat inlierMask;
+            success = cv::solvePnPRansac(m.objectPoints, m.imagePoints, camMat, dist, rvec, tvec, false, quality.ransacIterations, 8.0f, 0.99, inlierMask);
+            inlierCount = cv::countNonZero(inlierMask);
+        }
+
+        lastDiagnostics.inliers = inlierCount;
+        lastDiagnostics.solveMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - solveStart).count();
 
-        int inlierCount = cv::countNonZero(inlierMask);
+        // Reject if too few inliers
+        if (success && inlierCount < 8)
+            success = false;
 
+        hasPrior = success;
         if (success)
         {
-            // Reject if too few inliers
-            if (inlierCount < 8)
-            {
-                return false;
-            }
+            priorRvec = rvec.clone();
+            priorTvec = tvec.clone();
+            priorCamera = camMat;
+        }
+        if (solver == PoseSolver::Temporal)
+        {
+            if (success)
+                temporal.update(rvec, tvec);
+            else
+                temporal.reset();
         }
-
         return success;
     }
 
+    bool estimatePose(const cv::Mat &frame, const cv::Mat &camMat, const cv::Mat &dist, cv::Mat &rvec, cv::Mat &tvec) override
+    {
+        // convert to grayscale
+        return estimatePose(PreparedFrame::fromColor(frame), camMat, dist, rvec, tvec);
+    }
+
+    bool estimatePose(const PreparedFrame &frame, const cv::Mat &camMat, const cv::Mat &dist, cv::Mat &rvec, cv::Mat &tvec) override
+    {
+        lastDiagnostics = PoseDiagnostics();
+
+        NFTMatches m;
+        const bool half = quality.halfResolution && !frame.grayHalf.empty();
+        if (!matchFrame(half ? frame.grayHalf : frame.gray, m, half ? 2.0f : 1.0f))
+        {
+            lostTrack();
+            return false;
+        }
+        lastDiagnostics.correspondences = static_cast<int>(m.imagePoints.size());
+
+        // RANSAC & PnP
+        // We need at least 4 points to solve PnP, but ask for 10 for stability
+        if (m.imagePoints.size() < 10)
+        {
+            lostTrack();
+            return false;
+        }
+
+        // Draw the matches visually
+        if (showDebug)
+            drawMatches(refImage, multiView && database ? database->keypoints : refKeypoints, frame.color.empty() ? frame.gray : frame.color, m.keypoints, m.matches);
+
+        return solvePose(m, camMat, dist, rvec, tvec);
+    }
+
     void drawMatches(const cv::Mat &refImage,
                      const std::vector<cv::KeyPoint> &refKeypoints,
                      const cv::Mat &frame,
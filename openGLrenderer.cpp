@@ -1,84 +1,17 @@
 #include "openGLrenderer.hpp"
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 
-// Helper function implementations (compileShader, createShaderProgram)
-// These read shader files and compile them
-GLuint Renderer::compileShader(const char *filepath, GLenum type)
-{
-    // Read shader source from file
-    std::ifstream file(filepath);
-    if (!file.is_open())
-    {
-        std::cerr << "Failed to open shader file: " << filepath << std::endl;
-        return 0;
-    }
-    // Read file contents into a string
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
-    const char *src_c_str = source.c_str();
-
-    // Compile shader
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &src_c_str, NULL);
-    glCompileShader(shader);
-
-    // Check for compilation errors
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "Error compiling shader (" << filepath << "): " << infoLog << std::endl;
-        return 0;
-    }
-
-    return shader;
-}
-
-GLuint Renderer::createShaderProgram(const char *vertPath, const char *fragPath)
-{
-    // Compile vertex and fragment shaders
-    GLuint vertexShader = compileShader(vertPath, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragPath, GL_FRAGMENT_SHADER);
-    if (vertexShader == 0 || fragmentShader == 0)
-        return 0;
-
-    // Link shaders into a program
-    GLuint shaderProgram = glCreateProgram();      // Create program
-    glAttachShader(shaderProgram, vertexShader);   // Attach vertex shader
-    glAttachShader(shaderProgram, fragmentShader); // Attach fragment shader
-    glLinkProgram(shaderProgram);                  // Link program
-
-    // Check for linking errors
-    GLint success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "Error linking shader program: " << infoLog << std::endl;
-        return 0;
-    }
-    // Clean up shaders as they're linked into the program now
-    glDeleteShader(vertexShader);   // Delete vertex shader
-    glDeleteShader(fragmentShader); // Delete fragment shader
-
-    return shaderProgram;
-}
-
-// Use the macro defined in CMake
-std::string shaderDir = std::string(PROJECT_ROOT) + "/shaders/";
-
 Renderer::Renderer(int width, int height) : screenWidth(width), screenHeight(height)
 {
+    // All programs are queued first: they compile in the background (or load from the cache)
+    // while the buffers are set up, and are waited for at the end
+    backgroundShader = programs.add("background.vert", "background.frag");
+    // YUV background: same quad, planes and undistortion map are allocated on first use
+    yuvShader = programs.add("background.vert", "background_yuv.frag");
+    cubeShader = programs.add("cube.vert", "cube.frag");
+
     // -- SETUP FOR BACKGROUND RENDERING --
-    // Load and compile background shaders
-    backgroundShader = createShaderProgram((shaderDir + "background.vert").c_str(), (shaderDir + "background.frag").c_str());
     // Fullscreen quad vertices (x, y, u, v)
     float quadVertices[] = {
         // x, y, u, v
@@ -108,8 +41,6 @@ Renderer::Renderer(int width, int height) : screenWidth(width), screenHeight(hei
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, screenWidth, screenHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL); // Allocate texture
 
     // -- SETUP FOR CUBE RENDERING --
-    // Load and compile cube shaders
-    cubeShader = createShaderProgram((shaderDir + "cube.vert").c_str(), (shaderDir + "cube.frag").c_str());
     // Cube vertices (x, y, z, r, g, b)
     float cubeVertices[] = {
         // positions            // colors
@@ -178,6 +109,12 @@ Renderer::Renderer(int width, int height) : screenWidth(width), screenHeight(hei
 
     // Enable depth testing for 3D cube rendering
     glEnable(GL_DEPTH_TEST);
+
+    // Shader programs
+    if (!programs.finish())
+        std::cerr << "Some shader programs failed to build." << std::endl;
+    std::cout << "Shader programs: " << programs.cachedCount() << " from cache, " << programs.compiledCount()
+              << " compiled (" << programs.buildMs() << " ms)" << std::endl;
 }
 
 // Destructor to clean up OpenGL resources
@@ -191,11 +128,16 @@ Renderer::~Renderer()
     glDeleteVertexArrays(1, &cubeVAO);       // Delete cube VAO
     glDeleteBuffers(1, &cubeVBO);            // Delete cube VBO
     glDeleteProgram(cubeShader);             // Delete cube shader program
+    glDeleteProgram(yuvShader);              // Delete YUV background shader program
+    glDeleteTextures(1, &lumaTexture);       // Delete YUV plane textures (0 is ignored)
+    glDeleteTextures(1, &chromaTexture);
+    glDeleteTextures(1, &undistortTexture);
 }
 
 // Update the background texture with a new camera frame
 void Renderer::updateBackground(const cv::Mat &frame)
 {
+    yuvBackground = false;
     // Convert BGR to RGB
     cv::Mat rgb;
     // Convert the color space from BGR to RGB
@@ -209,6 +151,87 @@ void Renderer::updateBackground(const cv::Mat &frame)
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, screenWidth, screenHeight, GL_RGB, GL_UNSIGNED_BYTE, rgb.data);
 }
 
+void Renderer::updateBackground(const PreparedFrame &frame)
+{
+    if (frame.upload.empty())
+    {
+        updateBackground(frame.color);
+        return;
+    }
+    yuvBackground = false;
+    // Already RGB and bottom-up
+    glBindTexture(GL_TEXTURE_2D, cameraTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, screenWidth, screenHeight, GL_RGB, GL_UNSIGNED_BYTE, frame.upload.data);
+}
+
+// Texture for raw planes / maps: exact texel fetches, no filtering
+static GLuint createFetchTexture()
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+void Renderer::updateBackground(const CapturedFrame &frame)
+{
+    if (frame.format == CaptureFormat::BGR)
+    {
+        yuvBackground = false;
+        updateBackground(frame.bgr);
+        return;
+    }
+
+    const int w = frame.size.width, h = frame.size.height;
+    const bool reallocate = frame.size != yuvSize || frame.format != yuvFormat;
+    if (!lumaTexture)
+        lumaTexture = createFetchTexture();
+    if (!chromaTexture)
+        chromaTexture = createFetchTexture();
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Plane rows are tightly packed bytes
+    glBindTexture(GL_TEXTURE_2D, lumaTexture);
+    if (frame.format == CaptureFormat::YUYV)
+    {
+        // One RGBA texel per pixel pair: (Y0, U, Y1, V)
+        if (reallocate)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w / 2, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w / 2, h, GL_RGBA, GL_UNSIGNED_BYTE, frame.raw.data);
+    }
+    else
+    {
+        // Y plane, then the interleaved UV plane right after it
+        if (reallocate)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED, GL_UNSIGNED_BYTE, frame.raw.data);
+        glBindTexture(GL_TEXTURE_2D, chromaTexture);
+        if (reallocate)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, w / 2, h / 2, 0, GL_RG, GL_UNSIGNED_BYTE, NULL);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w / 2, h / 2, GL_RG, GL_UNSIGNED_BYTE, frame.raw.ptr(h));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    yuvSize = frame.size;
+    yuvFormat = frame.format;
+    yuvBackground = true;
+}
+
+void Renderer::setUndistortMap(const cv::Mat &map)
+{
+    undistortYuv = !map.empty();
+    if (!undistortYuv)
+        return;
+    CV_Assert(map.type() == CV_32FC2 && map.isContinuous());
+    if (!undistortTexture)
+        undistortTexture = createFetchTexture();
+    glBindTexture(GL_TEXTURE_2D, undistortTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, map.cols, map.rows, 0, GL_RG, GL_FLOAT, map.data);
+}
+
 // Draw the background quad with the camera texture
 // Difference between this and updateBackground is that this actually renders it
 // While updateBackground just updates the texture data
@@ -216,6 +239,27 @@ void Renderer::drawBackground()
 {
     // Disable depth test for background
     glDisable(GL_DEPTH_TEST);
+    if (yuvBackground)
+    {
+        // Planes on units 0 / 1, undistortion map on unit 2
+        glUseProgram(yuvShader);
+        glUniform1i(glGetUniformLocation(yuvShader, "lumaTexture"), 0);
+        glUniform1i(glGetUniformLocation(yuvShader, "chromaTexture"), 1);
+        glUniform1i(glGetUniformLocation(yuvShader, "undistortMap"), 2);
+        glUniform1i(glGetUniformLocation(yuvShader, "format"), yuvFormat == CaptureFormat::NV12 ? 1 : 0);
+        glUniform1i(glGetUniformLocation(yuvShader, "undistort"), undistortYuv ? 1 : 0);
+        glUniform2f(glGetUniformLocation(yuvShader, "frameSize"), static_cast<float>(yuvSize.width), static_cast<float>(yuvSize.height));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, lumaTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, chromaTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, undistortTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(backgroundVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        return;
+    }
     // Use the background shader program
     glUseProgram(backgroundShader);
     // Bind the background VAO and texture
@@ -227,7 +271,7 @@ void Renderer::drawBackground()
 }
 
 // Draw the cube with given modelview and projection matrices
-void Renderer::drawCube(const double *modelViewMatrix, const GLfloat *projectionMatrix)
+void Renderer::drawCube(const ar::Mat4 &modelViewMatrix, const GLfloat *projectionMatrix)
 {
     static int debugFrameCounter = 0;
     if (debugFrameCounter++ % 60 == 0)
@@ -248,54 +292,26 @@ void Renderer::drawCube(const double *modelViewMatrix, const GLfloat *projection
         {
             std::cout << "[ ";
             for (int j = 0; j < 4; j++)
-                std::cout << modelViewMatrix[i + j * 4] << "\t";
+                std::cout << modelViewMatrix(i, j) << "\t";
             std::cout << "]" << std::endl;
         }
 
         // Specific check for Translation (last column of ModelView)
-        double tx = modelViewMatrix[12]; // X translation
-        double ty = modelViewMatrix[13]; // Y translation
-        double tz = modelViewMatrix[14]; // Z translation
+        double tx = modelViewMatrix(0, 3); // X translation
+        double ty = modelViewMatrix(1, 3); // Y translation
+        double tz = modelViewMatrix(2, 3); // Z translation
         std::cout << "Translation (Tvec): " << tx << ", " << ty << ", " << tz << std::endl;
     }
 
     glEnable(GL_DEPTH_TEST);  // Enable depth test for cube rendering
     glUseProgram(cubeShader); // Use the cube shader program
 
-    // Use double precision for all matrix math
-    double modelViewMatrixD[16];  // Copy input float matrices to double
-    double projectionMatrixD[16]; // Copy input float matrices to double
-    // Copy input float matrices to double
-    for (int i = 0; i < 16; ++i)
-    {
-        modelViewMatrixD[i] = static_cast<double>(modelViewMatrix[i]);   // Copy modelViewMatrix
-        projectionMatrixD[i] = static_cast<double>(projectionMatrix[i]); // Copy projectionMatrix
-    }
-
-    // Compute Model-View-Projection (MVP) matrix in double
-    double mvpMatrixD[16] = {0};
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j < 4; j++)
-        {
-            mvpMatrixD[i + j * 4] = 0.0;
-            for (int k = 0; k < 4; k++)
-            {
-                mvpMatrixD[i + j * 4] += projectionMatrixD[i + k * 4] * modelViewMatrixD[k + j * 4];
-            }
-        }
-    }
-
-    // Convert to float only at the last moment
-    GLfloat mvpMatrix[16];
-    for (int i = 0; i < 16; ++i)
-    {
-        mvpMatrix[i] = static_cast<GLfloat>(mvpMatrixD[i]);
-    }
+    // MVP in float, the precision the shader uses anyway
+    const ar::Mat4 mvpMatrix = ar::Mat4::fromColumnMajor(projectionMatrix) * modelViewMatrix;
 
     // Get uniform location for MVP
     GLint mvpLocation = glGetUniformLocation(cubeShader, "mvp");
-    glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, mvpMatrix); // Set the MVP matrix uniform
+    glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, mvpMatrix.data()); // Set the MVP matrix uniform
 
     glBindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36); // Draw the cube
@@ -1,6 +1,10 @@
 #pragma once
 #include <GL/glew.h>
 #include <opencv2/opencv.hpp>
+#include "ar_math.hpp"
+#include "frame_preprocessor.hpp"
+#include "frame_source.hpp"
+#include "program_cache.hpp"
 
 // OpenGL Renderer for AR application
 class Renderer
@@ -11,24 +15,36 @@ public:
 
     // Update the background texture with the latest camera frame
     void updateBackground(const cv::Mat &frame);
+    // Same from a preprocessed frame, uploading its ready-made RGB buffer without converting
+    void updateBackground(const PreparedFrame &frame);
+    // Same from a captured frame; YUYV / NV12 planes are uploaded as they are and converted in the shader
+    void updateBackground(const CapturedFrame &frame);
+    // Undistortion of YUV backgrounds in the shader: CV_32FC2 source pixel per output pixel (empty = off)
+    void setUndistortMap(const cv::Mat &map);
     // Draw the background quad with the camera texture
     void drawBackground();
     // Draw the cube with given modelview and projection matrices
-    void drawCube(const double *modelViewMatrix, const GLfloat *projectionMatrix);
-    // Build projection matrix from camera intrinsics
-    void buildProjectionMatrix(const cv::Mat &cameraMatrix, int screen_w, int screen_h, GLfloat *projectionMatrix);
+    void drawCube(const ar::Mat4 &modelViewMatrix, const GLfloat *projectionMatrix);
+    // Build projection matrix from camera intrinsics (needs no GL context)
+    static void buildProjectionMatrix(const cv::Mat &cameraMatrix, int screen_w, int screen_h, GLfloat *projectionMatrix);
 
 private:
-    // Helper to compile shaders
-    GLuint compileShader(const char *filepath, GLenum type);
-    // Helper to create shader program from vertex and fragment shaders
-    GLuint createShaderProgram(const char *vertPath, const char *fragPath);
+    // Builds the shader programs from the embedded sources or the program binary cache
+    ProgramCache programs;
 
     // Background rendering resources
     GLuint backgroundVAO, backgroundVBO; // Vertex Array Object and Vertex Buffer Object
     GLuint backgroundShader;             // Shader program for background
     GLuint cameraTexture;                // Texture for camera frame
 
+    // YUV background (converted and undistorted in background_yuv.frag)
+    GLuint yuvShader = 0;                                              // Shader program for YUV frames
+    GLuint lumaTexture = 0, chromaTexture = 0, undistortTexture = 0;   // Raw planes and undistortion map
+    cv::Size yuvSize;                                                  // Size the plane textures were allocated for
+    CaptureFormat yuvFormat = CaptureFormat::BGR;                      // Layout the plane textures were allocated for
+    bool yuvBackground = false;                                        // Last background update was YUV
+    bool undistortYuv = false;                                         // An undistortion map is set
+
     // Cube rendering resources
     GLuint cubeVAO, cubeVBO; // Vertex Array Object and Vertex Buffer Object for cube
     GLuint cubeShader;       // Shader program for cube
@@ -0,0 +1,216 @@
+#include "planar_pose.hpp"
+#include "pose_refine.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Rotation that takes the unit vector along a onto the z axis
+static cv::Matx33d rotateToZAxis(double ax, double ay, double az)
+{
+    const double norm = std::sqrt(ax * ax + ay * ay + az * az);
+    ax /= norm;
+    ay /= norm;
+    az /= norm;
+
+    cv::Matx33d Ra;
+    if (std::fabs(1.0 + az) < std::numeric_limits<float>::epsilon())
+    {
+        // Pointing straight down -z: rotate by pi about x
+        Ra = cv::Matx33d(1, 0, 0, 0, 1, 0, 0, 0, -1);
+        return Ra;
+    }
+
+    const double d = 1.0 / (1.0 + az);
+    Ra(0, 0) = 1.0 - ax * ax * d;
+    Ra(0, 1) = -ax * ay * d;
+    Ra(0, 2) = -ax;
+    Ra(1, 0) = -ax * ay * d;
+    Ra(1, 1) = 1.0 - ay * ay * d;
+    Ra(1, 2) = -ay;
+    Ra(2, 0) = ax;
+    Ra(2, 1) = ay;
+    Ra(2, 2) = 1.0 - (ax * ax + ay * ay) * d;
+    return Ra;
+}
+
+void ippeRotations(double j00, double j01, double j10, double j11, double p, double q,
+                   cv::Matx33d &R1, cv::Matx33d &R2)
+{
+    // Rotate the line of sight through (p, q) onto the optical axis
+    const cv::Matx33d Rv = rotateToZAxis(p, q, 1.0).t();
+
+    // 2x2 system B^-1 J in the rotated frame
+    const double b00 = Rv(0, 0) - p * Rv(2, 0);
+    const double b01 = Rv(0, 1) - p * Rv(2, 1);
+    const double b10 = Rv(1, 0) - q * Rv(2, 0);
+    const double b11 = Rv(1, 1) - q * Rv(2, 1);
+    const double detInv = 1.0 / (b00 * b11 - b01 * b10);
+    const double binv00 = detInv * b11;
+    const double binv01 = -detInv * b01;
+    const double binv10 = -detInv * b10;
+    const double binv11 = detInv * b00;
+
+    const double a00 = binv00 * j00 + binv01 * j10;
+    const double a01 = binv00 * j01 + binv01 * j11;
+    const double a10 = binv10 * j00 + binv11 * j10;
+    const double a11 = binv10 * j01 + binv11 * j11;
+
+    // Largest singular value of A
+    const double ata00 = a00 * a00 + a01 * a01;
+    const double ata01 = a00 * a10 + a01 * a11;
+    const double ata11 = a10 * a10 + a11 * a11;
+    const double gamma = std::sqrt(0.5 * (ata00 + ata11 + std::sqrt((ata00 - ata11) * (ata00 - ata11) + 4.0 * ata01 * ata01)));
+
+    // Upper-left 2x2 block of the rotation, then complete the two possible third rows
+    const double r00 = a00 / gamma;
+    const double r01 = a01 / gamma;
+    const double r10 = a10 / gamma;
+    const double r11 = a11 / gamma;
+    const double b0 = std::sqrt(std::max(0.0, 1.0 - r00 * r00 - r10 * r10));
+    double b1 = std::sqrt(std::max(0.0, 1.0 - r01 * r01 - r11 * r11));
+    if (-r00 * r01 - r10 * r11 < 0)
+        b1 = -b1;
+
+    // Columns 0 and 1 take +/-b, column 2 is their cross product
+    for (int solution = 0; solution < 2; ++solution)
+    {
+        const double s = solution == 0 ? 1.0 : -1.0;
+        const cv::Matx33d Rtilde(r00, r01, s * (b1 * r10 - b0 * r11),
+                                 r10, r11, s * (b0 * r01 - b1 * r00),
+                                 s * b0, s * b1, r00 * r11 - r01 * r10);
+        (solution == 0 ? R1 : R2) = Rv * Rtilde;
+    }
+}
+
+// Least-squares translation for a known rotation over all correspondences (linear in t)
+static cv::Vec3d translationForRotation(const PoseCorrespondences &pts, const cv::Matx33d &R)
+{
+    // Each point gives t0 - u t2 = u c - a and t1 - v t2 = v c - b with (a, b, c) = R X
+    cv::Matx33d AtA = cv::Matx33d::zeros();
+    cv::Vec3d Atb(0, 0, 0);
+    for (int i = 0; i < pts.size(); ++i)
+    {
+        const double a = R(0, 0) * pts.X[i] + R(0, 1) * pts.Y[i] + R(0, 2) * pts.Z[i];
+        const double b = R(1, 0) * pts.X[i] + R(1, 1) * pts.Y[i] + R(1, 2) * pts.Z[i];
+        const double c = R(2, 0) * pts.X[i] + R(2, 1) * pts.Y[i] + R(2, 2) * pts.Z[i];
+        const double u = pts.u[i], v = pts.v[i];
+        const double e1 = u * c - a;
+        const double e2 = v * c - b;
+        AtA(0, 0) += 1.0;
+        AtA(1, 1) += 1.0;
+        AtA(0, 2) -= u;
+        AtA(1, 2) -= v;
+        AtA(2, 2) += u * u + v * v;
+        Atb[0] += e1;
+        Atb[1] += e2;
+        Atb[2] -= u * e1 + v * e2;
+    }
+    AtA(2, 0) = AtA(0, 2);
+    AtA(2, 1) = AtA(1, 2);
+    return AtA.solve(Atb, cv::DECOMP_CHOLESKY);
+}
+
+PlanarPoseResult PlanarPoseEstimator::estimate(const std::vector<cv::Point3f> &objectPoints,
+                                               const std::vector<cv::Point2f> &imagePoints,
+                                               const cv::Mat &cameraMatrix,
+                                               const cv::Mat &distCoeffs,
+                                               cv::Mat &rvec,
+                                               cv::Mat &tvec) const
+{
+    PlanarPoseResult result;
+    const int n = static_cast<int>(objectPoints.size());
+    if (n < 4 || static_cast<int>(imagePoints.size()) != n)
+        return result;
+
+    // Undistorted, normalized image points
+    const PoseCorrespondences all = PoseCorrespondences::from(objectPoints, imagePoints, cameraMatrix, distCoeffs);
+
+    // Center the plane so the homography Jacobian is taken at the middle of the target
+    double mx = 0.0, my = 0.0;
+    for (const auto &p : objectPoints)
+    {
+        if (std::fabs(p.z) > 1e-6f)
+            return result; // Not a planar target
+        mx += p.x;
+        my += p.y;
+    }
+    mx /= n;
+    my /= n;
+
+    std::vector<cv::Point2f> plane(n), image(n);
+    for (int i = 0; i < n; ++i)
+    {
+        plane[i] = cv::Point2f(static_cast<float>(objectPoints[i].x - mx), static_cast<float>(objectPoints[i].y - my));
+        image[i] = cv::Point2f(static_cast<float>(all.u[i]), static_cast<float>(all.v[i]));
+    }
+
+    // Plane -> normalized image homography (threshold converted to normalized units)
+    cv::Mat mask;
+    cv::Mat Hmat = cv::findHomography(plane, image, options.robust ? cv::RANSAC : 0,
+                                      options.ransacThreshold / all.focal, mask);
+    if (Hmat.empty() || std::fabs(Hmat.at<double>(2, 2)) < std::numeric_limits<double>::epsilon())
+        return result;
+    const cv::Matx33d Hraw = Hmat;
+    const cv::Matx33d H = Hraw * (1.0 / Hraw(2, 2));
+
+    // Inlier subset
+    PoseCorrespondences inliers;
+    inliers.focal = all.focal;
+    result.inlierMask.assign(n, 1);
+    for (int i = 0; i < n; ++i)
+    {
+        if (!mask.empty() && !mask.at<uchar>(i))
+        {
+            result.inlierMask[i] = 0;
+            continue;
+        }
+        inliers.X.push_back(all.X[i]);
+        inliers.Y.push_back(all.Y[i]);
+        inliers.Z.push_back(all.Z[i]);
+        inliers.u.push_back(all.u[i]);
+        inliers.v.push_back(all.v[i]);
+    }
+    result.inliers = inliers.size();
+    if (result.inliers < std::max(4, options.minInliers))
+        return result;
+
+    // Jacobian of the homography at the (centered) origin and the origin's image
+    const double j00 = H(0, 0) - H(2, 0) * H(0, 2);
+    const double j01 = H(0, 1) - H(2, 1) * H(0, 2);
+    const double j10 = H(1, 0) - H(2, 0) * H(1, 2);
+    const double j11 = H(1, 1) - H(2, 1) * H(1, 2);
+    cv::Matx33d candidates[2];
+    ippeRotations(j00, j01, j10, j11, H(0, 2), H(1, 2), candidates[0], candidates[1]);
+
+    // Keep the IPPE solution with the lower reprojection error
+    cv::Matx33d R;
+    cv::Vec3d t;
+    double bestRms = std::numeric_limits<double>::max();
+    for (const auto &candidate : candidates)
+    {
+        const cv::Vec3d candidateT = translationForRotation(inliers, candidate);
+        if (candidateT[2] <= 0.0)
+            continue; // Target behind the camera
+        const double rms = reprojectionRms(inliers, candidate, candidateT);
+        if (rms < bestRms)
+        {
+            bestRms = rms;
+            R = candidate;
+            t = candidateT;
+        }
+    }
+    if (bestRms == std::numeric_limits<double>::max())
+        return result;
+
+    // A few Gauss-Newton steps remove the bias of the closed-form solution
+    RefineOptions refine;
+    refine.maxIterations = options.refineIterations;
+    RefineResult refined = refinePose(inliers, R, t, refine);
+    result.iterations = refined.iterations;
+    result.rmsPx = refined.iterations > 0 ? refined.finalRmsPx : bestRms;
+
+    cv::Rodrigues(R, rvec);
+    tvec = cv::Mat(t, true);
+    result.success = true;
+    return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Settings for the planar pose engine
+struct PlanarPoseOptions
+{
+    bool robust = false;          // RANSAC homography (matched features), plain least squares otherwise (chessboard)
+    double ransacThreshold = 8.0; // RANSAC inlier threshold in pixels
+    int refineIterations = 3;     // Gauss-Newton steps after the closed-form solution
+    int minInliers = 8;           // Fewer homography inliers is a failure
+};
+
+// Outcome of a planar estimate
+struct PlanarPoseResult
+{
+    bool success = false;          // Pose found
+    int inliers = 0;               // Homography inliers used for the pose
+    int iterations = 0;            // Gauss-Newton iterations performed
+    double rmsPx = 0.0;            // Final RMS reprojection error over the inliers (pixels)
+    std::vector<uchar> inlierMask; // Per-correspondence inlier flag
+};
+
+// IPPE (Collins & Bartoli, "Infinitesimal Plane-based Pose Estimation"):
+// the two rotations consistent with the Jacobian J = [j00 j01; j10 j11] of a plane-to-normalized-image
+// homography at the plane origin, whose image is (p, q).
+void ippeRotations(double j00, double j01, double j10, double j11, double p, double q,
+                   cv::Matx33d &R1, cv::Matx33d &R2);
+
+// Pose of a planar target (all object points with z = 0)
+// Estimates a homography, decomposes it in closed form with IPPE, keeps the better of the two
+// solutions and polishes it with a few Gauss-Newton steps (refinePose).
+class PlanarPoseEstimator
+{
+public:
+    explicit PlanarPoseEstimator(const PlanarPoseOptions &options = {}) : options(options) {}
+
+    PlanarPoseResult estimate(const std::vector<cv::Point3f> &objectPoints,
+                              const std::vector<cv::Point2f> &imagePoints,
+                              const cv::Mat &cameraMatrix,
+                              const cv::Mat &distCoeffs,
+                              cv::Mat &rvec,
+                              cv::Mat &tvec) const;
+
+    PlanarPoseOptions options;
+};
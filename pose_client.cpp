@@ -0,0 +1,87 @@
+#include "pose_client.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+PoseClient::~PoseClient()
+{
+    close();
+}
+
+bool PoseClient::connect(const std::string &socketPath, size_t maxFrameBytes)
+{
+    close();
+
+    // Segment name unique per process and client
+    static std::atomic<int> counter{0};
+    const std::string name = "/ar_pose_" + std::to_string(::getpid()) + "_" + std::to_string(counter.fetch_add(1));
+    if (!slot.create(name, maxFrameBytes))
+    {
+        std::cerr << "Unable to create shared memory " << name << std::endl;
+        return false;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        std::cerr << "Unable to connect to " << socketPath << std::endl;
+        close();
+        return false;
+    }
+
+    PoseHello hello;
+    hello.memoryBytes = maxFrameBytes;
+    std::strncpy(hello.memoryName, name.c_str(), sizeof(hello.memoryName) - 1);
+    PoseHelloAck ack;
+    if (!sendMessage(fd, hello) || !receiveMessage(fd, ack) || ack.magic != kPoseProtocolMagic || ack.status != 0)
+    {
+        std::cerr << "Pose server rejected the connection" << std::endl;
+        close();
+        return false;
+    }
+    // The server has mapped the slot; the name is no longer needed
+    slot.unlink();
+    return true;
+}
+
+void PoseClient::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    slot.close();
+}
+
+bool PoseClient::estimate(const cv::Mat &frame, double timestamp, PoseReply &reply)
+{
+    if (fd < 0 || (frame.type() != CV_8UC1 && frame.type() != CV_8UC3))
+        return false;
+    const size_t rowBytes = frame.cols * frame.elemSize();
+    if (rowBytes * frame.rows > slot.size())
+        return false;
+
+    // Packed rows at the start of the slot
+    for (int y = 0; y < frame.rows; ++y)
+        std::memcpy(slot.data() + y * rowBytes, frame.ptr(y), rowBytes);
+
+    PoseRequest request;
+    request.requestId = nextRequestId++;
+    request.width = frame.cols;
+    request.height = frame.rows;
+    request.type = frame.type();
+    request.step = static_cast<std::int32_t>(rowBytes);
+    request.offset = 0;
+    request.timestamp = timestamp;
+    if (!sendMessage(fd, request) || !receiveMessage(fd, reply) || reply.requestId != request.requestId)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
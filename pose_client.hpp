@@ -0,0 +1,33 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include "pose_protocol.hpp"
+#include "shared_memory.hpp"
+
+// Client of the local pose service (PoseServer)
+// Owns one shared-memory frame slot and keeps one request in flight: estimate() copies the frame
+// into the slot, sends the request and blocks for the reply. Use one client per thread.
+class PoseClient
+{
+public:
+    PoseClient() = default;
+    ~PoseClient();
+
+    PoseClient(const PoseClient &) = delete;
+    PoseClient &operator=(const PoseClient &) = delete;
+
+    // Connect and register a frame slot of maxFrameBytes (e.g. width * height * 3 for BGR)
+    bool connect(const std::string &socketPath, size_t maxFrameBytes);
+    void close();
+    bool isConnected() const { return fd >= 0; }
+
+    // Pose of a grayscale (CV_8UC1) or BGR (CV_8UC3) frame; false if the connection failed
+    // (reply.success tells whether a pose was found)
+    bool estimate(const cv::Mat &frame, double timestamp, PoseReply &reply);
+
+private:
+    int fd = -1;
+    SharedMemory slot;
+    std::uint64_t nextRequestId = 1;
+};
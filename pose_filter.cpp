@@ -0,0 +1,95 @@
+#include "pose_filter.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Smoothing factor of a first-order low-pass with the given cutoff
+static double smoothing(double cutoffHz, double dt)
+{
+    const double tau = 1.0 / (2.0 * CV_PI * cutoffHz);
+    return 1.0 / (1.0 + tau / dt);
+}
+
+void PoseFilter::correct(double timestamp, const ar::Pose &pose)
+{
+    const ar::Vec3 &t = pose.tvec;
+    const ar::Quat q = ar::Quat::fromRotationVector(pose.rvec);
+    const double dt = timestamp - lastTime;
+
+    if (initialized && dt <= 0.0)
+        return; // Duplicate or out-of-order timestamp
+
+    // First measurement, or the previous one is too old to say anything about motion
+    if (!initialized || dt > options.maxCoastSeconds)
+    {
+        position = t;
+        orientation = q;
+        velocity = ar::Vec3();
+        angularVelocity = ar::Vec3();
+        lastTime = timestamp;
+        initialized = true;
+        return;
+    }
+
+    const double derivativeAlpha = smoothing(options.derivativeCutoffHz, dt);
+
+    // Translation
+    const ar::Vec3 rawVelocity = (t - position) * (1.0 / dt);
+    velocity += derivativeAlpha * (rawVelocity - velocity);
+    const double translationAlpha = smoothing(options.minCutoffHz + options.translationBeta * velocity.norm(), dt);
+    position += translationAlpha * (t - position);
+
+    // Rotation: the step from the filtered orientation to the measurement, in the camera frame
+    const ar::Vec3 step = (q * orientation.conjugate()).toRotationVector();
+    angularVelocity += derivativeAlpha * (step * (1.0 / dt) - angularVelocity);
+    const double rotationAlpha = smoothing(options.minCutoffHz + options.rotationBeta * angularVelocity.norm(), dt);
+    orientation = (ar::Quat::fromRotationVector(rotationAlpha * step) * orientation).normalized(); // slerp
+
+    lastTime = timestamp;
+}
+
+bool PoseFilter::predict(double time, ar::Pose &pose) const
+{
+    if (!initialized)
+        return false;
+    const double dt = time - lastTime;
+    if (dt > options.maxCoastSeconds)
+        return false; // Lost for too long, stop drawing
+
+    // Constant velocity from the last filtered state
+    const double horizon = std::max(0.0, dt);
+    const ar::Quat q = ar::Quat::fromRotationVector(angularVelocity * horizon) * orientation;
+    pose.rvec = q.toRotationVector();
+    pose.tvec = position + velocity * horizon;
+    return true;
+}
+
+bool PoseFilter::predict(double time, cv::Mat &rvec, cv::Mat &tvec) const
+{
+    ar::Pose pose;
+    if (!predict(time, pose))
+        return false;
+    pose.toCv(rvec, tvec);
+    return true;
+}
+
+ar::Pose interpolatePose(double time0, const ar::Pose &pose0, double time1, const ar::Pose &pose1, double time)
+{
+    const double span = time1 - time0;
+    const double s = span > 0.0 ? (time - time0) / span : 1.0;
+
+    const ar::Quat q0 = ar::Quat::fromRotationVector(pose0.rvec);
+    const ar::Quat q1 = ar::Quat::fromRotationVector(pose1.rvec);
+    const ar::Vec3 step = (q1 * q0.conjugate()).toRotationVector();
+
+    ar::Pose pose;
+    pose.rvec = (ar::Quat::fromRotationVector(s * step) * q0).toRotationVector();
+    pose.tvec = pose0.tvec + s * (pose1.tvec - pose0.tvec);
+    return pose;
+}
+
+void interpolatePose(double time0, const cv::Mat &rvec0, const cv::Mat &tvec0,
+                     double time1, const cv::Mat &rvec1, const cv::Mat &tvec1,
+                     double time, cv::Mat &rvec, cv::Mat &tvec)
+{
+    interpolatePose(time0, ar::Pose::fromCv(rvec0, tvec0), time1, ar::Pose::fromCv(rvec1, tvec1), time).toCv(rvec, tvec);
+}
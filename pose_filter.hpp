@@ -0,0 +1,53 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "ar_math.hpp"
+
+// Settings for the pose filter
+struct PoseFilterOptions
+{
+    double minCutoffHz = 1.0;        // One-Euro cutoff at rest (lower = smoother, more lag)
+    double translationBeta = 0.02;   // Cutoff increase per unit/s of translation speed
+    double rotationBeta = 0.5;       // Cutoff increase per rad/s of angular speed
+    double derivativeCutoffHz = 1.0; // Cutoff of the velocity estimates
+    double maxCoastSeconds = 0.25;   // Keep predicting this long after the last measurement
+};
+
+// One-Euro filter over a rigid pose (Casiez et al., "1 Euro Filter")
+// Translation is filtered per axis and rotation as a quaternion (slerp towards each measurement),
+// both with speed-adaptive cutoffs. The filtered velocities extrapolate the pose to any later
+// time, which compensates pipeline latency and bridges short tracking failures.
+class PoseFilter
+{
+public:
+    explicit PoseFilter(const PoseFilterOptions &options = {}) : options(options) {}
+
+    // Feed a measured pose taken at timestamp (seconds)
+    void correct(double timestamp, const ar::Pose &pose);
+    void correct(double timestamp, const cv::Mat &rvec, const cv::Mat &tvec) { correct(timestamp, ar::Pose::fromCv(rvec, tvec)); }
+
+    // Filtered pose extrapolated to time (seconds); false without a recent measurement
+    bool predict(double time, ar::Pose &pose) const;
+    bool predict(double time, cv::Mat &rvec, cv::Mat &tvec) const;
+
+    // Drop the filter state
+    void reset() { initialized = false; }
+
+    // Timestamp of the last measurement
+    double lastTimestamp() const { return lastTime; }
+
+    PoseFilterOptions options;
+
+private:
+    bool initialized = false;
+    double lastTime = 0.0;     // Timestamp of the last correct()
+    ar::Vec3 position;        // Filtered translation
+    ar::Vec3 velocity;        // Filtered translation speed (units/s)
+    ar::Quat orientation;     // Filtered rotation
+    ar::Vec3 angularVelocity; // Filtered angular speed (rad/s, camera frame)
+};
+
+// Pose at time from two timed poses: slerp / lerp between them, extrapolating past either end
+ar::Pose interpolatePose(double time0, const ar::Pose &pose0, double time1, const ar::Pose &pose1, double time);
+void interpolatePose(double time0, const cv::Mat &rvec0, const cv::Mat &tvec0,
+                     double time1, const cv::Mat &rvec1, const cv::Mat &tvec1,
+                     double time, cv::Mat &rvec, cv::Mat &tvec);
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <cerrno>
+
+// Wire format of the local pose service (PoseServer / PoseClient)
+// Fixed-size messages over a Unix-domain stream socket, in host byte order (both ends run on one
+// machine). A client sends one PoseHello naming a shared-memory segment it created, gets a
+// PoseHelloAck once the server has mapped it, and then alternates PoseRequest / PoseReply. The frame
+// of a request is not sent over the socket: it lies in the shared segment at request.offset and
+// must stay untouched until the reply arrives.
+
+// Writes to a peer that went away fail with EPIPE instead of raising SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int kPoseSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kPoseSendFlags = 0;
+#endif
+
+constexpr std::uint32_t kPoseProtocolMagic = 0x53505241; // "ARPS"
+constexpr std::uint32_t kPoseProtocolVersion = 1;
+
+struct PoseHello
+{
+    std::uint32_t magic = kPoseProtocolMagic;
+    std::uint32_t version = kPoseProtocolVersion;
+    std::uint64_t memoryBytes = 0; // Size of the client's segment
+    char memoryName[64] = {};      // shm_open name of the segment
+};
+
+struct PoseHelloAck
+{
+    std::uint32_t magic = kPoseProtocolMagic;
+    std::int32_t status = 0; // 0 = segment mapped, otherwise the connection is closed
+};
+
+struct PoseRequest
+{
+    std::uint64_t requestId = 0;
+    std::int32_t width = 0, height = 0;
+    std::int32_t type = 0;      // CV_8UC1 (grayscale) or CV_8UC3 (BGR)
+    std::int32_t step = 0;      // Bytes per row
+    std::uint64_t offset = 0;   // Frame start in the shared segment
+    double timestamp = 0.0;     // Client's capture time, echoed back
+};
+
+struct PoseReply
+{
+    std::uint64_t requestId = 0;
+    std::int32_t success = 0;   // Pose found
+    std::int32_t inliers = 0;   // Inliers of the pose
+    double rvec[3] = {};        // Rotation vector
+    double tvec[3] = {};        // Translation
+    double timestamp = 0.0;     // Echo of the request
+    double queueMs = 0.0;       // Receipt to start of tracking
+    double trackMs = 0.0;       // Time in estimatePose
+    std::int32_t batchSize = 0; // Requests dispatched together with this one
+    std::int32_t status = 0;    // 0 = ok, otherwise the request was invalid (bad frame layout)
+};
+
+static_assert(std::is_trivially_copyable<PoseHello>::value && std::is_trivially_copyable<PoseRequest>::value &&
+                  std::is_trivially_copyable<PoseReply>::value,
+              "Pose service messages are sent as raw bytes");
+
+// Send or receive exactly one message; false on a closed or broken connection
+template <typename Message>
+bool sendMessage(int fd, const Message &message)
+{
+    const char *data = reinterpret_cast<const char *>(&message);
+    size_t left = sizeof(Message);
+    while (left > 0)
+    {
+        const ssize_t sent = ::send(fd, data, left, kPoseSendFlags);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        data += sent;
+        left -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+template <typename Message>
+bool receiveMessage(int fd, Message &message)
+{
+    char *data = reinterpret_cast<char *>(&message);
+    size_t left = sizeof(Message);
+    while (left > 0)
+    {
+        const ssize_t received = ::recv(fd, data, left, 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        data += received;
+        left -= static_cast<size_t>(received);
+    }
+    return true;
+}
@@ -0,0 +1,168 @@
+#include "pose_refine.hpp"
+#include <algorithm>
+#include <cmath>
+
+PoseCorrespondences PoseCorrespondences::from(const std::vector<cv::Point3f> &objectPoints,
+                                              const std::vector<cv::Point2f> &imagePoints,
+                                              const cv::Mat &cameraMatrix,
+                                              const cv::Mat &distCoeffs)
+{
+    PoseCorrespondences pts;
+    const size_t n = std::min(objectPoints.size(), imagePoints.size());
+    if (n == 0)
+        return pts;
+
+    // Remove distortion and intrinsics once
+    std::vector<cv::Point2f> normalized;
+    cv::undistortPoints(imagePoints, normalized, cameraMatrix, distCoeffs);
+
+    pts.X.resize(n);
+    pts.Y.resize(n);
+    pts.Z.resize(n);
+    pts.u.resize(n);
+    pts.v.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        pts.X[i] = objectPoints[i].x;
+        pts.Y[i] = objectPoints[i].y;
+        pts.Z[i] = objectPoints[i].z;
+        pts.u[i] = normalized[i].x;
+        pts.v[i] = normalized[i].y;
+    }
+    pts.focal = 0.5 * (cameraMatrix.at<double>(0, 0) + cameraMatrix.at<double>(1, 1));
+    return pts;
+}
+
+// Residuals r = [x - u (N) | y - v (N)] of (R, t); returns the squared error sum
+static double computeResiduals(const PoseCorrespondences &pts, const cv::Matx33d &R, const cv::Vec3d &t, cv::Mat &residual)
+{
+    const int n = pts.size();
+    double *ru = residual.ptr<double>();
+    double *rv = ru + n;
+    double cost = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        const double x = R(0, 0) * pts.X[i] + R(0, 1) * pts.Y[i] + R(0, 2) * pts.Z[i] + t[0];
+        const double y = R(1, 0) * pts.X[i] + R(1, 1) * pts.Y[i] + R(1, 2) * pts.Z[i] + t[1];
+        const double z = R(2, 0) * pts.X[i] + R(2, 1) * pts.Y[i] + R(2, 2) * pts.Z[i] + t[2];
+        const double iz = 1.0 / z;
+        ru[i] = x * iz - pts.u[i];
+        rv[i] = y * iz - pts.v[i];
+        cost += ru[i] * ru[i] + rv[i] * rv[i];
+    }
+    return cost;
+}
+
+// Jacobian of the residuals w.r.t. (w, t), stored transposed: row k holds d r / d param_k
+static void fillJacobian(const PoseCorrespondences &pts, const cv::Matx33d &R, const cv::Vec3d &t, cv::Mat &Jt)
+{
+    const int n = pts.size();
+    double *J[6];
+    for (int k = 0; k < 6; ++k)
+        J[k] = Jt.ptr<double>(k);
+
+    for (int i = 0; i < n; ++i)
+    {
+        // Rotated point P = R X and camera point P + t
+        const double px = R(0, 0) * pts.X[i] + R(0, 1) * pts.Y[i] + R(0, 2) * pts.Z[i];
+        const double py = R(1, 0) * pts.X[i] + R(1, 1) * pts.Y[i] + R(1, 2) * pts.Z[i];
+        const double pz = R(2, 0) * pts.X[i] + R(2, 1) * pts.Y[i] + R(2, 2) * pts.Z[i];
+        const double iz = 1.0 / (pz + t[2]);
+        const double x = (px + t[0]) * iz;
+        const double y = (py + t[1]) * iz;
+
+        // d(x, y) / d(camera point) chained with d(camera point) / d(w) = -[P]x and d / d(t) = I
+        J[0][i] = -iz * x * py;
+        J[1][i] = iz * (pz + x * px);
+        J[2][i] = -iz * py;
+        J[3][i] = iz;
+        J[4][i] = 0.0;
+        J[5][i] = -iz * x;
+
+        J[0][n + i] = -iz * (pz + y * py);
+        J[1][n + i] = iz * y * px;
+        J[2][n + i] = iz * px;
+        J[3][n + i] = 0.0;
+        J[4][n + i] = iz;
+        J[5][n + i] = -iz * y;
+    }
+}
+
+double reprojectionRms(const PoseCorrespondences &pts, const cv::Matx33d &R, const cv::Vec3d &t)
+{
+    const int n = pts.size();
+    if (n == 0)
+        return 0.0;
+    cv::Mat residual(2 * n, 1, CV_64F);
+    return std::sqrt(computeResiduals(pts, R, t, residual) / n) * pts.focal;
+}
+
+RefineResult refinePose(const PoseCorrespondences &pts, cv::Matx33d &R, cv::Vec3d &t, const RefineOptions &options)
+{
+    RefineResult result;
+    const int n = pts.size();
+    if (n < 3)
+        return result;
+
+    // Buffers are allocated once per call and reused by every iteration
+    cv::Mat Jt(6, 2 * n, CV_64F);
+    cv::Mat residual(2 * n, 1, CV_64F), candidateResidual(2 * n, 1, CV_64F);
+    cv::Mat JtJ, Jtr, delta;
+
+    double cost = computeResiduals(pts, R, t, residual);
+    result.initialRmsPx = std::sqrt(cost / n) * pts.focal;
+    double lambda = options.lambda;
+
+    for (int iteration = 0; iteration < options.maxIterations; ++iteration)
+    {
+        fillJacobian(pts, R, t, Jt);
+        cv::mulTransposed(Jt, JtJ, false); // J^T J (6 x 6)
+        Jtr = Jt * residual;               // J^T r (6 x 1)
+        if (lambda > 0.0)
+        {
+            // Marquardt damping scales the diagonal
+            for (int k = 0; k < 6; ++k)
+                JtJ.at<double>(k, k) *= 1.0 + lambda;
+        }
+
+        if (!cv::solve(JtJ, -Jtr, delta, cv::DECOMP_CHOLESKY))
+            break; // Degenerate geometry
+        result.iterations++;
+
+        // Candidate pose
+        const double *d = delta.ptr<double>();
+        cv::Matx33d dR;
+        cv::Rodrigues(cv::Vec3d(d[0], d[1], d[2]), dR);
+        const cv::Matx33d candidateR = dR * R;
+        const cv::Vec3d candidateT = t + cv::Vec3d(d[3], d[4], d[5]);
+        const double candidateCost = computeResiduals(pts, candidateR, candidateT, candidateResidual);
+
+        if (!(candidateCost < cost))
+        {
+            // Gauss-Newton has reached its floor; Levenberg-Marquardt retries with more damping
+            if (lambda > 0.0)
+            {
+                lambda *= 10.0;
+                continue;
+            }
+            result.converged = true;
+            break;
+        }
+
+        R = candidateR;
+        t = candidateT;
+        cv::swap(residual, candidateResidual);
+        cost = candidateCost;
+        if (lambda > 0.0)
+            lambda = std::max(lambda * 0.1, 1e-9);
+
+        if (delta.dot(delta) < options.epsilon)
+        {
+            result.converged = true;
+            break;
+        }
+    }
+
+    result.finalRmsPx = std::sqrt(cost / n) * pts.focal;
+    return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 2D-3D correspondences prepared for pose refinement
+// Image points are stored undistorted and normalized (x/z, y/z), so refinement never touches
+// the camera model again.
+struct PoseCorrespondences
+{
+    std::vector<double> X, Y, Z; // Object points
+    std::vector<double> u, v;    // Normalized image points
+    double focal = 1.0;          // Mean focal length, converts normalized errors back to pixels
+
+    int size() const { return static_cast<int>(u.size()); }
+
+    // Undistort and normalize imagePoints with the given camera
+    static PoseCorrespondences from(const std::vector<cv::Point3f> &objectPoints,
+                                    const std::vector<cv::Point2f> &imagePoints,
+                                    const cv::Mat &cameraMatrix,
+                                    const cv::Mat &distCoeffs);
+};
+
+// Settings for refinePose
+struct RefineOptions
+{
+    int maxIterations = 5;   // Linear solves at most
+    double lambda = 0.0;     // Initial Levenberg-Marquardt damping (0 = plain Gauss-Newton)
+    double epsilon = 1e-12;  // Stop when the squared update norm falls below this
+};
+
+// Outcome of refinePose
+struct RefineResult
+{
+    int iterations = 0;       // Linear solves performed
+    double initialRmsPx = 0.0; // RMS reprojection error before refinement (pixels)
+    double finalRmsPx = 0.0;   // RMS reprojection error after refinement (pixels)
+    bool converged = false;   // Update fell below epsilon before maxIterations
+};
+
+// Minimize the reprojection error of (R, t) over all correspondences.
+// The Jacobian is filled parameter-major (6 x 2N) in one branch-free pass, then J^T J and J^T r
+// come from OpenCV's optimized matrix products. Rotation updates are applied on the left: R <- exp(w) R.
+RefineResult refinePose(const PoseCorrespondences &pts, cv::Matx33d &R, cv::Vec3d &t, const RefineOptions &options = {});
+
+// RMS reprojection error of (R, t) in pixels
+double reprojectionRms(const PoseCorrespondences &pts, const cv::Matx33d &R, const cv::Vec3d &t);
@@ -0,0 +1,275 @@
+#include "pose_server.hpp"
+#include "ar_math.hpp"
+#include "tracker_factory.hpp"
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+PoseServer::Client::~Client()
+{
+    if (fd >= 0)
+        ::close(fd);
+}
+
+PoseServer::PoseServer(const PoseServerOptions &options) : options(options), pool(options.threads)
+{
+}
+
+PoseServer::~PoseServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (dispatcher.joinable())
+        dispatcher.join();
+    if (listenFd >= 0)
+    {
+        ::close(listenFd);
+        ::unlink(options.socketPath.c_str());
+    }
+}
+
+bool PoseServer::start()
+{
+    // Default to the calibration folder keyed by pattern size, like initAugmentor
+    std::filesystem::path calibrationJson = options.calibrationPath;
+    if (calibrationJson.empty())
+    {
+        std::string patternStr = std::to_string(options.patternSize.width) + "x" + std::to_string(options.patternSize.height);
+        calibrationJson = std::filesystem::path("data/calibration") / patternStr / "calibration.json";
+    }
+    if (!calibration.load(calibrationJson))
+    {
+        std::cerr << "Unable to read " << calibrationJson << std::endl;
+        return false;
+    }
+
+    // One tracker per pool worker, plus one for the dispatcher that joins every batch
+    trackers.clear();
+    for (unsigned i = 0; i <= pool.size(); ++i)
+    {
+        auto tracker = createTracker(options.useNft, options.patternSize, options.squareSize, options.referencePath);
+        tracker->showDebug = false; // No HighGUI windows from worker threads
+        tracker->solver = options.solver;
+        if (auto *nft = dynamic_cast<NFTTracker *>(tracker.get()); nft && options.multiView)
+        {
+            // Built once before the first client, shared read-only by every tracker
+            nft->multiView = true;
+            if (trackers.empty())
+                nft->buildDatabase();
+            else
+                nft->useDatabase(static_cast<NFTTracker &>(*trackers.front()).sharedDatabase());
+        }
+        trackers.push_back(std::move(tracker));
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path too long: " << options.socketPath << std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+    ::unlink(options.socketPath.c_str()); // Left over from a previous run
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listenFd, 64) != 0)
+    {
+        std::cerr << "Unable to listen on " << options.socketPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    dispatcher = std::thread(&PoseServer::dispatch, this);
+    return true;
+}
+
+PoseServerStats PoseServer::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+bool PoseServer::greet(Client &client)
+{
+    // A client that never sends its hello must not stall the socket thread
+    timeval timeout{1, 0};
+    ::setsockopt(client.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    PoseHello hello;
+    PoseHelloAck ack;
+    if (!receiveMessage(client.fd, hello))
+        return false;
+    hello.memoryName[sizeof(hello.memoryName) - 1] = '\0';
+    if (hello.magic != kPoseProtocolMagic || hello.version != kPoseProtocolVersion ||
+        !client.memory.open(hello.memoryName, static_cast<size_t>(hello.memoryBytes)))
+        ack.status = 1;
+    sendMessage(client.fd, ack);
+
+    timeval blocking{0, 0};
+    ::setsockopt(client.fd, SOL_SOCKET, SO_RCVTIMEO, &blocking, sizeof(blocking));
+    return ack.status == 0;
+}
+
+void PoseServer::run(const std::atomic<bool> &stop)
+{
+    std::vector<std::shared_ptr<Client>> clients;
+    std::vector<pollfd> fds;
+    while (!stop.load())
+    {
+        fds.assign(1, pollfd{listenFd, POLLIN, 0});
+        for (const auto &client : clients)
+            fds.push_back(pollfd{client->fd, POLLIN, 0});
+        if (::poll(fds.data(), fds.size(), 100) <= 0)
+            continue; // Timeout (checks stop) or EINTR
+
+        // Requests of connected clients; a failed read means the client went away
+        // (requests still queued keep it alive until they are answered)
+        for (size_t i = clients.size(); i-- > 0;)
+        {
+            const short events = fds[i + 1].revents;
+            if (events == 0)
+                continue;
+            Pending pending;
+            if ((events & POLLIN) && receiveMessage(clients[i]->fd, pending.request))
+            {
+                pending.client = clients[i];
+                pending.received = Clock::now();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queue.push_back(std::move(pending));
+                }
+                wake.notify_one();
+                continue;
+            }
+            clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.clients--;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            auto client = std::make_shared<Client>();
+            client->fd = ::accept(listenFd, nullptr, nullptr);
+            if (client->fd >= 0 && greet(*client))
+            {
+                clients.push_back(std::move(client));
+                std::lock_guard<std::mutex> lock(mutex);
+                counters.clients++;
+            }
+        }
+    }
+}
+
+// The requested frame lies inside the client's segment. Every field comes from the client, so
+// nothing may wrap: the offset is checked on its own, and with width, height and step below 2^31
+// the span of the rows fits in 64 bits.
+static bool frameFits(const PoseRequest &r, std::uint64_t size)
+{
+    const std::uint64_t rowBytes = static_cast<std::uint64_t>(r.width) * (r.type == CV_8UC3 ? 3 : 1);
+    if (r.step < 0 || static_cast<std::uint64_t>(r.step) < rowBytes || r.offset > size)
+        return false;
+    const std::uint64_t span = static_cast<std::uint64_t>(r.step) * static_cast<std::uint64_t>(r.height - 1) + rowBytes;
+    return span <= size - r.offset;
+}
+
+void PoseServer::dispatch()
+{
+    const size_t maxBatch = options.maxBatch > 0 ? static_cast<size_t>(options.maxBatch) : trackers.size();
+    for (;;)
+    {
+        std::vector<Pending> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]
+                      { return !queue.empty() || stopping; });
+            if (stopping)
+                return;
+            // Let requests of other clients join within the window of the oldest one
+            const auto deadline = queue.front().received + std::chrono::microseconds(options.batchWindowUs);
+            wake.wait_until(lock, deadline, [&]
+                            { return queue.size() >= maxBatch || stopping; });
+            if (stopping)
+                return;
+            const auto end = queue.begin() + static_cast<std::ptrdiff_t>(std::min(queue.size(), maxBatch));
+            batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(end));
+            queue.erase(queue.begin(), end);
+            counters.batches++;
+        }
+
+        // Validate and look up intrinsics here: the store derives new resolutions lazily and is not thread-safe
+        std::vector<const ResolutionIntrinsics *> intrinsics(batch.size(), nullptr);
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            const PoseRequest &r = batch[i].request;
+            const bool valid = (r.type == CV_8UC1 || r.type == CV_8UC3) && r.width > 0 && r.height > 0 &&
+                               frameFits(r, batch[i].client->memory.size());
+            if (valid)
+                intrinsics[i] = &calibration.at(cv::Size(r.width, r.height));
+        }
+
+        const int batchSize = static_cast<int>(batch.size());
+        pool.parallelFor(0, batchSize, [&](int begin, int end)
+                         {
+                             for (int i = begin; i < end; ++i)
+                                 serve(batch[i], intrinsics[i], batchSize); });
+    }
+}
+
+void PoseServer::serve(const Pending &pending, const ResolutionIntrinsics *intrinsics, int batchSize)
+{
+    const auto start = Clock::now();
+    const PoseRequest &request = pending.request;
+    PoseReply reply;
+    reply.requestId = request.requestId;
+    reply.timestamp = request.timestamp;
+    reply.batchSize = batchSize;
+    reply.queueMs = std::chrono::duration<double, std::milli>(start - pending.received).count();
+
+    if (!intrinsics)
+        reply.status = 1;
+    else
+    {
+        // The dispatcher is not a pool worker (index -1) and uses the first tracker
+        PoseTracker &tracker = *trackers[pool.currentWorker() + 1];
+        // Every request stands alone: drop state left by the previous one
+        if (auto *nft = dynamic_cast<NFTTracker *>(&tracker))
+            nft->lostTrack();
+        else if (auto *chessboard = dynamic_cast<ChessboardTracker *>(&tracker))
+            chessboard->temporal.reset();
+
+        // Zero-copy view of the client's frame; grayscale frames go straight to the trackers
+        const cv::Mat frame(request.height, request.width, request.type,
+                            pending.client->memory.data() + request.offset, static_cast<size_t>(request.step));
+        const PreparedFrame prepared = PreparedFrame::fromColor(frame);
+
+        cv::Mat rvec, tvec;
+        tracker.lastDiagnostics = PoseDiagnostics();
+        reply.success = tracker.estimatePose(prepared, intrinsics->cameraMatrix, calibration.distCoeffs, rvec, tvec);
+        reply.trackMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        reply.inliers = tracker.lastDiagnostics.inliers;
+        if (reply.success)
+        {
+            const ar::Pose pose = ar::Pose::fromCv(rvec, tvec);
+            for (int k = 0; k < 3; ++k)
+            {
+                reply.rvec[k] = pose.rvec[k];
+                reply.tvec[k] = pose.tvec[k];
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pending.client->sendMutex);
+        sendMessage(pending.client->fd, reply);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.requests++;
+}
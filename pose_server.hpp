@@ -0,0 +1,105 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "calibration_store.hpp"
+#include "pose_protocol.hpp"
+#include "shared_memory.hpp"
+#include "thread_pool.hpp"
+#include "tracker.hpp"
+
+// Settings of the pose service
+struct PoseServerOptions
+{
+    std::string socketPath = "/tmp/ar_pose.sock";               // Unix-domain socket to listen on
+    bool useNft = false;                                         // NFT or chessboard tracking
+    cv::Size patternSize{8, 6};                                  // Inner corners of the chessboard
+    float squareSize = 25.0f;                                    // Physical square size
+    std::string referencePath = "data/reference/reference.png"; // NFT reference image
+    bool multiView = false;                                      // NFT: multi-view reference database (built at startup)
+    PoseSolver solver = PoseSolver::OpenCV;                      // Pose solver of every tracker
+    std::filesystem::path calibrationPath;                       // calibration.json (empty = data/calibration/<WxH>)
+    unsigned threads = 0;                                        // Worker count (0 = all cores)
+    int maxBatch = 0;                                            // Requests per batch (0 = one per tracker)
+    int batchWindowUs = 200;                                     // How long a batch waits to fill after its first request
+};
+
+// Service counters
+struct PoseServerStats
+{
+    std::uint64_t requests = 0; // Requests answered
+    std::uint64_t batches = 0;  // Batches dispatched
+    int clients = 0;            // Connected clients
+};
+
+// Pose estimation daemon for the processes of one machine
+// Trackers, the reference (and its multi-view database) and the calibration are loaded once.
+// Clients connect over a Unix-domain socket and hand frames over through their own shared-memory
+// segment, so only small fixed-size messages cross the socket. The socket thread queues requests;
+// a dispatcher collects whatever arrives within the batch window (up to maxBatch) and fans the batch
+// out over the thread pool, each thread using its own tracker. Frames are tracked without
+// undistortion, with the calibrated distortion coefficients, and every request is solved on its own
+// (no prior pose is carried over, since consecutive requests may come from different clients).
+class PoseServer
+{
+public:
+    explicit PoseServer(const PoseServerOptions &options = {});
+    ~PoseServer();
+
+    PoseServer(const PoseServer &) = delete;
+    PoseServer &operator=(const PoseServer &) = delete;
+
+    // Load calibration and trackers and bind the socket
+    bool start();
+    // Serve clients on the calling thread until stop is set
+    void run(const std::atomic<bool> &stop);
+
+    PoseServerStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // One connected client
+    struct Client
+    {
+        int fd = -1;
+        SharedMemory memory;   // The client's frame segment
+        std::mutex sendMutex;  // Replies come from several pool threads
+        ~Client();
+    };
+
+    // A request waiting for the dispatcher
+    struct Pending
+    {
+        std::shared_ptr<Client> client;
+        PoseRequest request;
+        Clock::time_point received;
+    };
+
+    // Read the hello of a new client and map its segment
+    bool greet(Client &client);
+    void dispatch();
+    // Track one request and send its reply (pool thread); intrinsics is null for an invalid request
+    void serve(const Pending &pending, const ResolutionIntrinsics *intrinsics, int batchSize);
+
+    PoseServerOptions options;
+    ThreadPool pool;
+    CalibrationStore calibration;
+    std::vector<std::unique_ptr<PoseTracker>> trackers; // One per pool worker plus one for the dispatcher
+    int listenFd = -1;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Pending> queue;
+    bool stopping = false;
+    PoseServerStats counters;
+    std::thread dispatcher;
+};
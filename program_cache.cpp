@@ -0,0 +1,244 @@
+#include "program_cache.hpp"
+#include "embedded_shaders.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1 // Same value as GL_COMPLETION_STATUS_ARB
+#endif
+
+namespace
+{
+    constexpr char kMagic[4] = {'A', 'R', 'P', 'B'}; // Header of a binary file, followed by the binary format
+
+    // FNV-1a, stable across runs and platforms (std::hash is not)
+    std::uint64_t fnv1a(std::string_view data, std::uint64_t hash = 14695981039346656037ull)
+    {
+        for (unsigned char c : data)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string hex(std::uint64_t value)
+    {
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+        return text;
+    }
+
+    std::string glString(GLenum name)
+    {
+        const GLubyte *value = glGetString(name);
+        return value ? reinterpret_cast<const char *>(value) : "";
+    }
+
+    GLuint compileShader(std::string_view source, GLenum type)
+    {
+        const GLchar *text = source.data();
+        const GLint length = static_cast<GLint>(source.size());
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &text, &length);
+        glCompileShader(shader); // Status is checked in finish(), so compiles overlap
+        return shader;
+    }
+
+    std::string shaderLog(GLuint shader)
+    {
+        char infoLog[512] = {};
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        return infoLog;
+    }
+}
+
+ProgramCache::ProgramCache(const ProgramCacheOptions &options) : options(options)
+{
+}
+
+void ProgramCache::init()
+{
+    initialized = true;
+    start = std::chrono::steady_clock::now();
+
+    // Binaries are only valid for the driver that produced them
+    const std::string driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+    driverDir = options.directory / hex(fnv1a(driver));
+    GLint formats = 0;
+    if (options.useBinaries && (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    binaries = formats > 0;
+    if (binaries)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(driverDir, error);
+        binaries = !error;
+    }
+
+    // Compiler threads chosen by the driver
+    if (options.parallelCompile)
+    {
+#ifdef GL_KHR_parallel_shader_compile
+        if (GLEW_KHR_parallel_shader_compile)
+        {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+            parallel = true;
+        }
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+        if (!parallel && GLEW_ARB_parallel_shader_compile)
+        {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+            parallel = true;
+        }
+#endif
+    }
+}
+
+std::filesystem::path ProgramCache::binaryPath(std::uint64_t key) const
+{
+    return driverDir / (hex(key) + ".bin");
+}
+
+GLuint ProgramCache::loadBinary(std::uint64_t key)
+{
+    const std::filesystem::path path = binaryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return 0;
+    const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    GLenum format = 0;
+    const size_t header = sizeof(kMagic) + sizeof(format);
+    GLuint program = 0;
+    if (contents.size() > header && std::memcmp(contents.data(), kMagic, sizeof(kMagic)) == 0)
+    {
+        std::memcpy(&format, contents.data() + sizeof(kMagic), sizeof(format));
+        program = glCreateProgram();
+        glProgramBinary(program, format, contents.data() + header, static_cast<GLsizei>(contents.size() - header));
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (success)
+            return program;
+        glDeleteProgram(program);
+    }
+    // Truncated, or rejected by the driver (same strings, different build): rebuilt from source
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    return 0;
+}
+
+void ProgramCache::storeBinary(GLuint program, std::uint64_t key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    GLenum format = 0;
+    const size_t header = sizeof(kMagic) + sizeof(format);
+    std::string contents(header + length, '\0');
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, &contents[header]);
+    if (written <= 0)
+        return;
+    std::memcpy(&contents[0], kMagic, sizeof(kMagic));
+    std::memcpy(&contents[sizeof(kMagic)], &format, sizeof(format));
+    contents.resize(header + written);
+    writer.writeFile(binaryPath(key), std::move(contents));
+}
+
+GLuint ProgramCache::add(const std::string &vertex, const std::string &fragment)
+{
+    if (!initialized)
+        init();
+
+    const std::string_view vertexSource = embeddedShader(vertex), fragmentSource = embeddedShader(fragment);
+    if (vertexSource.empty() || fragmentSource.empty())
+    {
+        std::cerr << "Shader not embedded: " << (vertexSource.empty() ? vertex : fragment) << std::endl;
+        return 0;
+    }
+    // Key on both sources (separated, so moving text between them changes it)
+    const std::uint64_t key = fnv1a(fragmentSource, fnv1a(std::string_view("\0", 1), fnv1a(vertexSource)));
+
+    if (binaries)
+    {
+        if (GLuint program = loadBinary(key))
+        {
+            cached++;
+            return program;
+        }
+    }
+
+    Pending p;
+    p.name = vertex + " + " + fragment;
+    p.key = key;
+    p.vertex = compileShader(vertexSource, GL_VERTEX_SHADER);
+    p.fragment = compileShader(fragmentSource, GL_FRAGMENT_SHADER);
+    p.program = glCreateProgram();
+    glAttachShader(p.program, p.vertex);
+    glAttachShader(p.program, p.fragment);
+    if (binaries)
+        glProgramParameteri(p.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(p.program); // Waits for the compiles on the driver's side, not here
+    pending.push_back(p);
+    compiled++;
+    return p.program;
+}
+
+bool ProgramCache::ready() const
+{
+    if (!parallel)
+        return true;
+    for (const auto &p : pending)
+    {
+        GLint done = GL_FALSE;
+        glGetProgramiv(p.program, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done)
+            return false;
+    }
+    return true;
+}
+
+bool ProgramCache::finish()
+{
+    bool ok = true;
+    for (const auto &p : pending)
+    {
+        GLint success = GL_FALSE;
+        glGetProgramiv(p.program, GL_LINK_STATUS, &success); // Blocks until this link is done
+        if (success)
+        {
+            if (binaries)
+                storeBinary(p.program, p.key);
+        }
+        else
+        {
+            // The compile logs usually say more than the link log
+            for (GLuint shader : {p.vertex, p.fragment})
+            {
+                GLint compiledOk = GL_FALSE;
+                glGetShaderiv(shader, GL_COMPILE_STATUS, &compiledOk);
+                if (!compiledOk)
+                    std::cerr << "Error compiling shader (" << p.name << "): " << shaderLog(shader) << std::endl;
+            }
+            char infoLog[512] = {};
+            glGetProgramInfoLog(p.program, sizeof(infoLog), NULL, infoLog);
+            std::cerr << "Error linking shader program (" << p.name << "): " << infoLog << std::endl;
+            ok = false;
+        }
+        // Linked into the program (or useless); detached so the driver can free them now
+        glDetachShader(p.program, p.vertex);
+        glDetachShader(p.program, p.fragment);
+        glDeleteShader(p.vertex);
+        glDeleteShader(p.fragment);
+    }
+    pending.clear();
+    elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "artifact_writer.hpp"
+
+// Settings of the shader program cache
+struct ProgramCacheOptions
+{
+    std::filesystem::path directory = "data/shader_cache"; // Program binaries, one subdirectory per driver
+    bool useBinaries = true;                                // Load and store linked programs (glGetProgramBinary)
+    bool parallelCompile = true;                            // Let the driver compile on its own threads (KHR_parallel_shader_compile)
+};
+
+// Builds the GL programs from the embedded shaders (embedded_shaders.hpp)
+// A linked program is stored with glGetProgramBinary under a directory keyed by the GL vendor,
+// renderer and version strings, in a file keyed by its sources, so later starts load it instead of
+// compiling; a driver update or an edited shader simply misses, and a binary the driver rejects is
+// deleted and rebuilt. Programs that do miss are only submitted by add(): compile and link of all
+// of them overlap on the driver's threads (KHR/ARB_parallel_shader_compile where available) while
+// the caller sets up its buffers, and finish() waits for them once. New binaries are written on a
+// background thread. Needs a current GL context for every call.
+class ProgramCache
+{
+public:
+    explicit ProgramCache(const ProgramCacheOptions &options = {});
+
+    // Queue the program of the embedded shaders shaders/<vertex> and shaders/<fragment>. The returned
+    // program object is usable once finish() returned; 0 if a shader does not exist.
+    GLuint add(const std::string &vertex, const std::string &fragment);
+    // True when every queued program is linked, without blocking (always true without parallel compile)
+    bool ready() const;
+    // Wait for the queued programs, report compile and link errors and store the new binaries.
+    // False if a program failed; it stays unlinked, so drawing with it draws nothing.
+    bool finish();
+
+    int cachedCount() const { return cached; }     // Programs loaded from binaries
+    int compiledCount() const { return compiled; } // Programs compiled from source
+    double buildMs() const { return elapsedMs; }   // Time from the first add() to the end of finish()
+
+    ProgramCacheOptions options;
+
+private:
+    struct Pending
+    {
+        GLuint program = 0;
+        GLuint vertex = 0, fragment = 0;
+        std::string name;      // "vertex + fragment", for error messages
+        std::uint64_t key = 0; // Hash of both sources
+    };
+
+    // Driver directory, binary support and compiler threads, on the first add()
+    void init();
+    std::filesystem::path binaryPath(std::uint64_t key) const;
+    // Program from a stored binary, 0 on a miss
+    GLuint loadBinary(std::uint64_t key);
+    void storeBinary(GLuint program, std::uint64_t key);
+
+    bool initialized = false;
+    bool binaries = false;            // Driver supports program binaries and options.useBinaries
+    bool parallel = false;            // Completion of a link can be polled
+    std::filesystem::path driverDir;  // options.directory / hash of the driver strings
+    std::vector<Pending> pending;
+    int cached = 0, compiled = 0;
+    double elapsedMs = 0.0;
+    std::chrono::steady_clock::time_point start;
+    ArtifactWriter writer;            // New binaries, off the render thread
+};
@@ -0,0 +1,74 @@
+#include "quality_governor.hpp"
+#include <algorithm>
+
+QualityGovernor::QualityGovernor(const QualityGovernorOptions &options, std::vector<TrackerQuality> levels)
+    : options(options), ladder(std::move(levels))
+{
+    if (ladder.empty())
+        ladder.push_back(TrackerQuality());
+    levelMs.assign(ladder.size(), 0.0);
+    recent.reserve(std::max(1, options.window));
+}
+
+std::vector<TrackerQuality> QualityGovernor::defaultLevels()
+{
+    //       features levels ratio  ransac window iters halfRes
+    return {{5000, 8, 0.75f, 100, 11, 30, false},
+            {3000, 8, 0.75f, 100, 11, 20, false},
+            {2000, 6, 0.72f, 80, 7, 15, false},
+            {1500, 4, 0.70f, 60, 5, 10, false},
+            {1500, 4, 0.70f, 60, 5, 10, true},
+            {800, 3, 0.70f, 40, 5, 5, true}};
+}
+
+double QualityGovernor::smoothedMs() const
+{
+    std::vector<double> sorted(recent);
+    auto middle = sorted.begin() + sorted.size() / 2;
+    std::nth_element(sorted.begin(), middle, sorted.end());
+    return *middle;
+}
+
+void QualityGovernor::changeTo(int level, int frameId, double measuredMs)
+{
+    history.push_back({frameId, current, level, measuredMs, options.budgetMs});
+    current = level;
+    sinceChange = 0;
+    // Times measured on the old level say nothing about the new one
+    recent.clear();
+    next = 0;
+}
+
+bool QualityGovernor::update(int frameId, double frameMs)
+{
+    const size_t window = static_cast<size_t>(std::max(1, options.window));
+    if (recent.size() < window)
+        recent.push_back(frameMs);
+    else
+        recent[next] = frameMs;
+    next = (next + 1) % window;
+    sinceChange++;
+
+    if (recent.size() < window)
+        return false;
+    const double measured = smoothedMs();
+    levelMs[current] = measured;
+    if (sinceChange < options.holdFrames)
+        return false;
+
+    if (measured > options.budgetMs && current + 1 < levelCount())
+    {
+        changeTo(current + 1, frameId, measured);
+        return true;
+    }
+    if (measured < options.upgradeRatio * options.budgetMs && current > 0)
+    {
+        // Skip a level that recently overran the budget, unless it is time to try it again
+        const double above = levelMs[current - 1];
+        if (above > options.budgetMs && sinceChange < options.retryFrames)
+            return false;
+        changeTo(current - 1, frameId, measured);
+        return true;
+    }
+    return false;
+}
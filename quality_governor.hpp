@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include "statistics.hpp"
+#include "tracker.hpp"
+
+// Settings of the quality governor
+struct QualityGovernorOptions
+{
+    double budgetMs = 33.3;    // Target frame time in milliseconds
+    double upgradeRatio = 0.7; // Step quality up once the smoothed time is below this fraction of the budget
+    int window = 15;           // Frames in the smoothed (median) frame time
+    int holdFrames = 30;       // Frames to wait after a change before the next one
+    int retryFrames = 300;     // Frames after which a level that overran the budget is tried again
+};
+
+// Trades tracker quality for frame time
+// Steps down a ladder of TrackerQuality levels (0 = full quality, each step cheaper: fewer ORB
+// features and pyramid levels, a stricter ratio test, fewer RANSAC hypotheses, shorter sub-pixel
+// refinement, then detection at half resolution) while the median frame time is over the budget,
+// and back up while it is well under. The last time measured on each level keeps it from stepping
+// straight back onto a level that already overran the budget.
+class QualityGovernor
+{
+public:
+    explicit QualityGovernor(const QualityGovernorOptions &options = {}, std::vector<TrackerQuality> levels = defaultLevels());
+
+    // Default ladder; level 0 is the trackers' built-in settings
+    static std::vector<TrackerQuality> defaultLevels();
+
+    // Feed the time of one tracked frame; returns true when the level changed
+    bool update(int frameId, double frameMs);
+
+    int level() const { return current; }
+    int levelCount() const { return static_cast<int>(ladder.size()); }
+    const TrackerQuality &quality() const { return ladder[current]; }
+    // Every change so far (for the session statistics)
+    const std::vector<QualityChange> &changes() const { return history; }
+
+    QualityGovernorOptions options;
+
+private:
+    // Median of the recent frame times
+    double smoothedMs() const;
+    void changeTo(int level, int frameId, double measuredMs);
+
+    std::vector<TrackerQuality> ladder;
+    std::vector<double> recent;   // Ring of the last frame times
+    size_t next = 0;              // Next slot of the ring
+    std::vector<double> levelMs;  // Last smoothed time seen on each level (0 = not measured yet)
+    int current = 0;              // Active level
+    int sinceChange = 0;          // Frames fed since the last change
+    std::vector<QualityChange> history;
+};
@@ -0,0 +1,169 @@
+#include "reference_database.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Warp of one view: the image, the mask of reference pixels in it and the reference -> view transform
+    void renderView(const cv::Mat &reference, double scale, double tilt, double longitude,
+                    cv::Mat &image, cv::Mat &mask, cv::Matx23d &warp)
+    {
+        // Zoom-out with area averaging; pixel centers map as (x + 0.5) * s - 0.5
+        cv::Mat scaled;
+        if (scale == 1.0)
+            scaled = reference;
+        else
+            cv::resize(reference, scaled, cv::Size(), scale, scale, cv::INTER_AREA);
+        cv::Matx33d T(scale, 0, 0.5 * scale - 0.5,
+                      0, scale, 0.5 * scale - 0.5,
+                      0, 0, 1);
+        mask = cv::Mat(scaled.size(), CV_8U, cv::Scalar(255));
+        image = scaled;
+
+        if (tilt > 1.0)
+        {
+            // Rotate the tilt direction onto x, shifted so the rotated image fits
+            const double a = longitude * CV_PI / 180.0, c = std::cos(a), s = std::sin(a);
+            std::vector<cv::Point2d> corners{{0, 0}, {scaled.cols - 1.0, 0}, {0, scaled.rows - 1.0}, {scaled.cols - 1.0, scaled.rows - 1.0}};
+            double minX = 1e9, minY = 1e9, maxX = -1e9, maxY = -1e9;
+            for (const auto &p : corners)
+            {
+                const double x = c * p.x - s * p.y, y = s * p.x + c * p.y;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+            }
+            const cv::Matx23d R(c, -s, -minX, s, c, -minY);
+            const cv::Size rotatedSize(cvCeil(maxX - minX) + 1, cvCeil(maxY - minY) + 1);
+            cv::Mat rotated, rotatedMask;
+            cv::warpAffine(scaled, rotated, R, rotatedSize, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+            cv::warpAffine(mask, rotatedMask, R, rotatedSize, cv::INTER_NEAREST, cv::BORDER_CONSTANT);
+
+            // Anti-aliasing across the compressed direction, then the compression itself
+            cv::GaussianBlur(rotated, rotated, cv::Size(0, 0), 0.8 * std::sqrt(tilt * tilt - 1.0), 0.01);
+            const cv::Size tiltedSize(std::max(1, cvRound(rotatedSize.width / tilt)), rotatedSize.height);
+            cv::resize(rotated, image, tiltedSize, 0, 0, cv::INTER_LINEAR);
+            cv::resize(rotatedMask, mask, tiltedSize, 0, 0, cv::INTER_NEAREST);
+
+            const double sx = static_cast<double>(tiltedSize.width) / rotatedSize.width;
+            T = cv::Matx33d(sx, 0, 0.5 * sx - 0.5, 0, 1, 0, 0, 0, 1) *
+                cv::Matx33d(R(0, 0), R(0, 1), R(0, 2), R(1, 0), R(1, 1), R(1, 2), 0, 0, 1) * T;
+        }
+
+        // Keep features away from the synthetic border (a corner there is an artifact of the warp)
+        cv::erode(mask, mask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 7)));
+        warp = cv::Matx23d(T(0, 0), T(0, 1), T(0, 2), T(1, 0), T(1, 1), T(1, 2));
+    }
+}
+
+ReferenceDatabase::ReferenceDatabase(const ReferenceDatabaseOptions &options, ThreadPool *pool)
+    : options(options), pool(pool)
+{
+}
+
+bool ReferenceDatabase::build(const cv::Mat &reference)
+{
+    views.clear();
+    keypoints.clear();
+    descriptors.release();
+    frontal.clear();
+    tilted.clear();
+    if (reference.empty())
+        return false;
+
+    // View list: for every scale the frontal view, then each tilt at evenly spread longitudes
+    for (double scale : options.scales)
+    {
+        for (double tilt : options.tilts)
+        {
+            const int directions = tilt > 1.0 ? std::max(1, options.longitudes) : 1;
+            for (int k = 0; k < directions; ++k)
+            {
+                ReferenceView view;
+                view.id = static_cast<int>(views.size());
+                view.scale = scale;
+                view.tilt = tilt;
+                view.longitude = 180.0 * k / directions;
+                (tilt > 1.0 ? tilted : frontal).push_back(view.id);
+                views.push_back(view);
+            }
+        }
+    }
+
+    // Views are independent: render and extract them in parallel
+    std::vector<std::vector<cv::KeyPoint>> viewKeypoints(views.size());
+    std::vector<cv::Mat> viewDescriptors(views.size());
+    pool->parallelFor(0, static_cast<int>(views.size()), [&](int begin, int end)
+                      {
+                          for (int i = begin; i < end; ++i)
+                          {
+                              ReferenceView &view = views[i];
+                              cv::Mat image, mask;
+                              renderView(reference, view.scale, view.tilt, view.longitude, image, mask, view.warp);
+                              cv::Ptr<cv::ORB> orb = cv::ORB::create(options.featuresPerView);
+                              std::vector<cv::KeyPoint> found;
+                              orb->detectAndCompute(image, mask, found, viewDescriptors[i]);
+
+                              // View coordinates back to the reference
+                              cv::Matx23d inverse;
+                              cv::invertAffineTransform(view.warp, inverse);
+                              for (auto &kp : found)
+                              {
+                                  const cv::Point2f p = kp.pt;
+                                  kp.pt = cv::Point2f(static_cast<float>(inverse(0, 0) * p.x + inverse(0, 1) * p.y + inverse(0, 2)),
+                                                      static_cast<float>(inverse(1, 0) * p.x + inverse(1, 1) * p.y + inverse(1, 2)));
+                                  kp.class_id = view.id;
+                              }
+                              viewKeypoints[i] = std::move(found);
+                          } });
+
+    // Concatenate, remembering each view's rows
+    std::vector<cv::Mat> rows;
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        views[i].begin = static_cast<int>(keypoints.size());
+        keypoints.insert(keypoints.end(), viewKeypoints[i].begin(), viewKeypoints[i].end());
+        views[i].end = static_cast<int>(keypoints.size());
+        if (!viewDescriptors[i].empty())
+            rows.push_back(viewDescriptors[i]);
+    }
+    if (rows.empty())
+        return false;
+    cv::vconcat(rows, descriptors);
+    return true;
+}
+
+std::vector<int> ReferenceDatabase::select(const cv::Matx22d &J) const
+{
+    // What is left after undoing a view's warp: ORB absorbs rotation and (within its pyramid) uniform
+    // scale, but not anisotropy, so the tilt mismatch weighs most
+    std::vector<std::pair<double, int>> ranked;
+    for (const auto &view : views)
+    {
+        const cv::Matx22d A(view.warp(0, 0), view.warp(0, 1), view.warp(1, 0), view.warp(1, 1));
+        const cv::Matx22d residual = J * A.inv();
+        cv::Matx21d sigma;
+        cv::SVD::compute(residual, sigma, cv::SVD::NO_UV);
+        const double s1 = std::max(sigma(0), 1e-9), s2 = std::max(sigma(1), 1e-9);
+        const double cost = std::abs(std::log(s1 / s2)) + 0.5 * std::abs(std::log(std::sqrt(s1 * s2)));
+        ranked.emplace_back(cost, view.id);
+    }
+    const size_t count = std::min(ranked.size(), static_cast<size_t>(std::max(1, options.viewsPerFrame)));
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end());
+    std::vector<int> selected;
+    for (size_t i = 0; i < count; ++i)
+        selected.push_back(ranked[i].second);
+    return selected;
+}
+
+std::vector<int> ReferenceDatabase::probe(size_t &cursor) const
+{
+    std::vector<int> selected = frontal;
+    for (int k = 0; k < options.probeViews && k < static_cast<int>(tilted.size()); ++k)
+    {
+        selected.push_back(tilted[cursor % tilted.size()]);
+        cursor++;
+    }
+    return selected;
+}
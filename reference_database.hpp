@@ -0,0 +1,60 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "thread_pool.hpp"
+
+// Settings of the multi-view reference database
+struct ReferenceDatabaseOptions
+{
+    std::vector<double> scales{1.0, 0.5, 0.25}; // Zoom-outs of the reference (target far away)
+    std::vector<double> tilts{1.0, 2.0, 4.0};   // Affine tilts 1 / cos(angle): frontal, 60 and 75 degree views
+    int longitudes = 4;                         // Tilt directions per tilt above 1, spread over 180 degrees
+    int featuresPerView = 1000;                 // ORB features per synthetic view
+    int viewsPerFrame = 3;                      // Views searched per frame when the previous pose is known
+    int probeViews = 2;                         // Extra tilted views per frame without a prior (round-robin)
+};
+
+// One synthetic view of the reference
+struct ReferenceView
+{
+    int id = 0;
+    double scale = 1.0;     // Zoom-out factor
+    double tilt = 1.0;      // Compression across the tilt direction
+    double longitude = 0.0; // Tilt direction in degrees
+    cv::Matx23d warp;       // Reference pixels -> view pixels
+    int begin = 0, end = 0; // Rows of the view's features in ReferenceDatabase::descriptors
+};
+
+// ORB features of the reference seen at several scales and viewing angles
+// Every view is a synthetic affine warp of the reference (zoom-out, then an ASIFT-style tilt with
+// anti-aliasing across the compressed direction). Features keep their reference coordinates, so any
+// view gives the same object points, and each one records its view in KeyPoint::class_id. The
+// matcher searches only the views whose warp is closest to the target's current appearance (the
+// local affine of the previous pose), or a rotating handful of views while the target is lost.
+// Read-only after build(), so one database can be shared by the trackers of several threads.
+class ReferenceDatabase
+{
+public:
+    explicit ReferenceDatabase(const ReferenceDatabaseOptions &options = {}, ThreadPool *pool = &ThreadPool::shared());
+
+    // Extract the features of every view of a grayscale reference
+    bool build(const cv::Mat &reference);
+    bool empty() const { return views.empty(); }
+
+    // Views that best explain the local affine J (reference pixels -> frame pixels), closest first
+    std::vector<int> select(const cv::Matx22d &J) const;
+    // Views to search without a prior: the frontal views of every scale plus the next tilted ones
+    // (cursor is the caller's position in the rotation)
+    std::vector<int> probe(size_t &cursor) const;
+
+    std::vector<ReferenceView> views;
+    std::vector<cv::KeyPoint> keypoints; // In reference pixel coordinates, class_id = view id
+    cv::Mat descriptors;                 // One row per keypoint, grouped by view
+
+    ReferenceDatabaseOptions options;
+
+private:
+    ThreadPool *pool;
+    std::vector<int> frontal; // Untilted views
+    std::vector<int> tilted;  // Everything else, probed round-robin
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+
+// Collects results that finish out of order and hands them to a sink strictly in index order.
+// push() may be called from any thread; the sink is only ever called by one thread at a time.
+template <typename T>
+class ReorderBuffer
+{
+public:
+    using Sink = std::function<void(std::size_t, T &&)>;
+
+    explicit ReorderBuffer(Sink sink, std::size_t firstIndex = 0) : sink(std::move(sink)), next(firstIndex) {}
+
+    // Store a result and flush every result that is now contiguous with the last one emitted
+    void push(std::size_t index, T value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index != next)
+        {
+            pending.emplace(index, std::move(value));
+            return;
+        }
+
+        sink(index, std::move(value));
+        ++next;
+        // Drain whatever was waiting behind this index
+        auto it = pending.begin();
+        while (it != pending.end() && it->first == next)
+        {
+            sink(it->first, std::move(it->second));
+            it = pending.erase(it);
+            ++next;
+        }
+    }
+
+    // Index the sink expects next
+    std::size_t nextIndex() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return next;
+    }
+
+    // Number of results held back waiting for an earlier index
+    std::size_t buffered() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.size();
+    }
+
+private:
+    Sink sink;                          // Receives results in order
+    std::size_t next;                   // Next index to emit
+    std::map<std::size_t, T> pending;   // Out-of-order results
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,308 @@
+#include "robust_pose.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+// Correspondences in structure-of-arrays layout so the scoring loops vectorize
+struct PointSet
+{
+    std::vector<float> X, Y, Z; // Object points
+    std::vector<float> u, v;    // Normalized (undistorted) image points
+    int size() const { return static_cast<int>(u.size()); }
+};
+
+// A pose hypothesis and its score
+struct Hypothesis
+{
+    cv::Matx33d R;
+    cv::Vec3d t;
+    int inliers = -1; // -1 = rejected
+};
+
+// Count points of (R, t) within the threshold (squared, normalized units).
+// Returns -1 as soon as the count can no longer reach mustReach.
+static int scorePose(const PointSet &pts, const cv::Matx33d &R, const cv::Vec3d &t, float threshold2, int mustReach)
+{
+    const float r00 = static_cast<float>(R(0, 0)), r01 = static_cast<float>(R(0, 1)), r02 = static_cast<float>(R(0, 2));
+    const float r10 = static_cast<float>(R(1, 0)), r11 = static_cast<float>(R(1, 1)), r12 = static_cast<float>(R(1, 2));
+    const float r20 = static_cast<float>(R(2, 0)), r21 = static_cast<float>(R(2, 1)), r22 = static_cast<float>(R(2, 2));
+    const float t0 = static_cast<float>(t[0]), t1 = static_cast<float>(t[1]), t2 = static_cast<float>(t[2]);
+    const float *X = pts.X.data(), *Y = pts.Y.data(), *Z = pts.Z.data();
+    const float *u = pts.u.data(), *v = pts.v.data();
+    const int n = pts.size();
+
+    // Score in fixed blocks: the inner loop is branch-free, the bail-out check runs once per block
+    constexpr int kBlock = 64;
+    int inliers = 0;
+    for (int start = 0; start < n; start += kBlock)
+    {
+        const int end = std::min(n, start + kBlock);
+        int count = 0;
+        for (int i = start; i < end; ++i)
+        {
+            const float x = r00 * X[i] + r01 * Y[i] + r02 * Z[i] + t0;
+            const float y = r10 * X[i] + r11 * Y[i] + r12 * Z[i] + t1;
+            const float z = r20 * X[i] + r21 * Y[i] + r22 * Z[i] + t2;
+            const float iz = 1.0f / z;
+            const float du = x * iz - u[i];
+            const float dv = y * iz - v[i];
+            count += (z > 0.0f) & (du * du + dv * dv < threshold2);
+        }
+        inliers += count;
+        if (inliers + (n - end) < mustReach)
+            return -1;
+    }
+    return inliers;
+}
+
+// Per-point inlier flags for (R, t), returns the inlier count
+static int computeInlierMask(const PointSet &pts, const cv::Matx33d &R, const cv::Vec3d &t, float threshold2, std::vector<uchar> &mask)
+{
+    const int n = pts.size();
+    mask.assign(n, 0);
+    int inliers = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        const cv::Vec3d p = R * cv::Vec3d(pts.X[i], pts.Y[i], pts.Z[i]) + t;
+        if (p[2] <= 0.0)
+            continue;
+        const double du = p[0] / p[2] - pts.u[i];
+        const double dv = p[1] / p[2] - pts.v[i];
+        if (du * du + dv * dv < threshold2)
+        {
+            mask[i] = 1;
+            inliers++;
+        }
+    }
+    return inliers;
+}
+
+// Draw the sample for hypothesis h (deterministic per h, so parallel runs are reproducible).
+// PROSAC-style: while the ranked top set is still growing, the sample is its newest member plus
+// three earlier ones; afterwards samples are uniform over all correspondences.
+static void drawSample(int h, int growth, const std::vector<int> &order, int sample[4])
+{
+    const int n = static_cast<int>(order.size());
+    const int top = std::min(n, 4 + static_cast<int>(static_cast<long long>(n - 4) * (h + 1) / growth));
+    cv::RNG rng(0x9E3779B9u + static_cast<unsigned>(h) * 7919u);
+
+    int filled = 0;
+    int range = top;
+    if (top < n)
+    {
+        sample[filled++] = order[top - 1];
+        range = top - 1;
+    }
+    while (filled < 4)
+    {
+        const int candidate = order[rng.uniform(0, range)];
+        if (std::find(sample, sample + filled, candidate) == sample + filled)
+            sample[filled++] = candidate;
+    }
+}
+
+// P3P on the first three sample points; the fourth picks among the up to four roots
+static bool solveMinimal(const std::vector<cv::Point3f> &objectPoints, const std::vector<cv::Point2f> &normalized,
+                         const int sample[4], Hypothesis &h)
+{
+    std::vector<cv::Point3f> obj = {objectPoints[sample[0]], objectPoints[sample[1]], objectPoints[sample[2]]};
+    std::vector<cv::Point2f> img = {normalized[sample[0]], normalized[sample[1]], normalized[sample[2]]};
+    std::vector<cv::Mat> rvecs, tvecs;
+    int solutions = 0;
+    try
+    {
+        // Image points are already normalized, so the camera is the identity
+        solutions = cv::solveP3P(obj, img, cv::Mat::eye(3, 3, CV_64F), cv::Mat(), rvecs, tvecs, cv::SOLVEPNP_AP3P);
+    }
+    catch (const cv::Exception &)
+    {
+        return false; // Degenerate sample
+    }
+
+    const cv::Point3f &check = objectPoints[sample[3]];
+    const cv::Point2f &checkImg = normalized[sample[3]];
+    double bestError = std::numeric_limits<double>::max();
+    for (int k = 0; k < solutions; ++k)
+    {
+        cv::Matx33d R;
+        cv::Rodrigues(rvecs[k], R);
+        const cv::Vec3d t = tvecs[k];
+        const cv::Vec3d p = R * cv::Vec3d(check.x, check.y, check.z) + t;
+        if (p[2] <= 0.0)
+            continue;
+        const double du = p[0] / p[2] - checkImg.x;
+        const double dv = p[1] / p[2] - checkImg.y;
+        const double error = du * du + dv * dv;
+        if (error < bestError)
+        {
+            bestError = error;
+            h.R = R;
+            h.t = t;
+        }
+    }
+    return bestError < std::numeric_limits<double>::max();
+}
+
+// Read a 3x1 rotation / translation vector of any float depth
+static cv::Vec3d toVec3d(const cv::Mat &m)
+{
+    cv::Mat d;
+    m.convertTo(d, CV_64F);
+    return cv::Vec3d(d.at<double>(0), d.at<double>(1), d.at<double>(2));
+}
+
+RobustPoseEstimator::RobustPoseEstimator(const RobustPoseOptions &options, ThreadPool *pool) : options(options), pool(pool) {}
+
+RobustPoseResult RobustPoseEstimator::estimate(const std::vector<cv::Point3f> &objectPoints,
+                                               const std::vector<cv::Point2f> &imagePoints,
+                                               const std::vector<float> &matchDistance,
+                                               const cv::Mat &cameraMatrix,
+                                               const cv::Mat &distCoeffs,
+                                               cv::Mat &rvec,
+                                               cv::Mat &tvec,
+                                               bool usePrior) const
+{
+    RobustPoseResult result;
+    const int n = static_cast<int>(objectPoints.size());
+    result.inlierMask.assign(n, 0);
+    if (n < 4 || static_cast<int>(imagePoints.size()) != n)
+        return result;
+
+    // Work in normalized coordinates: distortion is removed once and scoring is a plain division
+    std::vector<cv::Point2f> normalized;
+    cv::undistortPoints(imagePoints, normalized, cameraMatrix, distCoeffs);
+    const double focal = 0.5 * (cameraMatrix.at<double>(0, 0) + cameraMatrix.at<double>(1, 1));
+    const float threshold = static_cast<float>(options.reprojThreshold / focal);
+    const float threshold2 = threshold * threshold;
+
+    PointSet pts;
+    pts.X.resize(n);
+    pts.Y.resize(n);
+    pts.Z.resize(n);
+    pts.u.resize(n);
+    pts.v.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        pts.X[i] = objectPoints[i].x;
+        pts.Y[i] = objectPoints[i].y;
+        pts.Z[i] = objectPoints[i].z;
+        pts.u[i] = normalized[i].x;
+        pts.v[i] = normalized[i].y;
+    }
+
+    // Polish a hypothesis with Levenberg-Marquardt on its inliers and recount
+    auto refine = [&](const Hypothesis &h) -> bool
+    {
+        std::vector<uchar> mask;
+        computeInlierMask(pts, h.R, h.t, threshold2, mask);
+        std::vector<cv::Point3f> inObj;
+        std::vector<cv::Point2f> inImg;
+        for (int i = 0; i < n; ++i)
+        {
+            if (mask[i])
+            {
+                inObj.push_back(objectPoints[i]);
+                inImg.push_back(imagePoints[i]);
+            }
+        }
+        if (static_cast<int>(inObj.size()) < std::max(4, options.minInliers))
+            return false;
+
+        cv::Mat r, t = cv::Mat(h.t).clone();
+        cv::Rodrigues(cv::Mat(h.R), r);
+        cv::solvePnP(inObj, inImg, cameraMatrix, distCoeffs, r, t, true, cv::SOLVEPNP_ITERATIVE);
+
+        cv::Matx33d R;
+        cv::Rodrigues(r, R);
+        result.inliers = computeInlierMask(pts, R, toVec3d(t), threshold2, result.inlierMask);
+        rvec = r;
+        tvec = t;
+        return result.inliers >= options.minInliers;
+    };
+
+    // 1. The previous pose often still explains the frame: verify it before sampling anything
+    if (usePrior && rvec.total() == 3 && tvec.total() == 3)
+    {
+        Hypothesis prior;
+        cv::Rodrigues(toVec3d(rvec), prior.R);
+        prior.t = toVec3d(tvec);
+        const int needed = std::max(options.minInliers, static_cast<int>(std::ceil(options.priorInlierRatio * n)));
+        if (scorePose(pts, prior.R, prior.t, threshold2, needed) >= needed && refine(prior))
+        {
+            result.success = true;
+            result.reusedPrior = true;
+            return result;
+        }
+    }
+
+    // 2. Rank correspondences by match quality for PROSAC sampling
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    if (static_cast<int>(matchDistance.size()) == n)
+    {
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+                         { return matchDistance[a] < matchDistance[b]; });
+    }
+
+    // 3. Generate and score hypotheses in parallel batches
+    const int batch = options.batchSize > 0 ? options.batchSize : std::max(8, static_cast<int>(pool ? pool->size() : 0) * 4);
+    const int growth = std::max(1, options.maxIterations / 2); // Hypotheses until sampling covers every match
+    std::vector<Hypothesis> hypotheses(batch);
+    std::atomic<int> bestInliers{options.minInliers - 1};
+    Hypothesis best;
+    int required = options.maxIterations;
+    int generated = 0;
+
+    while (generated < required)
+    {
+        const int count = std::min(batch, required - generated);
+        auto body = [&](int begin, int end)
+        {
+            for (int k = begin; k < end; ++k)
+            {
+                Hypothesis &h = hypotheses[k];
+                h.inliers = -1;
+                int sample[4];
+                drawSample(generated + k, growth, order, sample);
+                if (!solveMinimal(objectPoints, normalized, sample, h))
+                    continue;
+                // Only a hypothesis that beats the best so far is worth finishing
+                h.inliers = scorePose(pts, h.R, h.t, threshold2, bestInliers.load(std::memory_order_relaxed) + 1);
+                int current = bestInliers.load(std::memory_order_relaxed);
+                while (h.inliers > current && !bestInliers.compare_exchange_weak(current, h.inliers))
+                {
+                }
+            }
+        };
+        if (pool)
+            pool->parallelFor(0, count, body);
+        else
+            body(0, count);
+
+        for (int k = 0; k < count; ++k)
+        {
+            if (hypotheses[k].inliers > best.inliers)
+                best = hypotheses[k];
+        }
+        generated += count;
+
+        // Adaptive termination: hypotheses needed to draw one all-inlier sample of 4 with the given confidence
+        if (best.inliers > 0)
+        {
+            const double allInlier = std::pow(static_cast<double>(best.inliers) / n, 4.0);
+            if (allInlier >= 1.0 - 1e-12)
+                break;
+            const double needed = std::log(1.0 - options.confidence) / std::log(1.0 - allInlier);
+            required = std::min(options.maxIterations, static_cast<int>(std::ceil(needed)));
+        }
+    }
+    result.hypotheses = generated;
+
+    if (best.inliers < options.minInliers)
+        return result;
+
+    result.success = refine(best);
+    return result;
+}
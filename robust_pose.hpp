@@ -0,0 +1,52 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "thread_pool.hpp"
+
+// Settings for the robust pose estimator
+struct RobustPoseOptions
+{
+    int maxIterations = 100;          // Upper bound on hypotheses (same as the solvePnPRansac call)
+    float reprojThreshold = 8.0f;     // Inlier threshold in pixels
+    double confidence = 0.99;         // Stop once this probability of an all-inlier sample is reached
+    int minInliers = 8;               // Fewer inliers is a failure
+    int batchSize = 0;                // Hypotheses scored per parallel round (0 = 4 per worker)
+    double priorInlierRatio = 0.5;    // Previous pose is reused when it explains this fraction of matches
+};
+
+// Outcome of a robust estimate
+struct RobustPoseResult
+{
+    bool success = false;           // Pose found with enough inliers
+    int inliers = 0;                // Inliers of the final pose
+    int hypotheses = 0;             // Hypotheses generated and scored
+    bool reusedPrior = false;       // RANSAC skipped because the prior pose was good enough
+    std::vector<uchar> inlierMask;  // Per-correspondence inlier flag
+};
+
+// Parallel RANSAC for PnP
+// Hypotheses come from P3P on minimal samples (plus one point to pick among the P3P roots),
+// drawn PROSAC-style from the best-ranked matches first. Batches of hypotheses are generated
+// and scored in parallel, each one bailing out as soon as it can no longer beat the best,
+// and sampling stops once the adaptive iteration bound for the current inlier ratio is met.
+class RobustPoseEstimator
+{
+public:
+    explicit RobustPoseEstimator(const RobustPoseOptions &options = {}, ThreadPool *pool = &ThreadPool::shared());
+
+    // objectPoints[i] <-> imagePoints[i]. matchDistance (optional) ranks the correspondences, lower is better.
+    // With usePrior, rvec/tvec hold the previous pose and are checked before any sampling.
+    RobustPoseResult estimate(const std::vector<cv::Point3f> &objectPoints,
+                              const std::vector<cv::Point2f> &imagePoints,
+                              const std::vector<float> &matchDistance,
+                              const cv::Mat &cameraMatrix,
+                              const cv::Mat &distCoeffs,
+                              cv::Mat &rvec,
+                              cv::Mat &tvec,
+                              bool usePrior) const;
+
+    RobustPoseOptions options;
+
+private:
+    ThreadPool *pool; // Workers for hypothesis generation and scoring (nullptr = single-threaded)
+};
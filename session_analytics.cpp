@@ -0,0 +1,332 @@
+#include "session_analytics.hpp"
+#include "statistics.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace
+{
+    // Value at quantile q (bench_main style, on a copy)
+    double percentile(std::vector<double> v, double q)
+    {
+        if (v.empty())
+            return 0.0;
+        std::sort(v.begin(), v.end());
+        const size_t index = static_cast<size_t>(q * (v.size() - 1) + 0.5);
+        return v[std::min(index, v.size() - 1)];
+    }
+
+    double mean(const std::vector<double> &v)
+    {
+        double sum = 0.0;
+        for (double x : v)
+            sum += x;
+        return v.empty() ? 0.0 : sum / v.size();
+    }
+
+    std::string lower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    // Drop `prefix` (and a following '_') from the front of text
+    void stripPrefix(std::string &text, const std::string &prefix)
+    {
+        if (prefix.empty() || text.compare(0, prefix.size(), prefix) != 0)
+            return;
+        text.erase(0, prefix.size());
+        if (!text.empty() && text[0] == '_')
+            text.erase(0, 1);
+    }
+
+    // Quote fields that would break the CSV
+    std::string csvField(const std::string &text)
+    {
+        if (text.find_first_of(",\"\n") == std::string::npos)
+            return text;
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    // Frame rows and success intervals of one session
+    void formatFrames(const RecordedSession &session, int index, SessionSummary &out)
+    {
+        std::ostringstream frames, intervals;
+        frames << std::setprecision(9);
+        size_t jitter = 0; // Jitter values belong to the successful frames, in order
+        int start = -1;
+        for (const auto &f : session.stats.frames)
+        {
+            frames << index << ',' << f.frame_id << ',' << f.timestamp << ',' << f.poseSuccess << ',' << f.tracked << ','
+                   << f.frameTimeMs << ',' << f.trackMs << ',';
+            if (f.poseSuccess && jitter < session.transJitter.size() && jitter < session.rotJitter.size())
+            {
+                frames << session.transJitter[jitter] << ',' << session.rotJitter[jitter];
+                jitter++;
+            }
+            else
+                frames << ',';
+            frames << '\n';
+
+            // Same intervals as the robustness Gantt chart: [first success, first failure after it)
+            if (f.poseSuccess && start < 0)
+                start = f.frame_id;
+            else if (!f.poseSuccess && start >= 0)
+            {
+                intervals << index << ',' << start << ',' << f.frame_id - start << '\n';
+                start = -1;
+            }
+        }
+        if (start >= 0)
+            intervals << index << ',' << start << ',' << session.stats.frames.back().frame_id - start + 1 << '\n';
+        out.frameRows = frames.str();
+        out.intervalRows = intervals.str();
+    }
+
+    // Read one file and compute its metrics
+    bool summarize(const std::filesystem::path &root, const std::filesystem::path &file, int index, bool frameRows, SessionSummary &out)
+    {
+        RecordedSession session;
+        if (!loadRecordedSession(file, session))
+            return false;
+
+        out.id = index;
+        out.path = std::filesystem::relative(file, root);
+        auto part = out.path.begin();
+        out.method = out.path.has_parent_path() ? lower(part->string()) : std::string();
+        out.category = out.path.parent_path().filename().string();
+        out.test = lower(file.stem().string());
+        stripPrefix(out.test, "session_stats");
+        stripPrefix(out.test, out.method);
+        if (out.test.empty())
+            out.test = "static"; // session_stats_<method>.json: the pose stability recording
+
+        out.summary = session.summary();
+        for (const auto &f : session.stats.frames)
+        {
+            out.frameMs.push_back(f.frameTimeMs);
+            out.attempts += f.tracked;
+            out.successes += f.tracked && f.poseSuccess;
+        }
+        if (frameRows)
+            formatFrames(session, index, out);
+        out.transJitter = std::move(session.transJitter);
+        out.rotJitter = std::move(session.rotJitter);
+        return true;
+    }
+
+    // Metrics compared across methods and the direction that is better
+    struct ComparedMetric
+    {
+        const char *name;
+        const char *better; // "min" or "max"
+    };
+    const ComparedMetric comparedMetrics[] = {
+        {"mean_frame_time_ms", "min"},
+        {"p95_frame_time_ms", "min"},
+        {"success_rate", "max"},
+        {"max_failure_streak", "min"},
+        {"translation_mean_error", "min"},
+        {"rotation_mean_error_rad", "min"}};
+
+    // Sessions of one method and test pooled together
+    struct TestAggregate
+    {
+        int sessions = 0;
+        std::vector<double> frameMs, transJitter, rotJitter;
+        int attempts = 0, successes = 0, maxFailureStreak = 0;
+
+        std::map<std::string, double> metrics() const
+        {
+            return {{"mean_frame_time_ms", mean(frameMs)},
+                    {"p95_frame_time_ms", percentile(frameMs, 0.95)},
+                    {"success_rate", attempts == 0 ? 0.0 : (double)successes / attempts},
+                    {"max_failure_streak", maxFailureStreak},
+                    {"translation_mean_error", mean(transJitter)},
+                    {"rotation_mean_error_rad", mean(rotJitter)}};
+        }
+    };
+
+    bool openCsv(const std::filesystem::path &path, std::ofstream &out)
+    {
+        out.open(path);
+        if (!out.is_open())
+        {
+            std::cerr << "Unable to open " << path << std::endl;
+            return false;
+        }
+        out << std::setprecision(9);
+        return true;
+    }
+}
+
+AnalyticsResult analyzeSessions(const AnalyticsOptions &options)
+{
+    AnalyticsResult result;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (std::filesystem::recursive_directory_iterator it(options.root, error), end; !error && it != end; it.increment(error))
+    {
+        const std::filesystem::path &file = it->path();
+        if (!it->is_regular_file() || file.extension() != ".json" || file.filename().string().rfind(options.prefix, 0) != 0)
+            continue;
+        const std::string stem = file.stem().string();
+        if (options.skipOld && stem.size() >= 4 && stem.compare(stem.size() - 4, 4, "_old") == 0)
+            continue;
+        files.push_back(file);
+    }
+    if (error)
+        std::cerr << "Unable to scan " << options.root << ": " << error.message() << std::endl;
+    std::sort(files.begin(), files.end());
+
+    // Parsing dominates: one file per task, large sessions and small ones balance across the workers
+    std::vector<SessionSummary> sessions(files.size());
+    std::vector<char> ok(files.size(), 0);
+    ThreadPool::shared().parallelFor(0, static_cast<int>(files.size()), [&](int begin, int end)
+                                     {
+                                         for (int i = begin; i < end; ++i)
+                                             ok[i] = summarize(options.root, files[i], i, options.frameRows, sessions[i]); });
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (ok[i])
+            result.sessions.push_back(std::move(sessions[i]));
+        else
+            result.failed.push_back(files[i]);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+bool writeAnalytics(const AnalyticsResult &result, const AnalyticsOptions &options)
+{
+    std::error_code error;
+    std::filesystem::create_directories(options.outputDir, error);
+
+    // 1. One row per session
+    std::ofstream sessionsCsv;
+    if (!openCsv(options.outputDir / "sessions.csv", sessionsCsv))
+        return false;
+    sessionsCsv << "session,path,method,category,test,frames,mean_frame_time_ms,stddev_frame_time_ms,p50_frame_time_ms,"
+                   "p95_frame_time_ms,p99_frame_time_ms,fps,render_fps,tracking_fps,mean_track_time_ms,mean_pose_age_ms,"
+                   "mean_solve_time_ms,mean_iterations,warm_start_rate,success_rate,total_failures,max_failure_streak,"
+                   "failure_streak_count,translation_mean_error,translation_stddev,rotation_mean_error_rad,rotation_stddev_rad\n";
+    for (const auto &s : result.sessions)
+    {
+        const nlohmann::json &perf = s.summary["performance"];
+        const nlohmann::json &solver = s.summary["solver"];
+        const nlohmann::json &rob = s.summary["robustness"];
+        const nlohmann::json &stab = s.summary["pose_stability"];
+        sessionsCsv << s.id << ',' << csvField(s.path.generic_string()) << ',' << csvField(s.method) << ',' << csvField(s.category) << ','
+                    << csvField(s.test) << ',' << s.frameMs.size() << ','
+                    << perf["mean_frame_time_ms"].get<double>() << ',' << perf["stddev_frame_time_ms"].get<double>() << ','
+                    << percentile(s.frameMs, 0.5) << ',' << percentile(s.frameMs, 0.95) << ',' << percentile(s.frameMs, 0.99) << ','
+                    << perf["fps"].get<double>() << ',' << perf["render_fps"].get<double>() << ',' << perf["tracking_fps"].get<double>() << ','
+                    << perf["mean_track_time_ms"].get<double>() << ',' << perf["mean_pose_age_ms"].get<double>() << ','
+                    << solver["mean_solve_time_ms"].get<double>() << ',' << solver["mean_iterations"].get<double>() << ','
+                    << solver["warm_start_rate"].get<double>() << ','
+                    << rob["success_rate"].get<double>() << ',' << rob["total_failures"].get<int>() << ','
+                    << rob["max_failure_streak"].get<int>() << ',' << rob["failure_streak_count"].get<int>() << ','
+                    << stab["translation_mean_error"].get<double>() << ',' << stab["translation_stddev"].get<double>() << ','
+                    << stab["rotation_mean_error_rad"].get<double>() << ',' << stab["rotation_stddev_rad"].get<double>() << '\n';
+    }
+
+    // 2. Sessions of the same method and test pooled frame by frame
+    std::map<std::pair<std::string, std::string>, TestAggregate> tests; // (test, method)
+    for (const auto &s : result.sessions)
+    {
+        TestAggregate &t = tests[{s.test, s.method}];
+        t.sessions++;
+        t.frameMs.insert(t.frameMs.end(), s.frameMs.begin(), s.frameMs.end());
+        t.transJitter.insert(t.transJitter.end(), s.transJitter.begin(), s.transJitter.end());
+        t.rotJitter.insert(t.rotJitter.end(), s.rotJitter.begin(), s.rotJitter.end());
+        t.attempts += s.attempts;
+        t.successes += s.successes;
+        t.maxFailureStreak = std::max(t.maxFailureStreak, s.summary["robustness"]["max_failure_streak"].get<int>());
+    }
+
+    std::ofstream testsCsv;
+    if (!openCsv(options.outputDir / "tests.csv", testsCsv))
+        return false;
+    testsCsv << "test,method,sessions,frames";
+    for (const auto &m : comparedMetrics)
+        testsCsv << ',' << m.name;
+    testsCsv << '\n';
+    std::map<std::pair<std::string, std::string>, std::map<std::string, double>> testMetrics;
+    for (const auto &[key, t] : tests)
+    {
+        const auto metrics = testMetrics[key] = t.metrics();
+        testsCsv << csvField(key.first) << ',' << csvField(key.second) << ',' << t.sessions << ',' << t.frameMs.size();
+        for (const auto &m : comparedMetrics)
+            testsCsv << ',' << metrics.at(m.name);
+        testsCsv << '\n';
+    }
+
+    // 3. Methods side by side for every test and metric; ties are not marked
+    std::ofstream comparisonCsv;
+    if (!openCsv(options.outputDir / "comparison.csv", comparisonCsv))
+        return false;
+    comparisonCsv << "test,metric,better,method,value,best\n";
+    for (auto first = testMetrics.begin(); first != testMetrics.end();)
+    {
+        auto last = first;
+        while (last != testMetrics.end() && last->first.first == first->first.first)
+            ++last;
+        for (const auto &m : comparedMetrics)
+        {
+            const bool minimize = std::string(m.better) == "min";
+            double best = 0.0;
+            int bestCount = 0;
+            for (auto it = first; it != last; ++it)
+            {
+                const double value = it->second.at(m.name);
+                if (bestCount == 0 || (minimize ? value < best : value > best))
+                {
+                    best = value;
+                    bestCount = 1;
+                }
+                else if (value == best)
+                    bestCount++;
+            }
+            for (auto it = first; it != last; ++it)
+            {
+                const double value = it->second.at(m.name);
+                comparisonCsv << csvField(first->first.first) << ',' << m.name << ',' << m.better << ',' << csvField(it->first.second)
+                              << ',' << value << ',' << (value == best && bestCount == 1) << '\n';
+            }
+        }
+        first = last;
+    }
+
+    if (!options.frameRows)
+        return true;
+
+    // 4. Per-frame rows for the plots, already formatted by the workers
+    std::ofstream framesCsv, intervalsCsv;
+    if (!openCsv(options.outputDir / "frames.csv", framesCsv) || !openCsv(options.outputDir / "intervals.csv", intervalsCsv))
+        return false;
+    framesCsv << "session,frame_id,timestamp,success,tracked,perf_time_ms,track_time_ms,stab_trans_jitter,stab_rot_jitter_rad\n";
+    intervalsCsv << "session,start,length\n";
+    for (const auto &s : result.sessions)
+    {
+        framesCsv << s.frameRows;
+        intervalsCsv << s.intervalRows;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Metrics of one session file of a statistics tree
+struct SessionSummary
+{
+    int id = 0;                      // File index of the scan; the "session" column of every CSV file
+    std::filesystem::path path;      // Relative to the scanned root
+    std::string method;              // First directory below the root, lower case (checkerboard, nft, ...)
+    std::string category;            // Directory holding the file (detection_robustness, pose_stability, ...)
+    std::string test;                // File stem without "session_stats" and the method ("static" when nothing is left)
+    nlohmann::json summary;          // RecordedSession::summary()
+    std::vector<double> frameMs;     // perf_time_ms of every frame (per-test percentiles)
+    std::vector<double> transJitter; // Jitter of successful frames (per-test means)
+    std::vector<double> rotJitter;
+    int attempts = 0;                // Tracked frames
+    int successes = 0;               // Successful tracked frames
+    std::string frameRows;           // frames.csv rows of this session, formatted by its worker
+    std::string intervalRows;        // intervals.csv rows (runs of successful frames)
+};
+
+// Settings of a scan
+struct AnalyticsOptions
+{
+    std::filesystem::path root = "data/statistics";     // Tree to scan
+    std::filesystem::path outputDir = "data/analytics"; // Where the CSV files go
+    std::string prefix = "session_stats";               // File name prefix of session files ("" = every .json)
+    bool frameRows = true;                              // Write frames.csv and intervals.csv for the plots
+    bool skipOld = true;                                // Leave out superseded recordings (*_old.json)
+};
+
+// Result of a scan; sessions are sorted by path so the output does not depend on scheduling
+struct AnalyticsResult
+{
+    std::vector<SessionSummary> sessions;
+    std::vector<std::filesystem::path> failed; // Files that could not be read
+    double seconds = 0.0;                      // Wall time of the scan
+};
+
+// Find and read every session file under options.root, one file per thread pool task
+AnalyticsResult analyzeSessions(const AnalyticsOptions &options);
+
+// Write sessions.csv (one row per file), tests.csv (per method and test), comparison.csv (methods side
+// by side per test and metric) and, with frameRows, frames.csv and intervals.csv to options.outputDir
+bool writeAnalytics(const AnalyticsResult &result, const AnalyticsOptions &options);
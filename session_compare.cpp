@@ -0,0 +1,195 @@
+#include "session_compare.hpp"
+#include "statistics.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace
+{
+    // Value at quantile q; reorders v
+    double quantile(std::vector<double> &v, double q)
+    {
+        if (v.empty())
+            return 0.0;
+        const size_t index = std::min(v.size() - 1, static_cast<size_t>(q * (v.size() - 1) + 0.5));
+        std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(index), v.end());
+        return v[index];
+    }
+
+    double average(std::vector<double> &v)
+    {
+        double sum = 0.0;
+        for (double x : v)
+            sum += x;
+        return v.empty() ? 0.0 : sum / v.size();
+    }
+
+    using Statistic = std::function<double(std::vector<double> &)>;
+
+    // Moving-block resample of v into out
+    void resample(const std::vector<double> &v, int blockLength, std::mt19937_64 &rng, std::vector<double> &out)
+    {
+        out.clear();
+        const size_t block = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(blockLength), v.size()));
+        std::uniform_int_distribution<size_t> start(0, v.size() - block);
+        while (out.size() < v.size())
+        {
+            const size_t s = start(rng);
+            const size_t count = std::min(block, v.size() - out.size());
+            out.insert(out.end(), v.begin() + static_cast<std::ptrdiff_t>(s), v.begin() + static_cast<std::ptrdiff_t>(s + count));
+        }
+    }
+
+    // Change of a statistic from baseline to candidate, with a block-bootstrap interval
+    MetricComparison compareMetric(const std::string &name, const std::vector<double> &baseline, const std::vector<double> &candidate,
+                                   const Statistic &statistic, bool relative, const CompareOptions &options)
+    {
+        MetricComparison m;
+        m.name = name;
+        m.relative = relative;
+        std::vector<double> copy = baseline;
+        m.baseline = statistic(copy);
+        copy = candidate;
+        m.candidate = statistic(copy);
+        auto change = [relative](double base, double cand)
+        {
+            return relative ? (base != 0.0 ? cand / base - 1.0 : 0.0) : cand - base;
+        };
+        m.change.estimate = change(m.baseline, m.candidate);
+
+        // Resamples are independent, each seeded by its index
+        const int resamples = std::max(1, options.resamples);
+        std::vector<double> changes(static_cast<size_t>(resamples));
+        ThreadPool::shared().parallelFor(0, resamples, [&](int begin, int end)
+                                         {
+                                             std::vector<double> base, cand;
+                                             for (int b = begin; b < end; ++b)
+                                             {
+                                                 std::mt19937_64 rng(options.seed + static_cast<std::uint64_t>(b));
+                                                 resample(baseline, options.blockLength, rng, base);
+                                                 resample(candidate, options.blockLength, rng, cand);
+                                                 changes[b] = change(statistic(base), statistic(cand));
+                                             } },
+                                         16);
+        const double tail = (1.0 - options.confidence) / 2.0;
+        m.change.low = quantile(changes, tail);
+        m.change.high = quantile(changes, 1.0 - tail);
+        return m;
+    }
+}
+
+bool loadSessionSamples(const std::filesystem::path &path, SessionSamples &samples)
+{
+    samples = SessionSamples();
+    samples.path = path;
+    RecordedSession session;
+    if (!loadRecordedSession(path, session))
+        return false;
+    for (const auto &f : session.stats.frames)
+    {
+        samples.frameMs.push_back(f.frameTimeMs);
+        if (!f.tracked)
+            continue;
+        samples.trackMs.push_back(f.trackMs);
+        samples.success.push_back(f.poseSuccess ? 1.0 : 0.0);
+    }
+    // Files written before track_time_ms existed load it as zero
+    if (std::all_of(samples.trackMs.begin(), samples.trackMs.end(), [](double ms)
+                    { return ms == 0.0; }))
+        samples.trackMs.clear();
+    samples.transJitter = std::move(session.transJitter);
+    samples.rotJitter = std::move(session.rotJitter);
+    const nlohmann::json robustness = session.stats.computeDetectionRobustness();
+    samples.maxFailureStreak = robustness["max_failure_streak"];
+    samples.failureStreaks = robustness["failure_streak_count"];
+    return true;
+}
+
+bool SessionComparison::regression() const
+{
+    return std::any_of(metrics.begin(), metrics.end(), [](const MetricComparison &m)
+                       { return m.regression; });
+}
+
+nlohmann::json SessionComparison::toJson() const
+{
+    nlohmann::json root;
+    root["baseline"] = baseline;
+    root["candidate"] = candidate;
+    root["regression"] = regression();
+    root["metrics"] = nlohmann::json::array();
+    for (const auto &m : metrics)
+        root["metrics"].push_back({{"name", m.name},
+                                   {"baseline", m.baseline},
+                                   {"candidate", m.candidate},
+                                   {"relative", m.relative},
+                                   {"change", m.change.estimate},
+                                   {"change_low", m.change.low},
+                                   {"change_high", m.change.high},
+                                   {"threshold", m.threshold},
+                                   {"regression", m.regression}});
+    return root;
+}
+
+SessionComparison compareSessions(const SessionSamples &baseline, const SessionSamples &candidate, const CompareOptions &options)
+{
+    SessionComparison result;
+    result.baseline = baseline.path.string();
+    result.candidate = candidate.path.string();
+
+    const Statistic median = [](std::vector<double> &v)
+    { return quantile(v, 0.5); };
+    const Statistic p95 = [](std::vector<double> &v)
+    { return quantile(v, 0.95); };
+    const Statistic mean = [](std::vector<double> &v)
+    { return average(v); };
+
+    // Higher is worse: a regression needs the whole interval above the threshold
+    auto slower = [&](const std::string &name, const std::vector<double> &base, const std::vector<double> &cand, const Statistic &statistic, double threshold)
+    {
+        if (base.empty() || cand.empty())
+            return;
+        MetricComparison m = compareMetric(name, base, cand, statistic, true, options);
+        m.threshold = threshold;
+        m.regression = m.change.low > threshold;
+        result.metrics.push_back(m);
+    };
+
+    slower("frame_time_median_ms", baseline.frameMs, candidate.frameMs, median, options.maxSlowdown);
+    slower("frame_time_p95_ms", baseline.frameMs, candidate.frameMs, p95, options.maxSlowdown);
+    slower("track_time_median_ms", baseline.trackMs, candidate.trackMs, median, options.maxSlowdown);
+
+    if (!baseline.success.empty() && !candidate.success.empty())
+    {
+        // Lower is worse, in absolute points
+        MetricComparison m = compareMetric("success_rate", baseline.success, candidate.success, mean, false, options);
+        m.threshold = -options.maxSuccessDrop;
+        m.regression = m.change.high < -options.maxSuccessDrop;
+        result.metrics.push_back(m);
+    }
+
+    // Streaks depend on frame order, so they get no bootstrap interval
+    MetricComparison streak;
+    streak.name = "max_failure_streak";
+    streak.relative = false;
+    streak.baseline = baseline.maxFailureStreak;
+    streak.candidate = candidate.maxFailureStreak;
+    streak.change.estimate = streak.change.low = streak.change.high = streak.candidate - streak.baseline;
+    streak.threshold = options.maxStreakIncrease;
+    streak.regression = streak.change.estimate > options.maxStreakIncrease;
+    result.metrics.push_back(streak);
+
+    MetricComparison streaks = streak;
+    streaks.name = "failure_streaks";
+    streaks.baseline = baseline.failureStreaks;
+    streaks.candidate = candidate.failureStreaks;
+    streaks.change.estimate = streaks.change.low = streaks.change.high = streaks.candidate - streaks.baseline;
+    streaks.threshold = 0.0;
+    streaks.regression = false; // Reported only: more, shorter streaks can be an improvement
+    result.metrics.push_back(streaks);
+
+    slower("trans_jitter_mean", baseline.transJitter, candidate.transJitter, mean, options.maxJitterIncrease);
+    slower("rot_jitter_mean_rad", baseline.rotJitter, candidate.rotJitter, mean, options.maxJitterIncrease);
+    return result;
+}
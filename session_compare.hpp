@@ -0,0 +1,69 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Per-frame samples of one session statistics file (SessionStats::toJson output)
+struct SessionSamples
+{
+    std::filesystem::path path;
+    std::vector<double> frameMs;     // perf_time_ms of every frame
+    std::vector<double> trackMs;     // track_time_ms of tracked frames (empty for files written before it existed)
+    std::vector<double> success;     // 1 / 0 per tracked frame, in order
+    std::vector<double> transJitter; // stab_trans_jitter of successful frames
+    std::vector<double> rotJitter;   // stab_rot_jitter_rad of successful frames
+    int maxFailureStreak = 0;        // Longest run of failed tracked frames
+    int failureStreaks = 0;          // Failure runs the tracker recovered from (failure_streak_count)
+};
+
+// Read a session file with loadRecordedSession (the stored summary is skipped; it is
+// recomputed from the frames)
+bool loadSessionSamples(const std::filesystem::path &path, SessionSamples &samples);
+
+// Settings of a comparison
+struct CompareOptions
+{
+    int resamples = 2000;            // Bootstrap resamples
+    int blockLength = 30;            // Moving-block length in frames (frame times are autocorrelated)
+    double confidence = 0.95;        // Two-sided confidence level
+    unsigned seed = 1;               // Bootstrap seed (resample b uses seed + b: results do not depend on thread count)
+    double maxSlowdown = 0.05;       // Frame / track time: regression when the change is surely above +5 %
+    double maxSuccessDrop = 0.02;    // Success rate: regression when it surely dropped by more than 2 points
+    int maxStreakIncrease = 5;       // Longest failure streak: regression when it grew by more than 5 frames
+    double maxJitterIncrease = 0.10; // Jitter: regression when the change is surely above +10 %
+};
+
+// Estimate with a confidence interval
+struct ConfidenceInterval
+{
+    double estimate = 0.0;
+    double low = 0.0;
+    double high = 0.0;
+};
+
+// One metric of candidate against baseline
+struct MetricComparison
+{
+    std::string name;
+    double baseline = 0.0;
+    double candidate = 0.0;
+    bool relative = true;      // change is candidate / baseline - 1, otherwise candidate - baseline
+    ConfidenceInterval change; // Bootstrap interval of the change (low == high for metrics without one)
+    double threshold = 0.0;    // Allowed change in the bad direction
+    bool regression = false;   // The interval lies entirely beyond the threshold
+};
+
+// Candidate session against the baseline
+struct SessionComparison
+{
+    std::string baseline, candidate;
+    std::vector<MetricComparison> metrics;
+
+    bool regression() const;
+    nlohmann::json toJson() const;
+};
+
+// Compare frame time (median, p95), track time, success rate, failure streaks and jitter.
+// Metrics a file does not have (older sessions without track_time_ms) are left out.
+SessionComparison compareSessions(const SessionSamples &baseline, const SessionSamples &candidate, const CompareOptions &options = {});
@@ -0,0 +1,55 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D lumaTexture;   // NV12: Y plane (R8). YUYV: packed Y0 U Y1 V (RGBA8, half width)
+uniform sampler2D chromaTexture; // NV12: interleaved UV plane (RG8, half size)
+uniform sampler2D undistortMap;  // Source pixel of every output pixel (RG32F), when undistort is set
+uniform int format;              // 0 = YUYV, 1 = NV12
+uniform bool undistort;
+uniform vec2 frameSize;
+
+float lumaAt(ivec2 p)
+{
+    p = clamp(p, ivec2(0), ivec2(frameSize) - 1);
+    if (format == 1)
+        return texelFetch(lumaTexture, p, 0).r;
+    vec4 packed = texelFetch(lumaTexture, ivec2(p.x / 2, p.y), 0);
+    return (p.x % 2 == 0) ? packed.r : packed.b;
+}
+
+vec2 chromaAt(ivec2 p)
+{
+    p = clamp(p, ivec2(0), ivec2(frameSize) - 1);
+    if (format == 1)
+        return texelFetch(chromaTexture, p / 2, 0).rg;
+    return texelFetch(lumaTexture, ivec2(p.x / 2, p.y), 0).ga;
+}
+
+void main()
+{
+    // Output pixel, rows top-down like the capture
+    ivec2 pixel = ivec2(vec2(TexCoord.x, 1.0 - TexCoord.y) * frameSize);
+    pixel = clamp(pixel, ivec2(0), ivec2(frameSize) - 1);
+
+    // Source position in the (distorted) capture, pixel centers at integers
+    vec2 source = undistort ? texelFetch(undistortMap, pixel, 0).rg : vec2(pixel);
+    if (any(lessThan(source, vec2(-0.5))) || any(greaterThan(source, frameSize - 0.5)))
+    {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    // Bilinear luma, nearest chroma
+    ivec2 base = ivec2(floor(source));
+    vec2 f = source - vec2(base);
+    float y = mix(mix(lumaAt(base), lumaAt(base + ivec2(1, 0)), f.x),
+                  mix(lumaAt(base + ivec2(0, 1)), lumaAt(base + ivec2(1, 1)), f.x), f.y);
+    vec2 uv = chromaAt(ivec2(round(source))) - 0.5;
+
+    // BT.601, limited range
+    float c = 1.164 * (y - 16.0 / 255.0);
+    FragColor = vec4(c + 1.596 * uv.y, c - 0.392 * uv.x - 0.813 * uv.y, c + 2.017 * uv.x, 1.0);
+}
@@ -0,0 +1,105 @@
+#include "shared_memory.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+SharedMemory::~SharedMemory()
+{
+    close();
+}
+
+SharedMemory::SharedMemory(SharedMemory &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+SharedMemory &SharedMemory::operator=(SharedMemory &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        segmentName = std::move(other.segmentName);
+        mapped = std::exchange(other.mapped, nullptr);
+        bytes = std::exchange(other.bytes, 0);
+        fd = std::exchange(other.fd, -1);
+        owner = std::exchange(other.owner, false);
+    }
+    return *this;
+}
+
+bool SharedMemory::create(const std::string &name, size_t size)
+{
+    close();
+    fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return false;
+    segmentName = name;
+    owner = true;
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        close();
+        return false;
+    }
+    void *address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    mapped = static_cast<unsigned char *>(address);
+    bytes = size;
+    return true;
+}
+
+bool SharedMemory::open(const std::string &name, size_t size, bool writable)
+{
+    close();
+    fd = ::shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    segmentName = name;
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || (size > 0 && static_cast<size_t>(info.st_size) < size))
+    {
+        close();
+        return false;
+    }
+    if (size == 0)
+        size = static_cast<size_t>(info.st_size);
+    void *address = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    mapped = static_cast<unsigned char *>(address);
+    bytes = size;
+    return true;
+}
+
+void SharedMemory::unlink()
+{
+    if (owner && !segmentName.empty())
+        ::shm_unlink(segmentName.c_str());
+    owner = false;
+}
+
+void SharedMemory::remove(const std::string &name)
+{
+    ::shm_unlink(name.c_str());
+}
+
+void SharedMemory::close()
+{
+    if (mapped)
+        ::munmap(mapped, bytes);
+    if (fd >= 0)
+        ::close(fd);
+    unlink();
+    mapped = nullptr;
+    bytes = 0;
+    fd = -1;
+    segmentName.clear();
+}
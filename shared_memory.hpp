@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// POSIX shared memory segment (shm_open + mmap), unmapped and closed on destruction
+// The creator owns the name: it is unlinked when the creator is destroyed (or earlier with unlink(),
+// once every peer has mapped it).
+class SharedMemory
+{
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory &) = delete;
+    SharedMemory &operator=(const SharedMemory &) = delete;
+    SharedMemory(SharedMemory &&other) noexcept;
+    SharedMemory &operator=(SharedMemory &&other) noexcept;
+
+    // Create a new segment of the given size (fails if the name exists)
+    bool create(const std::string &name, size_t bytes);
+    // Map an existing segment; bytes = 0 maps its whole current size
+    bool open(const std::string &name, size_t bytes = 0, bool writable = false);
+    // Remove the name; existing mappings stay valid
+    void unlink();
+    // Remove a segment by name, e.g. one left behind by a crashed owner
+    static void remove(const std::string &name);
+    void close();
+
+    unsigned char *data() const { return mapped; }
+    size_t size() const { return bytes; }
+    const std::string &name() const { return segmentName; }
+    bool isOpen() const { return mapped != nullptr; }
+
+private:
+    std::string segmentName;
+    unsigned char *mapped = nullptr;
+    size_t bytes = 0;
+    int fd = -1;
+    bool owner = false; // Created here, unlink on close
+};
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <numeric>
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 
 // HELPER: Calculate Mean and Standard Deviation
@@ -27,10 +28,55 @@ nlohmann::json SessionStats::computePerformance() const
     auto [mean, stddev] = getMeanStdDev(times);    // Calculate mean and stddev
     double fps = (mean > 0) ? 1000.0 / mean : 0.0; // Calculate FPS
 
+    // Render rate vs. tracking rate over the session (they differ with skipped or asynchronous tracking)
+    std::vector<double> trackTimes, poseAges;
+    for (const auto &f : frames)
+    {
+        if (f.tracked)
+            trackTimes.push_back(f.trackMs);
+        if (f.displayed)
+            poseAges.push_back(f.poseAgeMs);
+    }
+    double duration = frames.size() > 1 ? frames.back().timestamp - frames.front().timestamp : 0.0;
+    double renderFps = duration > 0 ? (frames.size() - 1) / duration : 0.0;
+    double trackingFps = duration > 0 ? trackTimes.size() / duration : 0.0;
+
     return {
         {"mean_frame_time_ms", mean},
         {"stddev_frame_time_ms", stddev},
-        {"fps", fps}};
+        {"fps", fps},
+        {"render_fps", renderFps},
+        {"tracking_fps", trackingFps},
+        {"mean_track_time_ms", getMeanStdDev(trackTimes).first},
+        {"mean_pose_age_ms", getMeanStdDev(poseAges).first}};
+}
+
+// 1b. Compute Solver Summary
+nlohmann::json SessionStats::computeSolverPerformance() const
+{
+    std::vector<double> solveTimes, iterations;
+    int warmStarts = 0;
+    int maxIterations = 0;
+    for (const auto &f : frames)
+    {
+        if (!f.poseSuccess)
+            continue;
+        solveTimes.push_back(f.solveMs);
+        iterations.push_back(f.solverIterations);
+        maxIterations = std::max(maxIterations, f.solverIterations);
+        warmStarts += f.warmStarted;
+    }
+
+    auto [meanSolve, stddevSolve] = getMeanStdDev(solveTimes);
+    double meanIterations = getMeanStdDev(iterations).first;
+    double warmRate = solveTimes.empty() ? 0.0 : (double)warmStarts / solveTimes.size();
+
+    return {
+        {"mean_solve_time_ms", meanSolve},
+        {"stddev_solve_time_ms", stddevSolve},
+        {"mean_iterations", meanIterations},
+        {"max_iterations", maxIterations},
+        {"warm_start_rate", warmRate}};
 }
 
 // 2. Compute Robustness Summary
@@ -43,8 +89,13 @@ nlohmann::json SessionStats::computeDetectionRobustness() const
     int currFailStreak = 0;
     int failureStreakCount = 0;
 
+    int attempts = 0;
+
     for (const auto &f : frames)
     {
+        if (!f.tracked)
+            continue; // Tracker skipped this frame, neither success nor failure
+        attempts++;
         if (f.poseSuccess)
         {
             if (currFailStreak > 0)
@@ -68,7 +119,7 @@ nlohmann::json SessionStats::computeDetectionRobustness() const
     if (currFailStreak > maxFailStreak)
         maxFailStreak = currFailStreak;
 
-    double rate = frames.empty() ? 0.0 : (double)success / frames.size();
+    double rate = attempts == 0 ? 0.0 : (double)success / attempts;
 
     return {
         {"success_rate", rate},
@@ -77,24 +128,94 @@ nlohmann::json SessionStats::computeDetectionRobustness() const
         {"failure_streak_count", failureStreakCount}};
 }
 
-// 3. Compute Pose Stability Summary
-nlohmann::json SessionStats::computePoseStability() const
+// 2b. Compute Quality Governor Summary
+// Time and success rate per quality level show what each step down bought and what it cost
+nlohmann::json SessionStats::computeQualityGovernor() const
 {
-    // A. Collect valid poses
-    std::vector<cv::Mat> valid_tvecs;
-    std::vector<cv::Mat> valid_Rs; // Rotations in Matrix form
+    int maxLevel = 0;
+    for (const auto &f : frames)
+        maxLevel = std::max(maxLevel, f.qualityLevel);
 
+    std::vector<std::vector<double>> times(maxLevel + 1);
+    std::vector<int> attempts(maxLevel + 1, 0), successes(maxLevel + 1, 0);
+    int overBudget = 0;
     for (const auto &f : frames)
     {
-        if (f.poseSuccess)
-        {
-            valid_tvecs.push_back(f.tvec);
-            cv::Mat R;
-            cv::Rodrigues(f.rvec, R);
-            valid_Rs.push_back(R);
-        }
+        times[f.qualityLevel].push_back(f.frameTimeMs);
+        if (f.frameTimeMs > frameBudgetMs)
+            overBudget++;
+        if (!f.tracked)
+            continue;
+        attempts[f.qualityLevel]++;
+        successes[f.qualityLevel] += f.poseSuccess;
+    }
+
+    nlohmann::json levels = nlohmann::json::array();
+    for (int level = 0; level <= maxLevel; ++level)
+    {
+        auto [mean, stddev] = getMeanStdDev(times[level]);
+        levels.push_back({{"level", level},
+                          {"frames", times[level].size()},
+                          {"mean_frame_time_ms", mean},
+                          {"stddev_frame_time_ms", stddev},
+                          {"success_rate", attempts[level] == 0 ? 0.0 : (double)successes[level] / attempts[level]}});
+    }
+
+    return {
+        {"budget_ms", frameBudgetMs},
+        {"changes", qualityChanges.size()},
+        {"over_budget_rate", frames.empty() ? 0.0 : (double)overBudget / frames.size()},
+        {"levels", levels}};
+}
+
+// 2c. Compute Motion Gate Summary
+// Saved time is estimated as the skipped frames times the mean time of the tracker runs, minus
+// what the checks themselves cost
+nlohmann::json SessionStats::computeMotionGate() const
+{
+    int skipped = 0;
+    std::vector<double> trackTimes;
+    double gateMs = 0.0;
+    for (const auto &f : frames)
+    {
+        skipped += f.motionSkipped;
+        gateMs += f.gateMs;
+        if (f.tracked)
+            trackTimes.push_back(f.trackMs);
     }
+    const int candidates = skipped + static_cast<int>(trackTimes.size());
+    const double meanTrackMs = getMeanStdDev(trackTimes).first;
+    const double trackedMs = meanTrackMs * trackTimes.size();
+    const double savedMs = skipped * meanTrackMs - gateMs;
+    const double ungatedMs = trackedMs + skipped * meanTrackMs;
+
+    return {
+        {"skipped_frames", skipped},
+        {"skip_ratio", candidates == 0 ? 0.0 : (double)skipped / candidates},
+        {"mean_gate_time_ms", frames.empty() ? 0.0 : gateMs / frames.size()},
+        {"mean_track_time_ms", meanTrackMs},
+        {"saved_time_ms", savedMs},
+        {"saved_fraction", ungatedMs > 0.0 ? savedMs / ungatedMs : 0.0}};
+}
 
+// HELPER: Mean rotation of a set of rotations (SVD projection of the element-wise mean)
+// The only OpenCV call of the statistics, once per session
+static ar::Mat3 meanRotation(const std::vector<ar::Mat3> &Rs)
+{
+    if (Rs.empty())
+        return ar::Mat3::identity();
+    ar::Mat3 R_sum{{0, 0, 0, 0, 0, 0, 0, 0, 0}};
+    for (const auto &R : Rs)
+        R_sum += R;
+    cv::Matx33d U, Vt;
+    cv::Matx31d S;
+    cv::SVD::compute(R_sum.toCv() * (1.0 / Rs.size()), S, U, Vt);
+    return ar::Mat3::fromCv(U * Vt);
+}
+
+// HELPER: Spread of a set of poses around their mean (jitter)
+static nlohmann::json poseStability(const std::vector<ar::Vec3> &valid_tvecs, const std::vector<ar::Mat3> &valid_Rs)
+{
     if (valid_tvecs.empty())
     {
         return {
@@ -104,42 +225,35 @@ nlohmann::json SessionStats::computePoseStability() const
             {"rotation_stddev_rad", 0.0}};
     }
 
-    // B. Calculate Mean Translation
-    cv::Mat t_sum = cv::Mat::zeros(3, 1, CV_64F);
+    // A. Calculate Mean Translation
+    ar::Vec3 t_sum;
     for (const auto &t : valid_tvecs)
         t_sum += t;
-    cv::Mat t_mean = t_sum / (double)valid_tvecs.size();
-
-    // C. Calculate Mean Rotation (SVD Method)
-    cv::Mat R_sum = cv::Mat::zeros(3, 3, CV_64F);
-    for (const auto &R : valid_Rs)
-        R_sum += R;
-    R_sum /= (double)valid_Rs.size();
+    const ar::Vec3 t_mean = t_sum * (1.0 / valid_tvecs.size());
 
-    cv::Mat U, S, Vt;
-    cv::SVD::compute(R_sum, S, U, Vt);
-    cv::Mat R_mean = U * Vt;
+    // B. Calculate Mean Rotation (SVD Method)
+    const ar::Mat3 R_mean = meanRotation(valid_Rs);
 
-    // D. Calculate Deviations (Jitter)
+    // C. Calculate Deviations (Jitter)
     std::vector<double> t_errors;
     std::vector<double> r_errors;
 
     for (size_t i = 0; i < valid_tvecs.size(); ++i)
     {
         // Translation Error (Euclidean distance from mean)
-        t_errors.push_back(cv::norm(valid_tvecs[i] - t_mean));
+        t_errors.push_back((valid_tvecs[i] - t_mean).norm());
 
         // Rotation Error (Geodesic angle from mean)
-        cv::Mat R_diff = R_mean.t() * valid_Rs[i];
-        double trace = cv::trace(R_diff)[0];
-        // Clamp to avoid numerical errors going slightly outside [-1, 1]
-        double val = (trace - 1.0) / 2.0;
-        val = std::max(-1.0, std::min(1.0, val));
-        r_errors.push_back(std::acos(val));
+        r_errors.push_back(ar::rotationAngle(R_mean, valid_Rs[i]));
     }
 
-    auto [meanT, stdT] = getMeanStdDev(t_errors);
-    auto [meanR, stdR] = getMeanStdDev(r_errors);
+    return SessionStats::jitterStability(t_errors, r_errors);
+}
+
+nlohmann::json SessionStats::jitterStability(const std::vector<double> &transErrors, const std::vector<double> &rotErrors)
+{
+    auto [meanT, stdT] = getMeanStdDev(transErrors);
+    auto [meanR, stdR] = getMeanStdDev(rotErrors);
 
     return {
         {"translation_mean_error", meanT},
@@ -148,6 +262,48 @@ nlohmann::json SessionStats::computePoseStability() const
         {"rotation_stddev_rad", stdR}};
 }
 
+// 3. Compute Pose Stability Summary
+nlohmann::json SessionStats::computePoseStability() const
+{
+    // Collect valid poses
+    std::vector<ar::Vec3> valid_tvecs;
+    std::vector<ar::Mat3> valid_Rs; // Rotations in Matrix form
+
+    for (const auto &f : frames)
+    {
+        if (f.poseSuccess)
+        {
+            valid_tvecs.push_back(f.pose.tvec);
+            valid_Rs.push_back(f.pose.rotation());
+        }
+    }
+    return poseStability(valid_tvecs, valid_Rs);
+}
+
+// 3b. Compute Rendered Pose Summary
+nlohmann::json SessionStats::computeDisplayStability() const
+{
+    // Collect rendered poses (filtered / predicted / coasted)
+    std::vector<ar::Vec3> display_tvecs;
+    std::vector<ar::Mat3> display_Rs;
+    int tracked = 0;
+
+    for (const auto &f : frames)
+    {
+        tracked += f.tracked;
+        if (f.displayed)
+        {
+            display_tvecs.push_back(f.displayPose.tvec);
+            display_Rs.push_back(f.displayPose.rotation());
+        }
+    }
+
+    nlohmann::json result = poseStability(display_tvecs, display_Rs);
+    result["display_rate"] = frames.empty() ? 0.0 : (double)display_tvecs.size() / frames.size();
+    result["tracked_rate"] = frames.empty() ? 0.0 : (double)tracked / frames.size();
+    return result;
+}
+
 // 4. Export to JSON (Orchestrator)
 nlohmann::json SessionStats::toJson() const
 {
@@ -156,40 +312,48 @@ nlohmann::json SessionStats::toJson() const
     // 1. Add Summary Section (using the functions above)
     root["summary"] = {
         {"performance", computePerformance()},
+        {"solver", computeSolverPerformance()},
         {"robustness", computeDetectionRobustness()},
         {"pose_stability", computePoseStability()}};
+    bool anyDisplayed = std::any_of(frames.begin(), frames.end(), [](const FrameStats &f)
+                                    { return f.displayed; });
+    if (anyDisplayed)
+        root["summary"]["display_stability"] = computeDisplayStability();
+    if (frameBudgetMs > 0.0)
+    {
+        root["summary"]["quality_governor"] = computeQualityGovernor();
+        root["quality_changes"] = nlohmann::json::array();
+        for (const auto &c : qualityChanges)
+            root["quality_changes"].push_back({{"frame_id", c.frame_id},
+                                               {"from_level", c.fromLevel},
+                                               {"to_level", c.toLevel},
+                                               {"measured_ms", c.measuredMs},
+                                               {"budget_ms", c.budgetMs}});
+    }
+
+    if (motionGate)
+        root["summary"]["motion_gate"] = computeMotionGate();
 
     // 2. Prepare for Per-Frame Calculations
     // We need to re-calculate the Mean Pose to generate per-frame delta values.
     // (Repeating logic here to avoid changing the header file with private members)
-    cv::Mat mean_t = cv::Mat::zeros(3, 1, CV_64F);
-    cv::Mat mean_R = cv::Mat::eye(3, 3, CV_64F);
-    std::vector<cv::Mat> valid_Rs;
+    ar::Vec3 mean_t;
+    std::vector<ar::Mat3> valid_Rs;
     int valid_count = 0;
 
     for (const auto &f : frames)
     {
         if (f.poseSuccess)
         {
-            mean_t += f.tvec;
-            cv::Mat R;
-            cv::Rodrigues(f.rvec, R);
-            valid_Rs.push_back(R);
+            mean_t += f.pose.tvec;
+            valid_Rs.push_back(f.pose.rotation());
             valid_count++;
         }
     }
 
     if (valid_count > 0)
-    {
-        mean_t /= (double)valid_count;
-        cv::Mat R_sum = cv::Mat::zeros(3, 3, CV_64F);
-        for (const auto &R : valid_Rs)
-            R_sum += R;
-        R_sum /= (double)valid_count;
-        cv::Mat U, S, Vt;
-        cv::SVD::compute(R_sum, S, U, Vt);
-        mean_R = U * Vt;
-    }
+        mean_t = mean_t * (1.0 / valid_count);
+    const ar::Mat3 mean_R = meanRotation(valid_Rs);
 
     // 3. Build Per-Frame Array
     root["frames"] = nlohmann::json::array();
@@ -204,20 +368,25 @@ nlohmann::json SessionStats::toJson() const
         entry["timestamp"] = f.timestamp;
         entry["success"] = f.poseSuccess;
         entry["perf_time_ms"] = f.frameTimeMs;
+        entry["solve_time_ms"] = f.solveMs;
+        entry["solver_iterations"] = f.solverIterations;
+        entry["warm_started"] = f.warmStarted;
+        entry["tracked"] = f.tracked;
+        entry["track_time_ms"] = f.trackMs;
+        entry["displayed"] = f.displayed;
+        entry["pose_age_ms"] = f.poseAgeMs;
+        entry["quality_level"] = f.qualityLevel;
+        entry["motion_skipped"] = f.motionSkipped;
+        entry["gate_ms"] = f.gateMs;
 
         // Stability Stats (Jitter relative to mean)
         if (f.poseSuccess && valid_count > 0)
         {
             // Translation Jitter
-            entry["stab_trans_jitter"] = cv::norm(f.tvec - mean_t);
+            entry["stab_trans_jitter"] = (f.pose.tvec - mean_t).norm();
 
             // Rotation Jitter
-            cv::Mat R_curr;
-            cv::Rodrigues(f.rvec, R_curr);
-            cv::Mat R_diff = mean_R.t() * R_curr;
-            double trace = cv::trace(R_diff)[0];
-            double val = std::max(-1.0, std::min(1.0, (trace - 1.0) / 2.0));
-            entry["stab_rot_jitter_rad"] = std::acos(val);
+            entry["stab_rot_jitter_rad"] = ar::rotationAngle(mean_R, f.pose.rotation());
         }
         else
         {
@@ -229,4 +398,172 @@ nlohmann::json SessionStats::toJson() const
     }
 
     return root;
-}
\ No newline at end of file
+}
+
+// HELPER: SAX handler filling FrameStats from the top-level "frames" array (summary is skipped)
+namespace
+{
+    struct FramesHandler
+    {
+        using json = nlohmann::json;
+
+        RecordedSession &session;
+        const std::filesystem::path &path;
+        int depth = 0;        // Nesting of objects and arrays
+        int framesDepth = -1; // Depth of the frames array while inside it
+        bool nextIsFrames = false;
+        std::string currentKey;
+        FrameStats frame{};
+        double transJitter = -1.0; // Negative while the frame has none (null)
+        double rotJitter = -1.0;
+
+        FramesHandler(RecordedSession &session, const std::filesystem::path &path) : session(session), path(path) {}
+
+        // Directly inside a frame object (not in a nested value)
+        bool inFrame() const { return framesDepth >= 0 && depth == framesDepth + 1; }
+
+        void number(double value)
+        {
+            if (!inFrame())
+                return;
+            if (currentKey == "frame_id")
+                frame.frame_id = static_cast<int>(value);
+            else if (currentKey == "timestamp")
+                frame.timestamp = value;
+            else if (currentKey == "perf_time_ms")
+                frame.frameTimeMs = value;
+            else if (currentKey == "solve_time_ms")
+                frame.solveMs = value;
+            else if (currentKey == "solver_iterations")
+                frame.solverIterations = static_cast<int>(value);
+            else if (currentKey == "track_time_ms")
+                frame.trackMs = value;
+            else if (currentKey == "pose_age_ms")
+                frame.poseAgeMs = value;
+            else if (currentKey == "quality_level")
+                frame.qualityLevel = static_cast<int>(value);
+            else if (currentKey == "gate_ms")
+                frame.gateMs = value;
+            else if (currentKey == "stab_trans_jitter")
+                transJitter = value;
+            else if (currentKey == "stab_rot_jitter_rad")
+                rotJitter = value;
+        }
+
+        bool null() { return true; }
+        bool boolean(bool value)
+        {
+            if (!inFrame())
+                return true;
+            if (currentKey == "success")
+                frame.poseSuccess = value;
+            else if (currentKey == "warm_started")
+                frame.warmStarted = value;
+            else if (currentKey == "tracked")
+                frame.tracked = value;
+            else if (currentKey == "displayed")
+                frame.displayed = value;
+            else if (currentKey == "motion_skipped")
+                frame.motionSkipped = value;
+            return true;
+        }
+        bool number_integer(json::number_integer_t value)
+        {
+            number(static_cast<double>(value));
+            return true;
+        }
+        bool number_unsigned(json::number_unsigned_t value)
+        {
+            number(static_cast<double>(value));
+            return true;
+        }
+        bool number_float(json::number_float_t value, const json::string_t &)
+        {
+            number(value);
+            return true;
+        }
+        bool string(json::string_t &) { return true; }
+        bool binary(json::binary_t &) { return true; }
+        bool start_object(std::size_t)
+        {
+            depth++;
+            return true;
+        }
+        bool end_object()
+        {
+            if (inFrame())
+            {
+                if (frame.poseSuccess && transJitter >= 0.0)
+                    session.transJitter.push_back(transJitter);
+                if (frame.poseSuccess && rotJitter >= 0.0)
+                    session.rotJitter.push_back(rotJitter);
+                session.stats.frames.push_back(frame);
+                frame = FrameStats{};
+                transJitter = rotJitter = -1.0;
+            }
+            depth--;
+            return true;
+        }
+        bool start_array(std::size_t)
+        {
+            depth++;
+            if (nextIsFrames)
+                framesDepth = depth;
+            nextIsFrames = false;
+            return true;
+        }
+        bool end_array()
+        {
+            if (depth == framesDepth)
+                framesDepth = -1;
+            depth--;
+            return true;
+        }
+        bool key(json::string_t &name)
+        {
+            nextIsFrames = depth == 1 && name == "frames"; // "frames" of the root object
+            currentKey = name;
+            return true;
+        }
+        bool parse_error(std::size_t position, const std::string &, const nlohmann::detail::exception &error)
+        {
+            std::cerr << path << ": parse error at byte " << position << ": " << error.what() << std::endl;
+            return false;
+        }
+    };
+}
+
+nlohmann::json RecordedSession::summary() const
+{
+    nlohmann::json summary = {
+        {"performance", stats.computePerformance()},
+        {"solver", stats.computeSolverPerformance()},
+        {"robustness", stats.computeDetectionRobustness()},
+        {"pose_stability", SessionStats::jitterStability(transJitter, rotJitter)}};
+    if (stats.motionGate)
+        summary["motion_gate"] = stats.computeMotionGate();
+    return summary;
+}
+
+bool loadRecordedSession(const std::filesystem::path &path, RecordedSession &session)
+{
+    session = RecordedSession();
+    // Single SAX pass straight from the stream, the document is never held in memory
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+    {
+        std::cerr << "Unable to open " << path << std::endl;
+        return false;
+    }
+    FramesHandler handler(session, path);
+    if (!nlohmann::json::sax_parse(in, &handler))
+        return false;
+    if (session.stats.frames.empty())
+    {
+        std::cerr << path << " has no frames" << std::endl;
+        return false;
+    }
+    session.stats.motionGate = std::any_of(session.stats.frames.begin(), session.stats.frames.end(), [](const FrameStats &f)
+                                           { return f.gateMs > 0.0; });
+    return true;
+}
@@ -1,26 +1,86 @@
+#pragma once
+#include <filesystem>
 #include <vector>
 #include <opencv2/opencv.hpp>
 #include <nlohmann/json.hpp>
+#include "ar_math.hpp"
 
 struct FrameStats
 {
     int frame_id;       // Unique frame identifier
     double timestamp;   // Timestamp in seconds
     bool poseSuccess;   // Whether pose estimation was successful
-    cv::Mat rvec, tvec; // Rotation and translation vectors
+    ar::Pose pose;      // Rotation and translation vectors
     double frameTimeMs; // Time taken to process the frame in milliseconds
+    // Pose solver details (PoseDiagnostics of the tracker)
+    int solverIterations = 0; // Refinement iterations of iterative solvers
+    double solveMs = 0.0;     // Time spent in the pose solver in milliseconds
+    bool warmStarted = false; // Pose refined from the previous frame without a cold solve
+    // Rendering
+    bool tracked = true;              // A tracker result belongs to this frame (false when frames are skipped)
+    double trackMs = 0.0;             // Time the tracker spent on that result in milliseconds
+    bool displayed = false;           // A pose was rendered (filtered, predicted or coasted)
+    ar::Pose displayPose;             // Rendered pose
+    double poseAgeMs = 0.0;           // Display time minus capture time of the newest measurement behind it
+    // Quality governor
+    int qualityLevel = 0;             // Tracker quality level in effect (0 = full quality)
+    // Motion gate
+    bool motionSkipped = false;       // Static scene: the previous pose was reused instead of running the tracker
+    double gateMs = 0.0;              // Time of the motion check in milliseconds
+};
+
+// One decision of the quality governor
+struct QualityChange
+{
+    int frame_id;      // Frame whose timing triggered the change
+    int fromLevel;     // Level before the change
+    int toLevel;       // Level after the change (higher = cheaper)
+    double measuredMs; // Smoothed frame time that triggered it
+    double budgetMs;   // Frame time budget at the time
 };
 
 struct SessionStats
 {
     // Collection of frame statistics
     std::vector<FrameStats> frames;
+    // Quality governor decisions, in order (empty when the governor is off)
+    std::vector<QualityChange> qualityChanges;
+    // Frame time budget of the governor in milliseconds (0 = governor off)
+    double frameBudgetMs = 0.0;
+    // Frames went through the motion gate
+    bool motionGate = false;
     // Compute pose stability metrics
     nlohmann::json computePoseStability() const;
+    // Compute stability metrics of the rendered poses
+    nlohmann::json computeDisplayStability() const;
     // Compute detection robustness metrics
     nlohmann::json computeDetectionRobustness() const;
     // Compute computational performance metrics
     nlohmann::json computePerformance() const;
+    // Compute pose solver metrics (iterations, convergence time, warm starts)
+    nlohmann::json computeSolverPerformance() const;
+    // Compute per-quality-level timing and robustness (governor sessions)
+    nlohmann::json computeQualityGovernor() const;
+    // Compute skip ratio and tracker time saved by the motion gate
+    nlohmann::json computeMotionGate() const;
     // Export all metrics as JSON
     nlohmann::json toJson() const;
-};
\ No newline at end of file
+    // Pose stability section from per-frame jitter values (distances to the mean pose)
+    static nlohmann::json jitterStability(const std::vector<double> &transErrors, const std::vector<double> &rotErrors);
+};
+
+// A session file read back (SessionStats::toJson output). Poses are not stored, only their jitter
+// around the session mean, so that is kept next to the frames for the stability metrics.
+struct RecordedSession
+{
+    SessionStats stats;              // Frames in file order; pose fields are zero
+    std::vector<double> transJitter; // stab_trans_jitter of successful frames
+    std::vector<double> rotJitter;   // stab_rot_jitter_rad of successful frames
+    // Summary sections of SessionStats::toJson that the frames determine
+    // (performance, solver, robustness, pose_stability and motion_gate)
+    nlohmann::json summary() const;
+};
+
+// Stream the "frames" array of a session file without building the JSON document. Files written
+// before a field existed load with its FrameStats default.
+bool loadRecordedSession(const std::filesystem::path &path, RecordedSession &session);
\ No newline at end of file
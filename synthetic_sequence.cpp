@@ -0,0 +1,500 @@
+#include "synthetic_sequence.hpp"
+#include "batch_processor.hpp"
+#include "calibration_store.hpp"
+#include "calibrator.hpp"
+#include "jsonHelper.hpp"
+#include "nft_tracker.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    constexpr double kPi = 3.14159265358979323846;
+    constexpr int kSquarePixels = 40; // Texture pixels per chessboard square
+
+    const char *trajectoryName(SyntheticTrajectory trajectory)
+    {
+        switch (trajectory)
+        {
+        case SyntheticTrajectory::Approach:
+            return "approach";
+        case SyntheticTrajectory::Shake:
+            return "shake";
+        default:
+            return "orbit";
+        }
+    }
+
+    // Homography from texture pixels to image pixels for a pose
+    cv::Matx33d textureHomography(const cv::Mat &cameraMatrix, const cv::Matx33d &textureToObject, const ar::Pose &pose)
+    {
+        const ar::Mat3 R = pose.rotation();
+        const cv::Matx33d Rt(R(0, 0), R(0, 1), pose.tvec.x,
+                             R(1, 0), R(1, 1), pose.tvec.y,
+                             R(2, 0), R(2, 1), pose.tvec.z);
+        return cv::Matx33d(cameraMatrix) * Rt * textureToObject;
+    }
+
+    // Value at quantile q of an unsorted sample
+    double percentile(std::vector<double> v, double q)
+    {
+        if (v.empty())
+            return 0.0;
+        std::sort(v.begin(), v.end());
+        const size_t index = static_cast<size_t>(q * (v.size() - 1) + 0.5);
+        return v[std::min(index, v.size() - 1)];
+    }
+
+    double mean(const std::vector<double> &v)
+    {
+        double sum = 0.0;
+        for (double x : v)
+            sum += x;
+        return v.empty() ? 0.0 : sum / v.size();
+    }
+
+    nlohmann::json spread(const std::vector<double> &v)
+    {
+        return {{"mean", mean(v)}, {"median", percentile(v, 0.5)}, {"p95", percentile(v, 0.95)}, {"max", percentile(v, 1.0)}};
+    }
+}
+
+bool parseTrajectory(const std::string &text, SyntheticTrajectory &trajectory)
+{
+    if (text == "orbit")
+        trajectory = SyntheticTrajectory::Orbit;
+    else if (text == "approach")
+        trajectory = SyntheticTrajectory::Approach;
+    else if (text == "shake")
+        trajectory = SyntheticTrajectory::Shake;
+    else
+        return false;
+    return true;
+}
+
+bool SyntheticGenerator::init()
+{
+    calibrationJson = options.calibrationPath;
+    if (calibrationJson.empty())
+    {
+        std::string patternStr = std::to_string(options.patternSize.width) + "x" + std::to_string(options.patternSize.height);
+        calibrationJson = std::filesystem::path("data/calibration") / patternStr / "calibration.json";
+    }
+    CalibrationStore calibration;
+    if (!calibration.load(calibrationJson))
+    {
+        std::cerr << "Unable to read " << calibrationJson << std::endl;
+        return false;
+    }
+    if (options.imageSize.empty())
+        options.imageSize = calibration.imageSize.empty() ? cv::Size(640, 480) : calibration.imageSize;
+    cameraMatrix = calibration.scaledCameraMatrix(options.imageSize);
+    distCoeffs = options.distort ? calibration.distCoeffs.clone() : cv::Mat::zeros(calibration.distCoeffs.size(), CV_64F);
+
+    // Target texture and its mapping onto the tracker's object plane
+    double targetWidth = 0.0; // In object units
+    if (options.useNft)
+    {
+        texture = cv::imread(options.referencePath, cv::IMREAD_COLOR);
+        if (texture.empty())
+        {
+            std::cerr << "Could not load reference image " << options.referencePath << std::endl;
+            return false;
+        }
+        // Reference pixels are centred and scaled like NFTTracker's object points
+        const double s = NFTTracker(options.referencePath).objectScale();
+        textureToObject = cv::Matx33d(s, 0, -texture.cols * 0.5 * s,
+                                      0, s, -texture.rows * 0.5 * s,
+                                      0, 0, 1);
+        targetWidth = texture.cols * s;
+    }
+    else
+    {
+        // (w + 1) x (h + 1) squares with a one-square white border; black squares in the corners
+        const cv::Size squares(options.patternSize.width + 1, options.patternSize.height + 1);
+        texture = cv::Mat((squares.height + 2) * kSquarePixels, (squares.width + 2) * kSquarePixels, CV_8UC3, cv::Scalar::all(255));
+        for (int i = 0; i < squares.height; ++i)
+            for (int j = 0; j < squares.width; ++j)
+                if ((i + j) % 2 == 0)
+                    cv::rectangle(texture, cv::Rect((j + 1) * kSquarePixels, (i + 1) * kSquarePixels, kSquarePixels, kSquarePixels),
+                                  cv::Scalar::all(0), cv::FILLED);
+        // Inner corner (j, i) sits on the pixel edge at u = (j + 2) * p - 0.5; ChessboardTracker puts it at
+        // (j * square - cx, i * square - cy)
+        const double s = options.squareSize / kSquarePixels;
+        const double cx = (options.patternSize.width - 1) * options.squareSize / 2.0;
+        const double cy = (options.patternSize.height - 1) * options.squareSize / 2.0;
+        textureToObject = cv::Matx33d(s, 0, 0.5 * s - 2 * options.squareSize - cx,
+                                      0, s, 0.5 * s - 2 * options.squareSize - cy,
+                                      0, 0, 1);
+        targetWidth = texture.cols * s;
+    }
+    nominalDistance = cameraMatrix.at<double>(0, 0) * targetWidth / (options.coverage * options.imageSize.width);
+
+    // Smooth clutter so the background is neither flat nor full of corners
+    cv::RNG rng(options.seed);
+    cv::Mat coarse(12, 16, CV_8UC3);
+    rng.fill(coarse, cv::RNG::UNIFORM, cv::Scalar::all(60), cv::Scalar::all(190));
+    cv::resize(coarse, background, options.imageSize, 0, 0, cv::INTER_CUBIC);
+
+    // Distorted pixel -> pinhole pixel, so the render gets the real lens distortion
+    distortX.release();
+    distortY.release();
+    if (options.distort && cv::countNonZero(distCoeffs) > 0)
+    {
+        std::vector<cv::Point2f> pixels, pinhole;
+        pixels.reserve(options.imageSize.area());
+        for (int y = 0; y < options.imageSize.height; ++y)
+            for (int x = 0; x < options.imageSize.width; ++x)
+                pixels.emplace_back(static_cast<float>(x), static_cast<float>(y));
+        cv::undistortPoints(pixels, pinhole, cameraMatrix, distCoeffs, cv::noArray(), cameraMatrix);
+        distortX.create(options.imageSize, CV_32F);
+        distortY.create(options.imageSize, CV_32F);
+        for (int y = 0, k = 0; y < options.imageSize.height; ++y)
+            for (int x = 0; x < options.imageSize.width; ++x, ++k)
+            {
+                distortX.at<float>(y, x) = pinhole[k].x;
+                distortY.at<float>(y, x) = pinhole[k].y;
+            }
+    }
+    return true;
+}
+
+ar::Pose SyntheticGenerator::poseAt(double seconds) const
+{
+    const double duration = std::max(1.0, options.frames / options.fps);
+    const double d = nominalDistance;
+    double ax = 0.0, ay = 0.0, az = 0.0;
+    ar::Vec3 t{0.0, 0.0, d};
+    switch (options.trajectory)
+    {
+    case SyntheticTrajectory::Approach:
+    {
+        const double s = seconds / duration;
+        ax = 0.35 * std::sin(2 * kPi * s);
+        ay = 0.2 * std::sin(4 * kPi * s);
+        t = {0.1 * d * std::sin(2 * kPi * s), 0.0, d * (2.0 - 1.4 * s)};
+        break;
+    }
+    case SyntheticTrajectory::Shake:
+        // A few incommensurate frequencies, like a hand holding the camera
+        ax = 0.12 * std::sin(2 * kPi * 1.3 * seconds) + 0.05 * std::sin(2 * kPi * 3.7 * seconds);
+        ay = 0.10 * std::sin(2 * kPi * 1.7 * seconds + 1.0) + 0.04 * std::sin(2 * kPi * 4.1 * seconds);
+        az = 0.08 * std::sin(2 * kPi * 0.9 * seconds);
+        t = {0.08 * d * std::sin(2 * kPi * 2.3 * seconds), 0.06 * d * std::sin(2 * kPi * 1.9 * seconds + 0.5),
+             d * (1.0 + 0.1 * std::sin(2 * kPi * 0.7 * seconds))};
+        break;
+    default:
+    {
+        // One full circle of 35 degree tilts over the sequence
+        const double phase = 2 * kPi * seconds / duration;
+        ax = 0.61 * std::sin(phase);
+        ay = 0.61 * std::cos(phase);
+        az = 0.26 * std::sin(0.5 * phase);
+        break;
+    }
+    }
+    const ar::Mat3 R = ar::Mat3::fromRotationVector({ax, 0, 0}) * ar::Mat3::fromRotationVector({0, ay, 0}) *
+                       ar::Mat3::fromRotationVector({0, 0, az});
+    cv::Vec3d rvec;
+    cv::Rodrigues(R.toCv(), rvec);
+    return {{rvec[0], rvec[1], rvec[2]}, t};
+}
+
+std::vector<cv::Point2f> SyntheticGenerator::outline(const ar::Pose &pose) const
+{
+    const cv::Matx33d H = textureHomography(cameraMatrix, textureToObject, pose);
+    std::vector<cv::Point2f> corners{{-0.5f, -0.5f}, {texture.cols - 0.5f, -0.5f}, {texture.cols - 0.5f, texture.rows - 0.5f}, {-0.5f, texture.rows - 0.5f}}, projected;
+    cv::perspectiveTransform(corners, projected, H);
+    return projected;
+}
+
+cv::Mat SyntheticGenerator::render(int index, SyntheticFrame &truth) const
+{
+    const cv::Size size = options.imageSize;
+    const double seconds = index / options.fps;
+    truth.frame_id = index;
+    truth.timestamp = seconds;
+    truth.pose = poseAt(seconds);
+
+    const std::vector<cv::Point2f> corners = outline(truth.pose);
+    truth.visible = truth.pose.tvec.z > 0 && std::all_of(corners.begin(), corners.end(), [&](const cv::Point2f &p)
+                                                          { return p.x >= 0 && p.y >= 0 && p.x < size.width && p.y < size.height; });
+
+    cv::Mat canvas = background.clone();
+    cv::warpPerspective(texture, canvas, textureHomography(cameraMatrix, textureToObject, truth.pose), size,
+                        cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+    // Occluder bar sweeping twice over the target
+    truth.occluded = 0.0;
+    if (options.occlusion > 0.0)
+    {
+        const cv::Rect box = cv::boundingRect(corners);
+        const double barWidth = options.occlusion * box.width;
+        const double period = std::max(1.0, options.frames / options.fps) / 2.0;
+        const double phase = std::fmod(seconds, period) / period;
+        const double x0 = box.x - barWidth + phase * (box.width + barWidth);
+        cv::rectangle(canvas, cv::Rect(cvRound(x0), 0, cvRound(barWidth), size.height), cv::Scalar(60, 70, 80), cv::FILLED);
+        const double overlap = std::min(x0 + barWidth, static_cast<double>(box.x + box.width)) - std::max(x0, static_cast<double>(box.x));
+        truth.occluded = box.width > 0 ? std::max(0.0, overlap) / box.width : 0.0;
+    }
+
+    cv::Mat image;
+    canvas.convertTo(image, CV_32FC3);
+
+    // Global gain flicker times a brightness gradient that swings across the image
+    if (options.lighting > 0.0)
+    {
+        const double gain = 1.0 + 0.6 * options.lighting * std::sin(2 * kPi * seconds / 3.0);
+        const double slope = 0.5 * options.lighting * std::cos(2 * kPi * seconds / 5.0);
+        cv::Mat row(1, size.width, CV_32FC3), gains;
+        for (int x = 0; x < size.width; ++x)
+            row.at<cv::Vec3f>(0, x) = cv::Vec3f::all(static_cast<float>(gain * (1.0 + slope * (2.0 * x / size.width - 1.0))));
+        cv::repeat(row, size.height, 1, gains);
+        image = image.mul(gains);
+    }
+
+    // Motion blur along the image motion of the target centre during the exposure
+    if (options.motionBlur > 0.0 && index > 0)
+    {
+        const ar::Pose previous = poseAt(seconds - options.motionBlur / options.fps);
+        auto centre = [&](const ar::Pose &pose)
+        {
+            const cv::Matx33d K(cameraMatrix);
+            return cv::Point2d(K(0, 0) * pose.tvec.x / pose.tvec.z + K(0, 2), K(1, 1) * pose.tvec.y / pose.tvec.z + K(1, 2));
+        };
+        const cv::Point2d motion = centre(truth.pose) - centre(previous);
+        const double length = std::hypot(motion.x, motion.y);
+        if (length > 1.0)
+        {
+            const int k = 2 * static_cast<int>(std::ceil(length / 2)) + 1;
+            cv::Mat kernel = cv::Mat::zeros(k, k, CV_32F);
+            const cv::Point2d half = motion * 0.5;
+            const cv::Point2d c(k / 2, k / 2);
+            cv::line(kernel, c - half, c + half, cv::Scalar(1.0), 1, cv::LINE_AA);
+            kernel /= cv::sum(kernel)[0];
+            cv::filter2D(image, image, -1, kernel, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+        }
+    }
+
+    if (options.blurSigma > 0.0)
+        cv::GaussianBlur(image, image, cv::Size(), options.blurSigma);
+
+    if (!distortX.empty())
+        cv::remap(image, image, distortX, distortY, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+
+    // Sensor noise last; every frame has its own seed so frames render independently
+    if (options.noiseSigma > 0.0)
+    {
+        cv::RNG rng(options.seed + static_cast<unsigned>(index));
+        cv::Mat noise(size, CV_32FC3);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(options.noiseSigma));
+        image += noise;
+    }
+
+    cv::Mat frame;
+    image.convertTo(frame, CV_8UC3);
+    return frame;
+}
+
+bool SyntheticGenerator::generate(const std::filesystem::path &dir)
+{
+    const std::filesystem::path framesDir = dir / "frames";
+    std::filesystem::create_directories(framesDir);
+
+    std::vector<SyntheticFrame> truths(options.frames);
+    std::atomic<int> failed{0};
+    ThreadPool::shared().parallelFor(0, options.frames, [&](int begin, int end)
+                                     {
+                                         for (int i = begin; i < end; ++i)
+                                         {
+                                             std::ostringstream name;
+                                             name << "frame_" << std::setw(5) << std::setfill('0') << i << ".png";
+                                             if (!cv::imwrite((framesDir / name.str()).string(), render(i, truths[i])))
+                                                 failed++;
+                                         } });
+    if (failed > 0)
+    {
+        std::cerr << "Unable to write " << failed << " frames to " << framesDir << std::endl;
+        return false;
+    }
+
+    // The intrinsics the frames were rendered with travel with the sequence (zero distortion when it was off)
+    saveCalibrationData(dir, cameraMatrix, distCoeffs, 0.0, options.imageSize);
+
+    nlohmann::json root;
+    root["tracker"] = options.useNft ? "nft" : "chessboard";
+    root["pattern"] = {options.patternSize.width, options.patternSize.height};
+    root["square_size"] = options.squareSize;
+    root["reference"] = options.referencePath;
+    root["source_calibration"] = calibrationJson.string();
+    root["image_size"] = {options.imageSize.width, options.imageSize.height};
+    root["fps"] = options.fps;
+    root["trajectory"] = trajectoryName(options.trajectory);
+    root["nominal_distance"] = nominalDistance;
+    root["effects"] = {{"blur_sigma", options.blurSigma},
+                       {"motion_blur", options.motionBlur},
+                       {"noise_sigma", options.noiseSigma},
+                       {"lighting", options.lighting},
+                       {"occlusion", options.occlusion},
+                       {"distort", options.distort},
+                       {"seed", options.seed}};
+    root["frames"] = nlohmann::json::array();
+    for (const auto &f : truths)
+        root["frames"].push_back({{"frame_id", f.frame_id},
+                                  {"timestamp", f.timestamp},
+                                  {"rvec", {f.pose.rvec.x, f.pose.rvec.y, f.pose.rvec.z}},
+                                  {"tvec", {f.pose.tvec.x, f.pose.tvec.y, f.pose.tvec.z}},
+                                  {"visible", f.visible},
+                                  {"occluded", f.occluded}});
+    std::ofstream out(dir / "ground_truth.json");
+    if (!out.is_open())
+    {
+        std::cerr << "Unable to write " << dir / "ground_truth.json" << std::endl;
+        return false;
+    }
+    out << root.dump(4);
+    return true;
+}
+
+nlohmann::json evaluateSynthetic(const std::filesystem::path &dir, PoseSolver solver, unsigned threads)
+{
+    nlohmann::json truth;
+    {
+        std::ifstream in(dir / "ground_truth.json");
+        if (!in.is_open())
+        {
+            std::cerr << "No ground_truth.json in " << dir << std::endl;
+            return {};
+        }
+        try
+        {
+            in >> truth;
+        }
+        catch (const nlohmann::json::exception &e)
+        {
+            std::cerr << "Invalid ground truth: " << e.what() << std::endl;
+            return {};
+        }
+    }
+
+    // Track the frames exactly as ar_batch would, with the intrinsics they were rendered with
+    BatchOptions batch;
+    batch.useNft = truth.value("tracker", std::string("chessboard")) == "nft";
+    batch.patternSize = cv::Size(truth["pattern"][0].get<int>(), truth["pattern"][1].get<int>());
+    batch.squareSize = truth.value("square_size", batch.squareSize);
+    batch.referencePath = truth.value("reference", batch.referencePath);
+    batch.calibrationPath = dir / "calibration.json";
+    batch.solver = solver;
+    batch.threads = threads;
+    BatchProcessor processor(batch);
+    if (!processor.init())
+        return {};
+    SessionStats stats;
+    processor.process(dir / "frames", stats);
+
+    cv::Mat cameraMatrix, distCoeffs;
+    ar::loadCalibrationData(batch.calibrationPath, cameraMatrix, distCoeffs);
+    // A point-symmetric board is found equally well from either end: compare modulo 180 degrees about its normal
+    const bool symmetric = !batch.useNft && (batch.patternSize.width + batch.patternSize.height) % 2 == 0;
+    const ar::Mat3 flip = ar::Mat3::fromRotationVector({0, 0, kPi});
+
+    // Reprojection error is measured on the target outline (the board's outer inner corners, the reference corners)
+    std::vector<cv::Point3f> outline;
+    if (batch.useNft)
+    {
+        const cv::Mat reference = cv::imread(batch.referencePath, cv::IMREAD_GRAYSCALE);
+        const float s = NFTTracker(batch.referencePath).objectScale();
+        // Centres of the corner pixels, mapped like NFTTracker::toObjectPoint
+        const float x0 = -reference.cols * 0.5f * s, x1 = (reference.cols * 0.5f - 1) * s;
+        const float y0 = -reference.rows * 0.5f * s, y1 = (reference.rows * 0.5f - 1) * s;
+        outline = {{x0, y0, 0}, {x1, y0, 0}, {x1, y1, 0}, {x0, y1, 0}};
+    }
+    else
+    {
+        const float cx = (batch.patternSize.width - 1) * batch.squareSize / 2.0f;
+        const float cy = (batch.patternSize.height - 1) * batch.squareSize / 2.0f;
+        outline = {{-cx, -cy, 0}, {cx, -cy, 0}, {cx, cy, 0}, {-cx, cy, 0}};
+    }
+    auto project = [&](const ar::Pose &pose)
+    {
+        std::vector<cv::Point2f> points;
+        cv::projectPoints(outline, pose.rvec.toCv(), pose.tvec.toCv(), cameraMatrix, cv::Mat(), points);
+        return points;
+    };
+
+    nlohmann::json frames = nlohmann::json::array();
+    std::vector<double> rotationErrors, translationErrors, relativeErrors, cornerErrors, frameTimes, trackTimes;
+    int visible = 0, detected = 0, falsePositives = 0, grossErrors = 0;
+    const auto &truthFrames = truth["frames"];
+    for (size_t i = 0; i < std::min(truthFrames.size(), stats.frames.size()); ++i)
+    {
+        const auto &t = truthFrames[i];
+        const FrameStats &f = stats.frames[i];
+        const ar::Pose gt{{t["rvec"][0].get<double>(), t["rvec"][1].get<double>(), t["rvec"][2].get<double>()},
+                          {t["tvec"][0].get<double>(), t["tvec"][1].get<double>(), t["tvec"][2].get<double>()}};
+        const bool isVisible = t.value("visible", true);
+        visible += isVisible;
+        frameTimes.push_back(f.frameTimeMs);
+        trackTimes.push_back(f.trackMs);
+
+        nlohmann::json frame = {{"frame_id", f.frame_id},
+                                {"visible", isVisible},
+                                {"success", f.poseSuccess},
+                                {"frame_time_ms", f.frameTimeMs},
+                                {"track_ms", f.trackMs}};
+        if (f.poseSuccess)
+        {
+            if (!isVisible)
+                falsePositives++;
+            else
+                detected++;
+            double rotation = ar::rotationAngle(f.pose.rotation(), gt.rotation());
+            if (symmetric)
+                rotation = std::min(rotation, ar::rotationAngle(f.pose.rotation(), gt.rotation() * flip));
+            rotation *= 180.0 / kPi;
+            const double translation = (f.pose.tvec - gt.tvec).norm();
+            // Outline corners of the estimate against the truth, in either order for a symmetric board
+            const std::vector<cv::Point2f> estimated = project(f.pose), expected = project(gt);
+            double corner = 0.0, flipped = 0.0;
+            for (size_t k = 0; k < expected.size(); ++k)
+            {
+                corner += cv::norm(estimated[k] - expected[k]) / expected.size();
+                flipped += cv::norm(estimated[(k + 2) % expected.size()] - expected[k]) / expected.size();
+            }
+            if (symmetric)
+                corner = std::min(corner, flipped);
+
+            rotationErrors.push_back(rotation);
+            translationErrors.push_back(translation);
+            relativeErrors.push_back(translation / std::max(1e-9, gt.tvec.norm()));
+            cornerErrors.push_back(corner);
+            if (rotation > 5.0 || corner > 10.0)
+                grossErrors++;
+            frame["rotation_error_deg"] = rotation;
+            frame["translation_error"] = translation;
+            frame["corner_error_px"] = corner;
+        }
+        frames.push_back(frame);
+    }
+
+    nlohmann::json root;
+    root["summary"] = {{"frames", frames.size()},
+                       {"visible_frames", visible},
+                       {"detection_rate", visible > 0 ? static_cast<double>(detected) / visible : 0.0},
+                       {"false_positives", falsePositives},
+                       {"gross_errors", grossErrors},
+                       {"rotation_error_deg", spread(rotationErrors)},
+                       {"translation_error", spread(translationErrors)},
+                       {"relative_translation_error", spread(relativeErrors)},
+                       {"corner_error_px", spread(cornerErrors)},
+                       {"frame_time_ms", spread(frameTimes)},
+                       {"track_ms", spread(trackTimes)}};
+    root["frames"] = frames;
+    return root;
+}
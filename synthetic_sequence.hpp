@@ -0,0 +1,89 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "ar_math.hpp"
+#include "tracker.hpp"
+
+// Camera paths of synthetic sequences
+enum class SyntheticTrajectory
+{
+    Orbit,    // Tilts around the target at a constant distance
+    Approach, // Moves from far to close while tilting
+    Shake     // Hand-held jitter around a frontal view (fast motion, blur)
+};
+
+// Parse "orbit", "approach" or "shake"
+bool parseTrajectory(const std::string &text, SyntheticTrajectory &trajectory);
+
+// Settings of a synthetic sequence
+struct SyntheticOptions
+{
+    bool useNft = false;                                     // Warp the NFT reference instead of rendering a chessboard
+    cv::Size patternSize{8, 6};                              // Inner corners of the chessboard
+    float squareSize = 25.0f;                                // Physical square size
+    std::string referencePath = "data/reference/reference.png"; // NFT reference image
+    std::filesystem::path calibrationPath;                   // Intrinsics and distortion of the rendered camera (empty = data/calibration/<WxH>)
+    cv::Size imageSize;                                      // Frame size (empty: the calibrated resolution, 640x480 when unknown)
+    int frames = 300;                                        // Sequence length
+    double fps = 30.0;                                       // Frame rate of the timestamps (image sequences read back at 30 fps)
+    SyntheticTrajectory trajectory = SyntheticTrajectory::Orbit;
+    double coverage = 0.5;   // Target width as a fraction of the image width at the nominal distance
+    double blurSigma = 0.0;  // Gaussian defocus blur in pixels
+    double motionBlur = 0.0; // Exposure as a fraction of the frame interval (0: no motion blur)
+    double noiseSigma = 0.0; // Gaussian sensor noise in grey levels
+    double lighting = 0.0;   // Amplitude of global gain changes and a moving brightness gradient (0..1)
+    double occlusion = 0.0;  // Width of an occluder sweeping over the target, as a fraction of the target width
+    bool distort = true;     // Apply the calibrated lens distortion
+    unsigned seed = 1;       // Noise seed (frame i uses seed + i, so frames can be rendered in any order)
+};
+
+// Ground truth of one frame
+struct SyntheticFrame
+{
+    int frame_id = 0;
+    double timestamp = 0.0;
+    ar::Pose pose;          // Target pose in the tracker's object frame (OpenCV camera coordinates)
+    bool visible = false;   // Whole target inside the image
+    double occluded = 0.0;  // Fraction of the target width behind the occluder
+};
+
+// Renders the chessboard, or warps the NFT reference, along a known trajectory with the calibrated
+// intrinsics. Object coordinates match the trackers' (board centred on its inner corners, reference
+// centred and scaled by NFTTracker::objectScale()), so estimated poses compare directly to the truth.
+class SyntheticGenerator
+{
+public:
+    explicit SyntheticGenerator(const SyntheticOptions &options) : options(options) {}
+
+    // Load the calibration and build the target texture
+    bool init();
+
+    // Write <dir>/frames/frame_NNNNN.png and <dir>/ground_truth.json; frames are rendered in parallel
+    bool generate(const std::filesystem::path &dir);
+
+    // Render one frame (BGR) and its ground truth
+    cv::Mat render(int index, SyntheticFrame &truth) const;
+
+    SyntheticOptions options;
+
+private:
+    ar::Pose poseAt(double seconds) const;
+    // Target outline (texture corners) projected with the pinhole intrinsics
+    std::vector<cv::Point2f> outline(const ar::Pose &pose) const;
+
+    cv::Mat texture;                       // Board or reference, BGR
+    cv::Matx33d textureToObject;           // Texture pixel -> object plane coordinates
+    cv::Mat background;                    // Static clutter behind the target
+    cv::Mat cameraMatrix, distCoeffs;      // Intrinsics at imageSize, lens distortion (zero when off)
+    cv::Mat distortX, distortY;            // remap from the pinhole render to the distorted image
+    double nominalDistance = 0.0;          // Distance at which the target spans `coverage` of the width
+    std::filesystem::path calibrationJson; // Source of the intrinsics
+};
+
+// Track a generated sequence with the given solver (through BatchProcessor) and compare against its
+// ground truth: absolute rotation / translation error and outline reprojection error next to the
+// per-frame latency. Returns {"summary": ..., "frames": [...]}, empty on failure.
+nlohmann::json evaluateSynthetic(const std::filesystem::path &dir, PoseSolver solver, unsigned threads = 0);
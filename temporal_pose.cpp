@@ -0,0 +1,113 @@
+#include "temporal_pose.hpp"
+#include "pose_refine.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Correspondences of all that reproject within threshold (normalized units) under (R, t)
+static PoseCorrespondences selectInliers(const PoseCorrespondences &all, const cv::Matx33d &R, const cv::Vec3d &t, double threshold)
+{
+    PoseCorrespondences inliers;
+    inliers.focal = all.focal;
+    const double threshold2 = threshold * threshold;
+    for (int i = 0; i < all.size(); ++i)
+    {
+        const double x = R(0, 0) * all.X[i] + R(0, 1) * all.Y[i] + R(0, 2) * all.Z[i] + t[0];
+        const double y = R(1, 0) * all.X[i] + R(1, 1) * all.Y[i] + R(1, 2) * all.Z[i] + t[1];
+        const double z = R(2, 0) * all.X[i] + R(2, 1) * all.Y[i] + R(2, 2) * all.Z[i] + t[2];
+        if (z <= 0.0)
+            continue;
+        const double du = x / z - all.u[i];
+        const double dv = y / z - all.v[i];
+        if (du * du + dv * dv > threshold2)
+            continue;
+        inliers.X.push_back(all.X[i]);
+        inliers.Y.push_back(all.Y[i]);
+        inliers.Z.push_back(all.Z[i]);
+        inliers.u.push_back(all.u[i]);
+        inliers.v.push_back(all.v[i]);
+    }
+    return inliers;
+}
+
+int TemporalPoseSolver::iterationCap() const
+{
+    return cap > 0 ? std::clamp(cap, options.minIterations, options.maxIterations) : options.maxIterations;
+}
+
+TemporalPoseResult TemporalPoseSolver::refine(const std::vector<cv::Point3f> &objectPoints,
+                                              const std::vector<cv::Point2f> &imagePoints,
+                                              const cv::Mat &cameraMatrix,
+                                              const cv::Mat &distCoeffs,
+                                              cv::Mat &rvec,
+                                              cv::Mat &tvec)
+{
+    TemporalPoseResult result;
+    if (history == 0)
+        return result;
+
+    // Seed: last pose, or its constant-velocity extrapolation
+    cv::Matx33d R = lastR;
+    cv::Vec3d t = lastT;
+    if (options.predictVelocity && history == 2)
+    {
+        R = lastR * prevR.t() * lastR;
+        t = lastT + (lastT - prevT);
+    }
+
+    const PoseCorrespondences all = PoseCorrespondences::from(objectPoints, imagePoints, cameraMatrix, distCoeffs);
+    const bool gated = options.inlierThresholdPx > 0.0;
+    const double threshold = options.inlierThresholdPx / all.focal;
+    PoseCorrespondences pts = gated ? selectInliers(all, R, t, threshold) : all;
+
+    auto diverge = [&]()
+    {
+        result.diverged = true;
+        cap = options.maxIterations; // Give the next warm start the full budget
+        return result;
+    };
+    if (pts.size() < std::max(4, options.minInliers))
+        return diverge();
+
+    RefineOptions refine;
+    refine.maxIterations = iterationCap();
+    refine.lambda = 1e-3;
+    RefineResult refined = refinePose(pts, R, t, refine);
+    result.iterations = refined.iterations;
+
+    // Outliers near the seed may have been let in; re-gate around the refined pose
+    if (gated)
+    {
+        pts = selectInliers(all, R, t, threshold);
+        if (pts.size() < std::max(4, options.minInliers))
+            return diverge();
+    }
+    result.inliers = pts.size();
+    result.rmsPx = reprojectionRms(pts, R, t);
+
+    if (!(result.rmsPx <= options.maxRmsPx) || t[2] <= 0.0)
+        return diverge();
+
+    // Converged early: shrink the cap towards what was needed; hit the cap: allow more next time
+    if (refined.converged)
+        cap = refined.iterations + 1;
+    else
+        cap = 2 * iterationCap();
+
+    cv::Rodrigues(R, rvec);
+    tvec = cv::Mat(t, true);
+    result.success = true;
+    return result;
+}
+
+void TemporalPoseSolver::update(const cv::Mat &rvec, const cv::Mat &tvec)
+{
+    cv::Mat r, t;
+    rvec.convertTo(r, CV_64F);
+    tvec.convertTo(t, CV_64F);
+
+    prevR = lastR;
+    prevT = lastT;
+    cv::Rodrigues(r, lastR);
+    lastT = cv::Vec3d(t.ptr<double>());
+    history = std::min(history + 1, 2);
+}
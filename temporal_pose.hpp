@@ -0,0 +1,62 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Settings for warm-started pose refinement
+struct TemporalPoseOptions
+{
+    bool predictVelocity = true;    // Seed from a constant-velocity extrapolation of the last two poses
+    int minIterations = 2;          // Lower bound of the adaptive iteration cap
+    int maxIterations = 10;         // Upper bound of the adaptive iteration cap
+    double inlierThresholdPx = 0.0; // Use only correspondences this close to the seed (0 = use all)
+    int minInliers = 8;             // Fewer correspondences around the seed is a divergence
+    double maxRmsPx = 3.0;          // Final RMS reprojection error above this is a divergence
+};
+
+// Outcome of a warm-started refinement
+struct TemporalPoseResult
+{
+    bool success = false;  // Refined pose accepted
+    bool diverged = false; // A seed was available but the refined pose was rejected
+    int inliers = 0;       // Correspondences used by the refinement
+    int iterations = 0;    // Levenberg-Marquardt iterations performed
+    double rmsPx = 0.0;    // Final RMS reprojection error (pixels)
+};
+
+// Iterative PnP seeded with the previous frame's pose
+// Tracks the last two accepted poses, refines the (optionally extrapolated) pose with
+// Levenberg-Marquardt and adapts the iteration cap to how quickly recent frames converged.
+// The caller solves cold when refine() fails and reports every outcome via update() / reset().
+class TemporalPoseSolver
+{
+public:
+    explicit TemporalPoseSolver(const TemporalPoseOptions &options = {}) : options(options) {}
+
+    // Refine from the predicted pose; fails without a seed or on divergence
+    TemporalPoseResult refine(const std::vector<cv::Point3f> &objectPoints,
+                              const std::vector<cv::Point2f> &imagePoints,
+                              const cv::Mat &cameraMatrix,
+                              const cv::Mat &distCoeffs,
+                              cv::Mat &rvec,
+                              cv::Mat &tvec);
+
+    // Record an accepted pose (warm or cold)
+    void update(const cv::Mat &rvec, const cv::Mat &tvec);
+
+    // Forget the history after a tracking failure
+    void reset() { history = 0; }
+
+    // A previous pose is available
+    bool hasSeed() const { return history > 0; }
+
+    // Iteration cap used by the next refine()
+    int iterationCap() const;
+
+    TemporalPoseOptions options;
+
+private:
+    cv::Matx33d lastR, prevR; // Last two accepted rotations
+    cv::Vec3d lastT, prevT;   // Last two accepted translations
+    int history = 0;          // Accepted poses stored above (0..2)
+    int cap = 0;              // Adaptive iteration cap (0 = maxIterations)
+};
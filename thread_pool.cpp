@@ -0,0 +1,236 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+// Identify the pool and worker slot of the calling thread
+static thread_local const ThreadPool *tlsPool = nullptr;
+static thread_local int tlsWorkerIndex = -1;
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Create the per-worker deques before any thread can try to steal from them
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back([this, i]
+                             { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task)
+{
+    // Keep work local to the submitting worker, otherwise spread it round-robin
+    unsigned index;
+    if (tlsPool == this)
+        index = static_cast<unsigned>(tlsWorkerIndex);
+    else
+        index = nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+
+    // Counted before it is visible, so a worker cannot take it (and decrement) first
+    // and waitIdle cannot return while it sits uncounted in a deque
+    pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+
+    // Lock before notifying so a worker that is about to sleep cannot miss the wake-up
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::popLocal(unsigned index, Task &task)
+{
+    Queue &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned index, Task &task)
+{
+    // Start with the neighbour so that thieves do not all hammer worker 0
+    for (unsigned offset = 1; offset < size(); ++offset)
+    {
+        Queue &victim = *queues[(index + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned index)
+{
+    tlsPool = this;
+    tlsWorkerIndex = static_cast<int>(index);
+
+    while (true)
+    {
+        Task task;
+        if (popLocal(index, task) || steal(index, task))
+        {
+            // Count as active before leaving the pending set so waitIdle never sees a gap
+            active.fetch_add(1);
+            pending.fetch_sub(1);
+            // A throwing task must not take the worker (and the process) down with it;
+            // callers that need the error catch it in the task itself
+            try
+            {
+                task();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Thread pool task failed: " << e.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cerr << "Thread pool task failed with an unknown exception" << std::endl;
+            }
+            if (active.fetch_sub(1) == 1 && pending.load() == 0)
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        // A task is counted but still being moved between deques, try again
+        if (pending.load() > 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]
+                  { return stopping || pending.load() > 0; });
+        if (stopping && pending.load() == 0)
+            return;
+    }
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)> &body, int grain)
+{
+    if (end <= begin)
+        return;
+
+    // Aim for a few chunks per participant so stealing can even out uneven chunks
+    const int count = end - begin;
+    const int participants = static_cast<int>(size()) + 1;
+    const int chunkSize = std::max(std::max(1, grain), (count + participants * 4 - 1) / (participants * 4));
+    const int chunks = (count + chunkSize - 1) / chunkSize;
+    if (chunks == 1)
+    {
+        body(begin, end);
+        return;
+    }
+
+    // Shared between the caller and helper tasks. Helpers that start after all chunks
+    // are claimed never touch body, so holding it by pointer is safe.
+    struct State
+    {
+        const std::function<void(int, int)> *body;
+        int begin, end, chunkSize, chunks;
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->body = &body;
+    state->begin = begin;
+    state->end = end;
+    state->chunkSize = chunkSize;
+    state->chunks = chunks;
+
+    // Claim and run chunks until none are left
+    auto drain = [](State &s)
+    {
+        int chunk;
+        while ((chunk = s.next.fetch_add(1)) < s.chunks)
+        {
+            const int b = s.begin + chunk * s.chunkSize;
+            const int e = std::min(s.end, b + s.chunkSize);
+            try
+            {
+                (*s.body)(b, e);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (!s.error)
+                    s.error = std::current_exception();
+            }
+            if (s.done.fetch_add(1) + 1 == s.chunks)
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.finished.notify_all();
+            }
+        }
+    };
+
+    const int helpers = std::min(chunks - 1, static_cast<int>(size()));
+    for (int i = 0; i < helpers; ++i)
+    {
+        submit([state, drain]
+               { drain(*state); });
+    }
+    drain(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]
+                         { return state->done.load() == state->chunks; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+void ThreadPool::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idle.wait(lock, [this]
+              { return pending.load() == 0 && active.load() == 0; });
+}
+
+int ThreadPool::currentWorker() const
+{
+    return tlsPool == this ? tlsWorkerIndex : -1;
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
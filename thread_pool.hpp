@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool
+// Every worker owns a task deque: it pops its own work from the back (LIFO, cache friendly)
+// and steals from the front of the other workers' deques when it runs dry.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // threadCount == 0 uses one worker per hardware thread
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of worker threads
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    // Queue a task. Tasks submitted from a worker go to that worker's own deque,
+    // tasks from outside the pool are distributed round-robin.
+    void submit(Task task);
+
+    // Run body(chunkBegin, chunkEnd) over [begin, end) split into chunks of at least `grain` items.
+    // The calling thread takes part in the work, so this is safe to call from inside a pool task.
+    // The first exception thrown by body is rethrown in the caller.
+    void parallelFor(int begin, int end, const std::function<void(int, int)> &body, int grain = 1);
+
+    // Block until every queued task has finished
+    void waitIdle();
+
+    // Index of the calling worker in this pool, or -1 when called from any other thread
+    int currentWorker() const;
+
+    // Process-wide pool shared by the per-frame parallel stages
+    static ThreadPool &shared();
+
+private:
+    // Per-worker task deque
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool popLocal(unsigned index, Task &task); // Pop from the back of our own deque
+    bool steal(unsigned index, Task &task);    // Take from the front of another worker's deque
+
+    std::vector<std::unique_ptr<Queue>> queues; // One deque per worker
+    std::vector<std::thread> workers;           // Worker threads
+
+    std::mutex sleepMutex;           // Guards the sleep/wake condition
+    std::condition_variable wake;    // Signalled when work arrives or on shutdown
+    std::condition_variable idle;    // Signalled when the last running task finishes
+    std::atomic<int> pending{0};     // Tasks queued but not started
+    std::atomic<int> active{0};      // Tasks currently running
+    std::atomic<unsigned> nextQueue{0}; // Round-robin cursor for external submissions
+    bool stopping = false;
+};
@@ -0,0 +1,69 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "session_analytics.hpp"
+#include "thread_pool.hpp"
+
+// Summary tables of a whole statistics tree, written as CSV for the plotting scripts
+static void printUsage()
+{
+    std::cout << "Usage: ar_analytics [options] [statistics-dir]\n"
+              << "  statistics-dir        Tree of session files (default: data/statistics)\n"
+              << "  --output DIR          Where the CSV files go (default: data/analytics)\n"
+              << "  --prefix TEXT         File name prefix of session files (default: session_stats, \"\" = every .json)\n"
+              << "  --no-frames           Only the summary tables, without frames.csv and intervals.csv\n"
+              << "  --include-old         Also read superseded recordings (*_old.json)\n";
+}
+
+int main(int argc, char **argv)
+{
+    AnalyticsOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--output")
+            options.outputDir = value();
+        else if (arg == "--prefix")
+            options.prefix = value();
+        else if (arg == "--no-frames")
+            options.frameRows = false;
+        else if (arg == "--include-old")
+            options.skipOld = false;
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+            options.root = arg;
+    }
+
+    const AnalyticsResult result = analyzeSessions(options);
+    if (result.sessions.empty())
+    {
+        std::cerr << "No session files found in " << options.root << std::endl;
+        return 1;
+    }
+    std::cout << "Read " << result.sessions.size() << " sessions in " << result.seconds << " s on "
+              << ThreadPool::shared().size() << " threads";
+    if (!result.failed.empty())
+        std::cout << " (" << result.failed.size() << " unreadable)";
+    std::cout << std::endl;
+
+    if (!writeAnalytics(result, options))
+        return 1;
+    std::cout << "Tables saved to " << options.outputDir << std::endl;
+    return 0;
+}
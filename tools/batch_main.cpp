@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "batch_processor.hpp"
+
+// Offline batch mode: track recorded videos / image directories on all cores
+static void printUsage()
+{
+    std::cout << "Usage: ar_batch [options] <video|image-dir>...\n"
+              << "  --nft                 Use the NFT tracker (default: chessboard)\n"
+              << "  --pattern WxH         Chessboard inner corners (default: 8x6)\n"
+              << "  --square S            Chessboard square size (default: 25)\n"
+              << "  --reference PATH      NFT reference image (default: data/reference/reference.png)\n"
+              << "  --multi-view          NFT: match against zoomed-out and tilted views of the reference\n"
+              << "  --chess-corners       Chessboard: ChESS saddle-point detector instead of cv::findChessboardCorners\n"
+              << "  --calibration PATH    calibration.json (default: data/calibration/<WxH>/calibration.json)\n"
+              << "  --output DIR          Output directory for session JSON (default: data/statistics/Batch)\n"
+              << "  --threads N           Worker threads (default: all cores)\n"
+              << "  --solver NAME         Pose solver: opencv (default), robust or planar\n";
+}
+
+int main(int argc, char **argv)
+{
+    BatchOptions options;
+    std::vector<std::filesystem::path> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--nft")
+            options.useNft = true;
+        else if (arg == "--pattern")
+        {
+            if (!parsePatternSize(value(), options.patternSize))
+            {
+                std::cerr << "Invalid pattern size, expected WxH" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--square")
+            options.squareSize = std::stof(value());
+        else if (arg == "--reference")
+            options.referencePath = value();
+        else if (arg == "--multi-view")
+            options.multiView = true;
+        else if (arg == "--chess-corners")
+            options.chessCorners = true;
+        else if (arg == "--calibration")
+            options.calibrationPath = value();
+        else if (arg == "--output")
+            options.outputDir = value();
+        else if (arg == "--threads")
+            options.threads = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--solver")
+        {
+            const std::string name = value();
+            if (name == "opencv")
+                options.solver = PoseSolver::OpenCV;
+            else if (name == "robust")
+                options.solver = PoseSolver::Robust;
+            else if (name == "planar")
+                options.solver = PoseSolver::Planar;
+            else
+            {
+                if (name == "temporal")
+                    std::cerr << "The temporal solver needs consecutive frames; use ar_bench planar for it" << std::endl;
+                else
+                    std::cerr << "Unknown solver " << name << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+            inputs.push_back(arg);
+    }
+
+    if (inputs.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Parallelism comes from the frame-level pool; nested OpenCV threads would only oversubscribe
+    cv::setNumThreads(1);
+
+    BatchProcessor processor(options);
+    if (!processor.init())
+        return 1;
+    std::cout << "Processing " << inputs.size() << " input(s) on " << processor.workerCount() << " worker(s)" << std::endl;
+
+    size_t totalFrames = 0;
+    double totalSeconds = 0.0;
+    for (const auto &result : processor.run(inputs))
+    {
+        totalFrames += result.frames;
+        totalSeconds += result.wallSeconds;
+    }
+    if (totalSeconds > 0)
+        std::cout << "Total: " << totalFrames << " frames, " << totalFrames / totalSeconds << " fps" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "batch_processor.hpp"
+#include "chessboard_tracker.hpp"
+#include "frame_reader.hpp"
+#include "calibration_store.hpp"
+#include "nft_tracker.hpp"
+#include "robust_pose.hpp"
+#include "statistics.hpp"
+
+// Solver benchmarks on recorded frames
+// Every solver sees exactly the same correspondences, so the numbers only differ by the solver.
+
+// Timing and quality samples of one solver
+struct SolverSamples
+{
+    std::string name;
+    std::vector<double> latencyMs;   // Solver time per frame
+    std::vector<double> inlierRatio; // Inliers / correspondences per frame
+    int successes = 0;               // Frames with an accepted pose
+    int frames = 0;                  // Frames the solver ran on
+};
+
+// Value at quantile q of an unsorted sample
+static double percentile(std::vector<double> v, double q)
+{
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t index = static_cast<size_t>(q * (v.size() - 1) + 0.5);
+    return v[std::min(index, v.size() - 1)];
+}
+
+static double mean(const std::vector<double> &v)
+{
+    return v.empty() ? 0.0 : std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+}
+
+// Print one row per solver
+static void printTable(const std::vector<SolverSamples> &rows)
+{
+    std::cout << std::left << std::setw(16) << "solver"
+              << std::right << std::setw(10) << "mean ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+              << std::setw(10) << "success" << std::setw(14) << "inlier ratio" << std::endl;
+    for (const auto &r : rows)
+    {
+        std::cout << std::left << std::setw(16) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << mean(r.latencyMs)
+                  << std::setw(10) << percentile(r.latencyMs, 0.5)
+                  << std::setw(10) << percentile(r.latencyMs, 0.95)
+                  << std::setw(10) << (r.frames ? static_cast<double>(r.successes) / r.frames : 0.0)
+                  << std::setw(14) << mean(r.inlierRatio) << std::endl;
+    }
+}
+
+// Undistorts frames exactly like augmentLoop
+class Undistorter
+{
+public:
+    bool load(const std::filesystem::path &calibrationJson)
+    {
+        if (!calibration.load(calibrationJson))
+        {
+            std::cerr << "Unable to read " << calibrationJson << std::endl;
+            return false;
+        }
+        zeroDist = cv::Mat::zeros(4, 1, CV_64F);
+        return true;
+    }
+
+    // Also switches cameraMatrix to the intrinsics of the frame size
+    void apply(const cv::Mat &frame, cv::Mat &undistorted)
+    {
+        const ResolutionIntrinsics &intrinsics = calibration.at(frame.size());
+        cameraMatrix = intrinsics.cameraMatrix;
+        cv::remap(frame, undistorted, intrinsics.map1, intrinsics.map2, cv::INTER_LINEAR);
+    }
+
+    cv::Mat cameraMatrix, zeroDist;
+
+private:
+    CalibrationStore calibration;
+};
+
+// Common options of the benchmarks
+struct BenchOptions
+{
+    std::filesystem::path calibrationPath = "data/calibration/8x6/calibration.json";
+    std::string referencePath = "data/reference/reference.png";
+    bool useNft = false;        // NFT correspondences instead of chessboard corners (planar)
+    cv::Size patternSize{8, 6}; // Chessboard inner corners
+    float squareSize = 25.0f;   // Chessboard square size
+    int maxFrames = 0;          // 0 = all frames
+    std::vector<std::filesystem::path> inputs;
+};
+
+// ransac: cv::solvePnPRansac against RobustPoseEstimator, cold and seeded with the previous pose
+static int benchRansac(const BenchOptions &options)
+{
+    Undistorter undistorter;
+    if (!undistorter.load(options.calibrationPath))
+        return 1;
+
+    NFTTracker nft(options.referencePath);
+    nft.init();
+    nft.showDebug = false;
+    RobustPoseEstimator robust;
+
+    SolverSamples opencvRows{"solvePnPRansac"}, coldRows{"robust"}, warmRows{"robust+prior"};
+    cv::Mat warmRvec, warmTvec;
+    bool warmValid = false;
+    int frameCount = 0;
+
+    for (const auto &input : options.inputs)
+    {
+        FrameReader reader(input);
+        cv::Mat frame, undistorted, gray;
+        while (reader.read(frame) && (options.maxFrames <= 0 || frameCount < options.maxFrames))
+        {
+            frameCount++;
+            undistorter.apply(frame, undistorted);
+            cv::cvtColor(undistorted, gray, cv::COLOR_BGR2GRAY);
+
+            NFTMatches m;
+            if (!nft.matchFrame(gray, m) || m.imagePoints.size() < 10)
+            {
+                warmValid = false;
+                continue;
+            }
+            const double n = static_cast<double>(m.imagePoints.size());
+
+            // Current call in NFTTracker
+            {
+                cv::Mat rvec, tvec, inlierMask;
+                auto start = std::chrono::high_resolution_clock::now();
+                bool ok = cv::solvePnPRansac(m.objectPoints, m.imagePoints, undistorter.cameraMatrix, undistorter.zeroDist,
+                                             rvec, tvec, false, 100, 8.0f, 0.99, inlierMask);
+                auto end = std::chrono::high_resolution_clock::now();
+                const int inliers = cv::countNonZero(inlierMask);
+                opencvRows.frames++;
+                opencvRows.latencyMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                opencvRows.inlierRatio.push_back(inliers / n);
+                opencvRows.successes += (ok && inliers >= 8);
+            }
+
+            // Robust estimator from scratch
+            {
+                cv::Mat rvec, tvec;
+                auto start = std::chrono::high_resolution_clock::now();
+                RobustPoseResult r = robust.estimate(m.objectPoints, m.imagePoints, m.distances,
+                                                     undistorter.cameraMatrix, undistorter.zeroDist, rvec, tvec, false);
+                auto end = std::chrono::high_resolution_clock::now();
+                coldRows.frames++;
+                coldRows.latencyMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                coldRows.inlierRatio.push_back(r.inliers / n);
+                coldRows.successes += r.success;
+            }
+
+            // Robust estimator seeded with its own previous pose, as in the live loop
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                RobustPoseResult r = robust.estimate(m.objectPoints, m.imagePoints, m.distances,
+                                                     undistorter.cameraMatrix, undistorter.zeroDist, warmRvec, warmTvec, warmValid);
+                auto end = std::chrono::high_resolution_clock::now();
+                warmValid = r.success;
+                warmRows.frames++;
+                warmRows.latencyMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                warmRows.inlierRatio.push_back(r.inliers / n);
+                warmRows.successes += r.success;
+            }
+        }
+    }
+
+    std::cout << frameCount << " frames, " << opencvRows.frames << " with enough matches" << std::endl;
+    printTable({opencvRows, coldRows, warmRows});
+    return 0;
+}
+
+// One solver of the planar benchmark: its own tracker (solver state such as the prior is
+// per tracker) and a session whose frame time is the solver latency
+struct PlanarRun
+{
+    SolverSamples samples;
+    std::unique_ptr<PoseTracker> tracker;
+    SessionStats stats;
+
+    void add(int frameId, double timestamp, bool ok, const cv::Mat &rvec, const cv::Mat &tvec, double n)
+    {
+        const PoseDiagnostics &d = tracker->lastDiagnostics;
+        samples.frames++;
+        samples.latencyMs.push_back(d.solveMs);
+        samples.inlierRatio.push_back(d.inliers / n);
+        samples.successes += ok;
+        FrameStats frame{frameId, timestamp, ok, ar::Pose::fromCv(rvec, tvec), d.solveMs};
+        frame.solverIterations = d.iterations;
+        frame.solveMs = d.solveMs;
+        frame.warmStarted = d.warmStarted;
+        stats.frames.push_back(frame);
+    }
+};
+
+// planar: homography + IPPE and the warm-started solver against the generic solvers, latency and pose jitter
+// (pose_stability of SessionStats; record a static target so the spread is pure jitter)
+static int benchPlanar(const BenchOptions &options)
+{
+    Undistorter undistorter;
+    if (!undistorter.load(options.calibrationPath))
+        return 1;
+
+    std::vector<PlanarRun> runs;
+    auto addRun = [&](const std::string &name, PoseSolver solver)
+    {
+        PlanarRun run;
+        run.samples.name = name;
+        if (options.useNft)
+            run.tracker = std::make_unique<NFTTracker>(options.referencePath);
+        else
+            run.tracker = std::make_unique<ChessboardTracker>(options.patternSize, options.squareSize);
+        run.tracker->init();
+        run.tracker->showDebug = false;
+        run.tracker->solver = solver;
+        runs.push_back(std::move(run));
+    };
+    if (options.useNft)
+    {
+        addRun("solvePnPRansac", PoseSolver::OpenCV);
+        addRun("robust", PoseSolver::Robust);
+        addRun("planar", PoseSolver::Planar);
+        addRun("temporal", PoseSolver::Temporal);
+    }
+    else
+    {
+        addRun("solvePnP", PoseSolver::OpenCV);
+        addRun("planar", PoseSolver::Planar);
+        addRun("temporal", PoseSolver::Temporal);
+    }
+
+    int frameCount = 0, usable = 0;
+    for (const auto &input : options.inputs)
+    {
+        FrameReader reader(input);
+        cv::Mat frame, undistorted, gray;
+        while (reader.read(frame) && (options.maxFrames <= 0 || frameCount < options.maxFrames))
+        {
+            const int frameId = frameCount++;
+            const double timestamp = reader.timestamp(frameId);
+            undistorter.apply(frame, undistorted);
+            cv::cvtColor(undistorted, gray, cv::COLOR_BGR2GRAY);
+
+            // Correspondences are found once by the first tracker and shared by every solver
+            cv::Mat rvec, tvec;
+            if (options.useNft)
+            {
+                NFTMatches m;
+                auto &detector = static_cast<NFTTracker &>(*runs.front().tracker);
+                if (!detector.matchFrame(gray, m) || m.imagePoints.size() < 10)
+                {
+                    for (auto &run : runs)
+                        static_cast<NFTTracker &>(*run.tracker).lostTrack();
+                    continue;
+                }
+                usable++;
+                for (auto &run : runs)
+                {
+                    auto &nft = static_cast<NFTTracker &>(*run.tracker);
+                    nft.lastDiagnostics = PoseDiagnostics();
+                    const bool ok = nft.solvePose(m, undistorter.cameraMatrix, undistorter.zeroDist, rvec, tvec);
+                    run.add(frameId, timestamp, ok, rvec, tvec, static_cast<double>(m.imagePoints.size()));
+                }
+            }
+            else
+            {
+                std::vector<cv::Point2f> corners;
+                auto &detector = static_cast<ChessboardTracker &>(*runs.front().tracker);
+                if (!detector.detectCorners(gray, corners))
+                {
+                    for (auto &run : runs)
+                        static_cast<ChessboardTracker &>(*run.tracker).temporal.reset();
+                    continue;
+                }
+                usable++;
+                for (auto &run : runs)
+                {
+                    auto &chessboard = static_cast<ChessboardTracker &>(*run.tracker);
+                    chessboard.lastDiagnostics = PoseDiagnostics();
+                    const bool ok = chessboard.solvePose(corners, undistorter.cameraMatrix, undistorter.zeroDist, rvec, tvec);
+                    run.add(frameId, timestamp, ok, rvec, tvec, static_cast<double>(corners.size()));
+                }
+            }
+        }
+    }
+
+    std::cout << frameCount << " frames, " << usable << " with correspondences" << std::endl;
+    std::vector<SolverSamples> rows;
+    for (const auto &run : runs)
+        rows.push_back(run.samples);
+    printTable(rows);
+
+    // Jitter of the accepted poses per solver
+    std::cout << std::endl;
+    for (const auto &run : runs)
+        std::cout << std::left << std::setw(16) << run.samples.name << run.stats.computePoseStability().dump() << std::endl;
+    return 0;
+}
+
+// Fraction of the cells of a cols x rows grid over the frame that contain at least one of the points
+static double gridCoverage(const std::vector<cv::Point2f> &points, cv::Size frameSize, int cols = 8, int rows = 6)
+{
+    std::vector<char> hit(cols * rows, 0);
+    for (const auto &p : points)
+    {
+        const int cx = std::min(cols - 1, std::max(0, static_cast<int>(p.x * cols / frameSize.width)));
+        const int cy = std::min(rows - 1, std::max(0, static_cast<int>(p.y * rows / frameSize.height)));
+        hit[cy * cols + cx] = 1;
+    }
+    return std::accumulate(hit.begin(), hit.end(), 0) / static_cast<double>(hit.size());
+}
+
+// features: single-pass ORB against the tile-parallel grid extractor, extraction time and match spread
+static int benchFeatures(const BenchOptions &options)
+{
+    Undistorter undistorter;
+    if (!undistorter.load(options.calibrationPath))
+        return 1;
+
+    struct FeatureRun
+    {
+        SolverSamples samples;           // latencyMs = extraction and matching time
+        std::vector<double> keypoints;   // Frame keypoints per frame
+        std::vector<double> coverage;    // Grid coverage of the inliers per frame
+        std::unique_ptr<NFTTracker> tracker;
+    };
+    std::vector<FeatureRun> runs(2);
+    runs[0].samples.name = "orb";
+    runs[1].samples.name = "grid";
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        runs[i].tracker = std::make_unique<NFTTracker>(options.referencePath);
+        runs[i].tracker->init();
+        runs[i].tracker->showDebug = false;
+        runs[i].tracker->gridFeatures = i == 1;
+    }
+
+    int frameCount = 0;
+    for (const auto &input : options.inputs)
+    {
+        FrameReader reader(input);
+        cv::Mat frame, undistorted, gray;
+        while (reader.read(frame) && (options.maxFrames <= 0 || frameCount < options.maxFrames))
+        {
+            frameCount++;
+            undistorter.apply(frame, undistorted);
+            cv::cvtColor(undistorted, gray, cv::COLOR_BGR2GRAY);
+
+            for (auto &run : runs)
+            {
+                NFTMatches m;
+                auto start = std::chrono::high_resolution_clock::now();
+                const bool matched = run.tracker->matchFrame(gray, m);
+                auto end = std::chrono::high_resolution_clock::now();
+                run.samples.frames++;
+                run.samples.latencyMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                run.keypoints.push_back(static_cast<double>(m.keypoints.size()));
+                if (!matched || m.imagePoints.size() < 10)
+                {
+                    run.coverage.push_back(0.0);
+                    continue;
+                }
+
+                // Same solver call as NFTTracker, so only the correspondences differ
+                cv::Mat rvec, tvec, inlierMask;
+                const bool ok = cv::solvePnPRansac(m.objectPoints, m.imagePoints, undistorter.cameraMatrix, undistorter.zeroDist,
+                                                   rvec, tvec, false, 100, 8.0f, 0.99, inlierMask);
+                std::vector<cv::Point2f> inliers;
+                for (int i = 0; i < inlierMask.rows; ++i)
+                    inliers.push_back(m.imagePoints[inlierMask.at<int>(i)]);
+                run.samples.inlierRatio.push_back(inliers.size() / static_cast<double>(m.imagePoints.size()));
+                run.samples.successes += (ok && inliers.size() >= 8);
+                run.coverage.push_back(gridCoverage(inliers, gray.size()));
+            }
+        }
+    }
+
+    std::cout << frameCount << " frames" << std::endl;
+    std::vector<SolverSamples> rows;
+    for (const auto &run : runs)
+        rows.push_back(run.samples);
+    printTable(rows);
+
+    std::cout << std::endl
+              << std::left << std::setw(16) << "extractor" << std::right << std::setw(12) << "keypoints" << std::setw(16) << "inlier coverage" << std::endl;
+    for (const auto &run : runs)
+        std::cout << std::left << std::setw(16) << run.samples.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << mean(run.keypoints) << std::setw(16) << mean(run.coverage) << std::endl;
+    return 0;
+}
+
+// corners: cv::findChessboardCorners against the ChESS detector on the same frames, both refined
+// with the tracker's sub-pixel step. Frames are not undistorted (calibration images are raw), and
+// the latency is compared again on the frames both detectors found the board in.
+static int benchCorners(const BenchOptions &options)
+{
+    struct CornerRun
+    {
+        SolverSamples samples;       // latencyMs = detection and refinement time
+        std::vector<double> bothMs;  // Time on the frames both detectors found the board in
+        std::unique_ptr<ChessboardTracker> tracker;
+        std::vector<cv::Point2f> corners;
+        bool found = false;
+    };
+    std::vector<CornerRun> runs(2);
+    runs[0].samples.name = "opencv";
+    runs[1].samples.name = "chess";
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        runs[i].tracker = std::make_unique<ChessboardTracker>(options.patternSize, options.squareSize);
+        runs[i].tracker->init();
+        runs[i].tracker->showDebug = false;
+        runs[i].tracker->chessCorners = i == 1;
+    }
+
+    constexpr double kAgreePx = 2.0; // Same corner order when no corner is further apart than this
+    int frameCount = 0, both = 0, agreeing = 0;
+    std::vector<double> meanDistance;
+    double maxDistance = 0.0;
+    for (const auto &input : options.inputs)
+    {
+        FrameReader reader(input);
+        cv::Mat frame, gray;
+        while (reader.read(frame) && (options.maxFrames <= 0 || frameCount < options.maxFrames))
+        {
+            frameCount++;
+            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+
+            for (auto &run : runs)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                run.found = run.tracker->detectCorners(gray, run.corners);
+                auto end = std::chrono::high_resolution_clock::now();
+                run.samples.frames++;
+                run.samples.latencyMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                run.samples.successes += run.found;
+            }
+            if (!runs[0].found || !runs[1].found)
+                continue;
+
+            both++;
+            for (auto &run : runs)
+                run.bothMs.push_back(run.samples.latencyMs.back());
+            double total = 0.0, worst = 0.0;
+            for (size_t k = 0; k < runs[0].corners.size(); ++k)
+            {
+                const double d = cv::norm(runs[0].corners[k] - runs[1].corners[k]);
+                total += d;
+                worst = std::max(worst, d);
+            }
+            if (worst > kAgreePx)
+                continue;
+            agreeing++;
+            meanDistance.push_back(total / runs[0].corners.size());
+            maxDistance = std::max(maxDistance, worst);
+        }
+    }
+
+    std::cout << frameCount << " frames, board found by both detectors in " << both << std::endl;
+    std::cout << std::left << std::setw(16) << "detector"
+              << std::right << std::setw(10) << "mean ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+              << std::setw(10) << "detected" << std::setw(14) << "both mean ms" << std::setw(14) << "both p95 ms" << std::endl;
+    for (const auto &run : runs)
+    {
+        const SolverSamples &r = run.samples;
+        std::cout << std::left << std::setw(16) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << mean(r.latencyMs)
+                  << std::setw(10) << percentile(r.latencyMs, 0.5)
+                  << std::setw(10) << percentile(r.latencyMs, 0.95)
+                  << std::setw(10) << (r.frames ? static_cast<double>(r.successes) / r.frames : 0.0)
+                  << std::setw(14) << mean(run.bothMs)
+                  << std::setw(14) << percentile(run.bothMs, 0.95) << std::endl;
+    }
+    std::cout << std::endl
+              << "Same corner order on " << agreeing << " of " << both << " frames; mean corner distance "
+              << mean(meanDistance) << " px, max " << maxDistance << " px" << std::endl;
+    return 0;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: ar_bench <benchmark> [options] <video|image-dir>...\n"
+              << "Benchmarks:\n"
+              << "  ransac                solvePnPRansac vs. the parallel robust estimator (NFT)\n"
+              << "  planar                Homography + IPPE and warm-started PnP vs. the generic solvers, latency and jitter\n"
+              << "  features              Single-pass ORB vs. the tile-parallel grid extractor (NFT), time and match spread\n"
+              << "  corners               cv::findChessboardCorners vs. the ChESS detector, time, detection rate and agreement\n"
+              << "Options:\n"
+              << "  --calibration PATH    calibration.json (default: data/calibration/8x6/calibration.json)\n"
+              << "  --reference PATH      NFT reference image (default: data/reference/reference.png)\n"
+              << "  --frames N            Stop after N frames\n"
+              << "  --nft                 planar: NFT matches instead of chessboard corners\n"
+              << "  --pattern WxH         planar, corners: chessboard inner corners (default: 8x6)\n"
+              << "  --square S            planar: chessboard square size (default: 25)\n";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+    const std::string benchmark = argv[1];
+
+    BenchOptions options;
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--calibration")
+            options.calibrationPath = value();
+        else if (arg == "--reference")
+            options.referencePath = value();
+        else if (arg == "--frames")
+            options.maxFrames = std::stoi(value());
+        else if (arg == "--nft")
+            options.useNft = true;
+        else if (arg == "--pattern")
+        {
+            if (!parsePatternSize(value(), options.patternSize))
+            {
+                std::cerr << "Invalid pattern size, expected WxH" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--square")
+            options.squareSize = std::stof(value());
+        else
+            options.inputs.push_back(arg);
+    }
+
+    if (options.inputs.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (benchmark == "ransac")
+        return benchRansac(options);
+    if (benchmark == "planar")
+        return benchPlanar(options);
+    if (benchmark == "features")
+        return benchFeatures(options);
+    if (benchmark == "corners")
+        return benchCorners(options);
+
+    printUsage();
+    return 1;
+}
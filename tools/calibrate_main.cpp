@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "batch_processor.hpp"
+#include "calibration_engine.hpp"
+#include "view_selector.hpp"
+
+// Offline calibration from a directory of chessboard images
+static void printUsage()
+{
+    std::cout << "Usage: ar_calibrate [options] <image-dir>\n"
+              << "  --pattern WxH         Chessboard inner corners (default: 8x6)\n"
+              << "  --square S            Chessboard square size (default: 25)\n"
+              << "  --output DIR          Where calibration.json / views.json go (default: parent of <image-dir>)\n"
+              << "  --threads N           Detection threads (default: all cores)\n"
+              << "  --no-cache            Ignore and do not write cached corners\n"
+              << "  --step N              Add views N at a time, re-solving after each step\n"
+              << "  --prune PX            Drop views with a reprojection error above PX and re-solve\n"
+              << "  --select N            Calibrate from the N most informative views only\n";
+}
+
+int main(int argc, char **argv)
+{
+    CalibrationEngineOptions options;
+    std::filesystem::path imageDir, outputDir;
+    unsigned threads = 0;
+    int step = 0;
+    double pruneError = 0.0;
+    int select = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--pattern")
+        {
+            if (!parsePatternSize(value(), options.patternSize))
+            {
+                std::cerr << "Invalid pattern size, expected WxH" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--square")
+            options.squareSize = std::stof(value());
+        else if (arg == "--output")
+            outputDir = value();
+        else if (arg == "--threads")
+            threads = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--no-cache")
+            options.useCache = false;
+        else if (arg == "--step")
+            step = std::stoi(value());
+        else if (arg == "--prune")
+            pruneError = std::stod(value());
+        else if (arg == "--select")
+            select = std::stoi(value());
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+            imageDir = arg;
+    }
+
+    if (imageDir.empty() || !std::filesystem::is_directory(imageDir))
+    {
+        printUsage();
+        return 1;
+    }
+    if (outputDir.empty())
+        outputDir = std::filesystem::absolute(imageDir).parent_path();
+
+    // Parallelism comes from the image-level pool; nested OpenCV threads would only oversubscribe
+    cv::setNumThreads(1);
+    ThreadPool pool(threads);
+    CalibrationEngine engine(options, &pool);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<CalibrationView> views = engine.detectDirectory(imageDir);
+    const double detectSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << views.size() << " view(s) with a board, detected in " << detectSeconds << " s on " << pool.size() << " thread(s)" << std::endl;
+    cv::setNumThreads(-1); // The solver itself benefits from OpenCV's threads
+
+    // Pick the most informative views: a first pass scores poses with guessed intrinsics, a second
+    // pass repeats the selection with the intrinsics solved from the first
+    if (select > 0 && static_cast<int>(views.size()) > select)
+    {
+        ViewSelectorOptions selectorOptions;
+        selectorOptions.maxViews = select;
+        selectorOptions.minScore = 0.0; // Offline the pool is simply the best N
+        cv::Mat K, dist;
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            ViewSelector selector(selectorOptions, engine.imageSize, options.patternSize, options.squareSize);
+            for (const auto &view : views)
+                selector.offer(view, cv::Mat(), K, dist);
+            std::vector<CalibrationView> selected;
+            for (const auto &kept : selector.views())
+                selected.push_back(kept.view);
+            engine.setViews(std::move(selected));
+            if (pass == 0 && engine.solve())
+            {
+                K = engine.cameraMatrix.clone();
+                dist = engine.distCoeffs.clone();
+            }
+        }
+        std::cout << "Selected " << engine.views().size() << " of " << views.size() << " view(s)" << std::endl;
+        views = engine.views();
+        engine.setViews({});
+    }
+
+    // Add views incrementally; every solve after the first starts from the previous intrinsics
+    const size_t chunk = step > 0 ? static_cast<size_t>(step) : views.size();
+    for (size_t begin = 0; begin < views.size(); begin += chunk)
+    {
+        const size_t end = std::min(views.size(), begin + chunk);
+        for (size_t i = begin; i < end; ++i)
+            engine.addView(std::move(views[i]));
+        if (engine.solve())
+            std::cout << std::setw(4) << engine.enabledViews() << " views: rms " << std::fixed << std::setprecision(4) << engine.rms
+                      << " px, solve " << std::setprecision(1) << engine.lastSolveMs << " ms" << std::endl;
+    }
+    if (!engine.solved())
+    {
+        std::cerr << "Calibration needs at least 3 views with a detected board" << std::endl;
+        return 1;
+    }
+
+    // Per-view errors
+    for (const auto &view : engine.views())
+        std::cout << "  " << std::left << std::setw(24) << view.image.filename().string() << std::right
+                  << std::setprecision(4) << view.error << " px" << std::endl;
+
+    if (pruneError > 0.0)
+    {
+        const int pruned = engine.prune(pruneError);
+        std::cout << "Pruned " << pruned << " view(s) above " << pruneError << " px: rms " << engine.rms
+                  << " px, solve " << std::setprecision(1) << engine.lastSolveMs << " ms" << std::endl;
+    }
+
+    if (!engine.save(outputDir))
+    {
+        std::cerr << "Unable to write " << outputDir << std::endl;
+        return 1;
+    }
+    std::cout << "Saved " << (outputDir / "calibration.json") << std::endl;
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "session_compare.hpp"
+
+// Compares session statistics of one or more candidate builds against a baseline.
+// Exit code: 0 = no regression, 1 = regression beyond a threshold, 2 = usage or read error
+static void printUsage()
+{
+    std::cout << "Usage: ar_compare [options] <baseline.json> <candidate.json>...\n"
+              << "  --resamples N             Bootstrap resamples (default: 2000)\n"
+              << "  --block N                 Moving-block length in frames (default: 30)\n"
+              << "  --confidence C            Confidence level of the intervals (default: 0.95)\n"
+              << "  --seed N                  Bootstrap seed (default: 1)\n"
+              << "  --max-slowdown R          Allowed frame / track time increase, relative (default: 0.05)\n"
+              << "  --max-success-drop D      Allowed success rate drop, absolute (default: 0.02)\n"
+              << "  --max-streak-increase N   Allowed growth of the longest failure streak in frames (default: 5)\n"
+              << "  --max-jitter-increase R   Allowed jitter increase, relative (default: 0.10)\n"
+              << "  --json PATH               Also write the comparisons as JSON\n";
+}
+
+static void printComparison(const SessionComparison &comparison)
+{
+    std::cout << comparison.candidate << " vs " << comparison.baseline << "\n"
+              << std::left << std::setw(24) << "metric" << std::right << std::setw(12) << "baseline" << std::setw(12) << "candidate"
+              << std::setw(12) << "change" << std::setw(24) << "interval" << std::setw(10) << "limit" << "\n";
+    for (const auto &m : comparison.metrics)
+    {
+        // Relative changes in percent, absolute ones as they are
+        const double scale = m.relative ? 100.0 : 1.0;
+        const char *unit = m.relative ? "%" : "";
+        std::ostringstream interval, change, limit;
+        interval << std::fixed << std::setprecision(2) << "[" << m.change.low * scale << ", " << m.change.high * scale << "]" << unit;
+        change << std::fixed << std::showpos << std::setprecision(2) << m.change.estimate * scale << unit;
+        limit << std::fixed << std::showpos << std::setprecision(2) << m.threshold * scale << unit;
+        std::cout << std::left << std::setw(24) << m.name << std::right << std::fixed << std::setprecision(4)
+                  << std::setw(12) << m.baseline << std::setw(12) << m.candidate << std::setw(12) << change.str()
+                  << std::setw(24) << interval.str() << std::setw(10) << limit.str()
+                  << (m.regression ? "  REGRESSION" : "") << "\n";
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CompareOptions options;
+    std::vector<std::string> inputs;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--resamples")
+            options.resamples = std::stoi(value());
+        else if (arg == "--block")
+            options.blockLength = std::stoi(value());
+        else if (arg == "--confidence")
+            options.confidence = std::stod(value());
+        else if (arg == "--seed")
+            options.seed = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--max-slowdown")
+            options.maxSlowdown = std::stod(value());
+        else if (arg == "--max-success-drop")
+            options.maxSuccessDrop = std::stod(value());
+        else if (arg == "--max-streak-increase")
+            options.maxStreakIncrease = std::stoi(value());
+        else if (arg == "--max-jitter-increase")
+            options.maxJitterIncrease = std::stod(value());
+        else if (arg == "--json")
+            jsonPath = value();
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.size() < 2)
+    {
+        printUsage();
+        return 2;
+    }
+    if (options.confidence <= 0.0 || options.confidence >= 1.0)
+    {
+        std::cerr << "Confidence must be between 0 and 1" << std::endl;
+        return 2;
+    }
+
+    SessionSamples baseline;
+    if (!loadSessionSamples(inputs[0], baseline))
+        return 2;
+
+    bool regression = false;
+    nlohmann::json report = nlohmann::json::array();
+    for (size_t c = 1; c < inputs.size(); ++c)
+    {
+        SessionSamples candidate;
+        if (!loadSessionSamples(inputs[c], candidate))
+            return 2;
+        const SessionComparison comparison = compareSessions(baseline, candidate, options);
+        printComparison(comparison);
+        report.push_back(comparison.toJson());
+        regression = regression || comparison.regression();
+    }
+
+    if (!jsonPath.empty())
+    {
+        std::ofstream out(jsonPath);
+        if (!out.is_open())
+        {
+            std::cerr << "Unable to open " << jsonPath << std::endl;
+            return 2;
+        }
+        out << report.dump(4);
+    }
+    if (regression)
+        std::cout << "Regression beyond the configured thresholds" << std::endl;
+    return regression ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frame_reader.hpp"
+#include "pose_client.hpp"
+
+// Load generator for the pose service: throughput and tail latency at several client counts
+// Every client is a thread with its own connection and frame slot, sending recorded frames back to back.
+
+// Samples of one client
+struct ClientSamples
+{
+    std::vector<double> latencyMs; // Request sent to reply received
+    std::vector<double> trackMs;   // Server time in estimatePose
+    std::vector<double> queueMs;   // Server queueing before tracking
+    std::vector<double> batchSize; // Batch the request was served in
+    int successes = 0;
+    int failures = 0; // Connection errors
+};
+
+// Value at quantile q of an unsorted sample
+static double percentile(std::vector<double> v, double q)
+{
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t index = static_cast<size_t>(q * (v.size() - 1) + 0.5);
+    return v[std::min(index, v.size() - 1)];
+}
+
+static double mean(const std::vector<double> &v)
+{
+    return v.empty() ? 0.0 : std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: ar_loadgen [options] <video|image-dir>...\n"
+              << "  --socket PATH         Pose server socket (default: /tmp/ar_pose.sock)\n"
+              << "  --clients LIST        Client counts to run, comma separated (default: 1,2,4,8)\n"
+              << "  --requests N          Requests per client and run (default: 200)\n"
+              << "  --frames N            Frames loaded from the inputs (default: 100)\n"
+              << "  --color               Send BGR frames (default: grayscale)\n";
+}
+
+int main(int argc, char **argv)
+{
+    std::string socketPath = "/tmp/ar_pose.sock";
+    std::vector<int> clientCounts{1, 2, 4, 8};
+    int requests = 200;
+    int maxFrames = 100;
+    bool color = false;
+    std::vector<std::filesystem::path> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--socket")
+            socketPath = value();
+        else if (arg == "--clients")
+        {
+            clientCounts.clear();
+            std::stringstream list(value());
+            std::string item;
+            while (std::getline(list, item, ','))
+                clientCounts.push_back(std::max(1, std::stoi(item)));
+        }
+        else if (arg == "--requests")
+            requests = std::stoi(value());
+        else if (arg == "--frames")
+            maxFrames = std::stoi(value());
+        else if (arg == "--color")
+            color = true;
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.empty() || clientCounts.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Frames are decoded up front so the clients measure the service, not the decoder
+    std::vector<cv::Mat> frames;
+    for (const auto &input : inputs)
+    {
+        FrameReader reader(input);
+        cv::Mat frame;
+        while (static_cast<int>(frames.size()) < maxFrames && reader.read(frame))
+        {
+            cv::Mat sent;
+            if (color)
+                sent = frame.clone();
+            else
+                cv::cvtColor(frame, sent, cv::COLOR_BGR2GRAY);
+            frames.push_back(sent);
+        }
+    }
+    if (frames.empty())
+    {
+        std::cerr << "No frames in the inputs" << std::endl;
+        return 1;
+    }
+    size_t slotBytes = 0;
+    for (const auto &f : frames)
+        slotBytes = std::max(slotBytes, f.total() * f.elemSize());
+
+    std::cout << frames.size() << " frames, " << requests << " requests per client" << std::endl;
+    std::cout << std::setw(8) << "clients" << std::setw(12) << "req/s" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+              << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(10) << "track ms" << std::setw(10) << "queue ms"
+              << std::setw(8) << "batch" << std::setw(10) << "success" << std::endl;
+
+    for (int clients : clientCounts)
+    {
+        std::vector<ClientSamples> samples(clients);
+        std::vector<std::thread> threads;
+        std::atomic<int> connected{0};
+        std::atomic<bool> go{false};
+        for (int c = 0; c < clients; ++c)
+        {
+            threads.emplace_back([&, c]
+                                 {
+                                     PoseClient client;
+                                     const bool ok = client.connect(socketPath, slotBytes);
+                                     connected++;
+                                     while (!go.load())
+                                         std::this_thread::yield();
+                                     if (!ok)
+                                     {
+                                         samples[c].failures = requests;
+                                         return;
+                                     }
+                                     ClientSamples &s = samples[c];
+                                     for (int r = 0; r < requests; ++r)
+                                     {
+                                         // Clients start at different frames so batches mix content
+                                         const cv::Mat &frame = frames[(c * 7 + r) % frames.size()];
+                                         PoseReply reply;
+                                         auto start = std::chrono::steady_clock::now();
+                                         if (!client.estimate(frame, r / 30.0, reply))
+                                         {
+                                             s.failures += requests - r;
+                                             return;
+                                         }
+                                         s.latencyMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                                         s.trackMs.push_back(reply.trackMs);
+                                         s.queueMs.push_back(reply.queueMs);
+                                         s.batchSize.push_back(reply.batchSize);
+                                         s.successes += reply.success;
+                                     } });
+        }
+        // Start together once every client is connected
+        while (connected.load() < clients)
+            std::this_thread::yield();
+        auto runStart = std::chrono::steady_clock::now();
+        go = true;
+        for (auto &t : threads)
+            t.join();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+        ClientSamples all;
+        for (const auto &s : samples)
+        {
+            all.latencyMs.insert(all.latencyMs.end(), s.latencyMs.begin(), s.latencyMs.end());
+            all.trackMs.insert(all.trackMs.end(), s.trackMs.begin(), s.trackMs.end());
+            all.queueMs.insert(all.queueMs.end(), s.queueMs.begin(), s.queueMs.end());
+            all.batchSize.insert(all.batchSize.end(), s.batchSize.begin(), s.batchSize.end());
+            all.successes += s.successes;
+            all.failures += s.failures;
+        }
+        const double answered = static_cast<double>(all.latencyMs.size());
+        std::cout << std::setw(8) << clients << std::fixed << std::setprecision(2)
+                  << std::setw(12) << (seconds > 0 ? answered / seconds : 0.0)
+                  << std::setw(10) << percentile(all.latencyMs, 0.5)
+                  << std::setw(10) << percentile(all.latencyMs, 0.95)
+                  << std::setw(10) << percentile(all.latencyMs, 0.99)
+                  << std::setw(10) << percentile(all.latencyMs, 1.0)
+                  << std::setw(10) << mean(all.trackMs)
+                  << std::setw(10) << mean(all.queueMs)
+                  << std::setw(8) << mean(all.batchSize)
+                  << std::setw(10) << (answered > 0 ? all.successes / answered : 0.0) << std::endl;
+        if (all.failures > 0)
+            std::cout << "  " << all.failures << " requests failed (connection errors)" << std::endl;
+    }
+    return 0;
+}
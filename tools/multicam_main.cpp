@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "batch_processor.hpp"
+#include "multi_camera.hpp"
+
+// Concurrent tracking of several cameras or recordings, each with its own calibration
+static std::atomic<bool> stopRequested{false};
+
+static void onSignal(int)
+{
+    stopRequested = true;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: ar_multicam [options] <cameras.json | video | image-dir>...\n"
+              << "  --output DIR          Per-camera sessions and report.json (default: data/statistics/MultiCamera)\n"
+              << "  --frames N            Frames per camera (default: until the source ends)\n"
+              << "  --no-pin              Leave camera threads to the scheduler instead of one core each\n"
+              << "  --repeat N            Run every recording N times side by side\n"
+              << "  --scaling             Run with 1, 2, ... cameras and print per-camera throughput for each\n"
+              << "Recordings given directly use these settings (cameras.json sets them per camera):\n"
+              << "  --nft                 Use the NFT tracker (default: chessboard)\n"
+              << "  --pattern WxH         Chessboard inner corners (default: 8x6)\n"
+              << "  --square S            Chessboard square size (default: 25)\n"
+              << "  --reference PATH      NFT reference image (default: data/reference/reference.png)\n"
+              << "  --calibration PATH    calibration.json (default: data/calibration/<name>, then data/calibration/<WxH>)\n";
+}
+
+int main(int argc, char **argv)
+{
+    MultiCameraOptions options;
+    CameraConfig defaults;
+    std::vector<std::string> inputs;
+    int repeat = 1;
+    bool scaling = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--output")
+            options.outputDir = value();
+        else if (arg == "--frames")
+            options.maxFrames = std::stoi(value());
+        else if (arg == "--no-pin")
+            options.pinThreads = false;
+        else if (arg == "--repeat")
+            repeat = std::max(1, std::stoi(value()));
+        else if (arg == "--scaling")
+            scaling = true;
+        else if (arg == "--nft")
+            defaults.useNft = true;
+        else if (arg == "--pattern")
+        {
+            if (!parsePatternSize(value(), defaults.patternSize))
+            {
+                std::cerr << "Invalid pattern size, expected WxH" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--square")
+            defaults.squareSize = std::stof(value());
+        else if (arg == "--reference")
+            defaults.referencePath = value();
+        else if (arg == "--calibration")
+            defaults.calibrationPath = value();
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<CameraConfig> cameras;
+    for (const auto &input : inputs)
+    {
+        const std::filesystem::path path(input);
+        if (path.extension() == ".json")
+        {
+            if (!loadCameraConfigs(path, cameras))
+                return 1;
+            continue;
+        }
+        for (int r = 0; r < repeat; ++r)
+        {
+            CameraConfig camera = defaults;
+            camera.input = path;
+            const std::filesystem::path name = path.has_filename() ? path : path.parent_path();
+            camera.name = name.stem().string() + "_" + std::to_string(cameras.size());
+            cameras.push_back(camera);
+        }
+    }
+
+    // Cameras run on their own threads; OpenCV's internal threads would only compete with them
+    cv::setNumThreads(1);
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    MultiCameraRunner runner(options);
+    if (scaling)
+    {
+        // Per-camera throughput should stay flat up to the core count
+        std::cout << std::setw(8) << "cameras" << std::setw(14) << "total fps" << std::setw(14) << "mean fps"
+                  << std::setw(14) << "min fps" << std::setw(14) << "max fps" << std::endl;
+        for (size_t count = 1; count <= cameras.size() && !stopRequested; ++count)
+        {
+            const std::vector<CameraConfig> subset(cameras.begin(), cameras.begin() + static_cast<std::ptrdiff_t>(count));
+            const nlohmann::json summary = MultiCameraRunner::report(runner.run(subset, stopRequested))["summary"];
+            std::cout << std::setw(8) << count << std::fixed << std::setprecision(1)
+                      << std::setw(14) << summary["aggregate_fps"].get<double>()
+                      << std::setw(14) << summary["mean_camera_fps"].get<double>()
+                      << std::setw(14) << summary["min_camera_fps"].get<double>()
+                      << std::setw(14) << summary["max_camera_fps"].get<double>() << std::endl;
+        }
+        return 0;
+    }
+
+    const std::vector<CameraResult> results = runner.run(cameras, stopRequested);
+    for (const auto &r : results)
+    {
+        if (!r.opened)
+            continue;
+        std::cout << r.name << ": " << r.frames << " frames in " << r.wallSeconds << " s (" << r.framesPerSecond << " fps"
+                  << (r.core >= 0 ? ", core " + std::to_string(r.core) : std::string()) << ") -> " << r.output << std::endl;
+    }
+
+    const std::filesystem::path reportPath = options.outputDir / "report.json";
+    std::ofstream out(reportPath);
+    if (!out.is_open())
+    {
+        std::cerr << "Unable to open " << reportPath << std::endl;
+        return 1;
+    }
+    out << MultiCameraRunner::report(results).dump(4);
+    std::cout << "Aggregated report saved to " << reportPath << std::endl;
+    return 0;
+}
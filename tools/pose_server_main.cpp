@@ -0,0 +1,113 @@
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "batch_processor.hpp"
+#include "pose_server.hpp"
+
+// Pose service daemon: warmed-up trackers shared by the processes of this machine
+static std::atomic<bool> stopRequested{false};
+
+static void onSignal(int)
+{
+    stopRequested = true;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: ar_pose_server [options]\n"
+              << "  --socket PATH         Unix-domain socket (default: /tmp/ar_pose.sock)\n"
+              << "  --nft                 Use the NFT tracker (default: chessboard)\n"
+              << "  --pattern WxH         Chessboard inner corners (default: 8x6)\n"
+              << "  --square S            Chessboard square size (default: 25)\n"
+              << "  --reference PATH      NFT reference image (default: data/reference/reference.png)\n"
+              << "  --multi-view          NFT: match against zoomed-out and tilted views of the reference\n"
+              << "  --calibration PATH    calibration.json (default: data/calibration/<WxH>/calibration.json)\n"
+              << "  --threads N           Worker threads (default: all cores)\n"
+              << "  --solver NAME         Pose solver: opencv (default), robust or planar\n"
+              << "  --max-batch N         Requests per batch (default: one per tracker)\n"
+              << "  --batch-window US     Microseconds a batch waits for more requests (default: 200)\n";
+}
+
+int main(int argc, char **argv)
+{
+    PoseServerOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--socket")
+            options.socketPath = value();
+        else if (arg == "--nft")
+            options.useNft = true;
+        else if (arg == "--pattern")
+        {
+            if (!parsePatternSize(value(), options.patternSize))
+            {
+                std::cerr << "Invalid pattern size, expected WxH" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--square")
+            options.squareSize = std::stof(value());
+        else if (arg == "--reference")
+            options.referencePath = value();
+        else if (arg == "--multi-view")
+            options.multiView = true;
+        else if (arg == "--calibration")
+            options.calibrationPath = value();
+        else if (arg == "--threads")
+            options.threads = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--solver")
+        {
+            // Requests are independent, so the warm-started solver has nothing to start from
+            const std::string name = value();
+            if (name == "opencv")
+                options.solver = PoseSolver::OpenCV;
+            else if (name == "robust")
+                options.solver = PoseSolver::Robust;
+            else if (name == "planar")
+                options.solver = PoseSolver::Planar;
+            else
+            {
+                std::cerr << "Unknown solver " << name << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--max-batch")
+            options.maxBatch = std::stoi(value());
+        else if (arg == "--batch-window")
+            options.batchWindowUs = std::stoi(value());
+        else
+        {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    // Parallelism comes from the request-level pool; nested OpenCV threads would only oversubscribe
+    cv::setNumThreads(1);
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    PoseServer server(options);
+    if (!server.start())
+        return 1;
+    std::cout << "Serving poses on " << options.socketPath << std::endl;
+    server.run(stopRequested);
+
+    const PoseServerStats stats = server.stats();
+    std::cout << "Answered " << stats.requests << " requests in " << stats.batches << " batches" << std::endl;
+    return 0;
+}
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batch_processor.hpp"
+#include "calibration_store.hpp"
+#include "frame_preprocessor.hpp"
+#include "frame_reader.hpp"
+#include "frame_ring.hpp"
+#include "tracker_factory.hpp"
+
+// Shared-memory frame ring: one process owns the camera (or plays a recording), others attach
+//   produce  publishes frames into the ring
+//   track    headless tracker consuming the newest frame of the ring
+
+static std::atomic<bool> stopRequested{false};
+
+static void onSignal(int)
+{
+    stopRequested = true;
+}
+
+// Settings of both subcommands
+struct RingOptions
+{
+    std::string ringName = "/ar_frames";
+    int slots = 8;
+    // produce
+    int camera = 0;
+    CaptureFormat format = CaptureFormat::BGR;
+    std::filesystem::path video;   // Video file or image directory instead of the camera
+    std::filesystem::path rawPath; // Raw YUYV / NV12 file instead of the camera
+    cv::Size rawSize;
+    double fps = 0.0; // Playback rate of files (0: the file's own, 30 for images and raw files)
+    bool loop = false;
+    // track
+    bool useNft = false;
+    cv::Size patternSize{8, 6};
+    float squareSize = 25.0f;
+    std::string referencePath = "data/reference/reference.png";
+    std::filesystem::path calibrationPath;
+    int maxFrames = 0; // 0: until the producer stops
+};
+
+// Value at quantile q of an unsorted sample
+static double percentile(std::vector<double> v, double q)
+{
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t index = static_cast<size_t>(q * (v.size() - 1) + 0.5);
+    return v[std::min(index, v.size() - 1)];
+}
+
+static double mean(const std::vector<double> &v)
+{
+    return v.empty() ? 0.0 : std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+}
+
+// Publish frames from the camera, a raw file or a recording until stopped or the input ends
+static int produce(const RingOptions &options)
+{
+    FrameRingWriter ring;
+    std::uint64_t dropped = 0; // Frames that did not match the ring (size changes in a recording)
+    auto publish = [&](const CapturedFrame &frame)
+    {
+        if (!ring.isOpen())
+        {
+            // Geometry comes from the first frame
+            if (!ring.create(options.ringName, frame.size, frame.format, options.slots))
+                return false;
+            std::cout << "Publishing " << frame.size.width << "x" << frame.size.height << " frames on " << options.ringName << std::endl;
+        }
+        if (!ring.publish(frame, frameRingClock()))
+            dropped++;
+        return true;
+    };
+
+    if (!options.video.empty())
+    {
+        // Recordings are paced to their frame rate so consumers see live timing
+        CapturedFrame frame;
+        do
+        {
+            FrameReader reader(options.video);
+            if (!reader.isOpened())
+            {
+                std::cerr << "Unable to open " << options.video << std::endl;
+                return 1;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            for (int index = 0; !stopRequested && reader.read(frame.bgr); ++index)
+            {
+                const double at = options.fps > 0 ? index / options.fps : reader.timestamp(index);
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(at)));
+                frame.format = CaptureFormat::BGR;
+                frame.size = frame.bgr.size();
+                if (!publish(frame))
+                    return 1;
+            }
+        } while (options.loop && !stopRequested);
+    }
+    else
+    {
+        FrameSource source;
+        const bool opened = options.rawPath.empty() ? source.open(options.camera, options.format)
+                                                    : source.openRaw(options.rawPath, options.rawSize, options.format);
+        if (!opened)
+        {
+            std::cerr << "Unable to open the frame source" << std::endl;
+            return 1;
+        }
+        // Cameras pace themselves; raw files are played at --fps
+        const double rawFps = options.fps > 0 ? options.fps : 30.0;
+        const auto start = std::chrono::steady_clock::now();
+        CapturedFrame frame;
+        for (int index = 0; !stopRequested; ++index)
+        {
+            if (!source.read(frame))
+            {
+                if (!options.rawPath.empty() && options.loop && index > 0)
+                {
+                    source.openRaw(options.rawPath, options.rawSize, options.format);
+                    continue;
+                }
+                break;
+            }
+            if (!options.rawPath.empty())
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(index / rawFps)));
+            if (!publish(frame))
+                return 1;
+        }
+    }
+
+    std::cout << "Published " << ring.published() << " frames";
+    if (dropped > 0)
+        std::cout << " (" << dropped << " frames of another size or format dropped)";
+    std::cout << std::endl;
+    ring.close();
+    return 0;
+}
+
+// Track the newest ring frame until the producer stops
+static int track(const RingOptions &options)
+{
+    FrameRingReader ring;
+    if (!ring.open(options.ringName))
+    {
+        std::cerr << "No frame ring " << options.ringName << " (start ar_ring produce first)" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path calibrationJson = options.calibrationPath;
+    if (calibrationJson.empty())
+    {
+        std::string patternStr = std::to_string(options.patternSize.width) + "x" + std::to_string(options.patternSize.height);
+        calibrationJson = std::filesystem::path("data/calibration") / patternStr / "calibration.json";
+    }
+    CalibrationStore calibration;
+    if (!calibration.load(calibrationJson))
+    {
+        std::cerr << "Unable to read " << calibrationJson << std::endl;
+        return 1;
+    }
+    const ResolutionIntrinsics &intrinsics = calibration.at(ring.size());
+
+    auto tracker = createTracker(options.useNft, options.patternSize, options.squareSize, options.referencePath);
+    tracker->showDebug = false;
+    // Luma straight from the slot, tracked with the real distortion like YUV capture in augmentLoop
+    PreprocessOptions preprocessOptions;
+    preprocessOptions.uploadBuffer = false;
+    FramePreprocessor preprocessor(preprocessOptions);
+    PreparedFrame prepared;
+
+    std::vector<double> trackMs, ageMs;
+    std::uint64_t taken = 0, skipped = 0, torn = 0, tracked = 0;
+    FrameRingFrame frame;
+    while (!stopRequested && (options.maxFrames <= 0 || static_cast<int>(taken) < options.maxFrames) && ring.next(frame))
+    {
+        taken++;
+        skipped += frame.skipped;
+        ageMs.push_back((frameRingClock() - frame.timestamp) * 1000.0);
+
+        const auto start = std::chrono::steady_clock::now();
+        if (frame.frame.format == CaptureFormat::BGR)
+            preprocessor.process(frame.frame.bgr, prepared);
+        else
+            preprocessor.processGray(frame.frame.luma(), prepared);
+        cv::Mat rvec, tvec;
+        const bool success = tracker->estimatePose(prepared, intrinsics.cameraMatrix, calibration.distCoeffs, rvec, tvec);
+        trackMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        if (!ring.isCurrent(frame.sequence))
+        {
+            torn++; // Overwritten while tracked, the pose is not trusted
+            continue;
+        }
+        tracked += success;
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Frames taken:     " << taken << "\n"
+              << "Frames skipped:   " << skipped << " (newer frame already published)\n"
+              << "Frames torn:      " << torn << " (overwritten while tracked)\n"
+              << "Poses:            " << tracked << "\n"
+              << "Track ms:         mean " << mean(trackMs) << ", p95 " << percentile(trackMs, 0.95) << "\n"
+              << "Frame age ms:     mean " << mean(ageMs) << ", p95 " << percentile(ageMs, 0.95) << std::endl;
+    return 0;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: ar_ring <produce|track> [options]\n"
+              << "  --ring NAME           Shared-memory ring name (default: /ar_frames)\n"
+              << "produce:\n"
+              << "  --slots N             Frames kept in the ring (default: 8)\n"
+              << "  --camera I            Camera index (default: 0)\n"
+              << "  --format F            Camera / raw format: bgr (default), yuyv or nv12\n"
+              << "  --video PATH          Publish a video file or image directory instead of the camera\n"
+              << "  --raw PATH            Publish a raw YUYV / NV12 file (with --raw-size and --format)\n"
+              << "  --raw-size WxH        Frame size of the raw file\n"
+              << "  --fps F               Playback rate of files (default: the file's own, 30 for images and raw files)\n"
+              << "  --loop                Restart files at their end\n"
+              << "track:\n"
+              << "  --nft                 Use the NFT tracker (default: chessboard)\n"
+              << "  --pattern WxH         Chessboard inner corners (default: 8x6)\n"
+              << "  --square S            Chessboard square size (default: 25)\n"
+              << "  --reference PATH      NFT reference image (default: data/reference/reference.png)\n"
+              << "  --calibration PATH    calibration.json (default: data/calibration/<WxH>/calibration.json)\n"
+              << "  --frames N            Stop after N frames (default: until the producer stops)\n";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+    const std::string command = argv[1];
+
+    RingOptions options;
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--ring")
+            options.ringName = value();
+        else if (arg == "--slots")
+            options.slots = std::stoi(value());
+        else if (arg == "--camera")
+            options.camera = std::stoi(value());
+        else if (arg == "--format")
+        {
+            if (!parseCaptureFormat(value(), options.format))
+            {
+                std::cerr << "Unknown format, expected bgr, yuyv or nv12" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--video")
+            options.video = value();
+        else if (arg == "--raw")
+            options.rawPath = value();
+        else if (arg == "--raw-size" || arg == "--pattern")
+        {
+            cv::Size &size = arg == "--raw-size" ? options.rawSize : options.patternSize;
+            if (!parsePatternSize(value(), size))
+            {
+                std::cerr << "Invalid size for " << arg << ", expected WxH" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--fps")
+            options.fps = std::stod(value());
+        else if (arg == "--loop")
+            options.loop = true;
+        else if (arg == "--nft")
+            options.useNft = true;
+        else if (arg == "--square")
+            options.squareSize = std::stof(value());
+        else if (arg == "--reference")
+            options.referencePath = value();
+        else if (arg == "--calibration")
+            options.calibrationPath = value();
+        else if (arg == "--frames")
+            options.maxFrames = std::stoi(value());
+        else
+        {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (command == "produce")
+        return produce(options);
+    if (command == "track")
+        return track(options);
+
+    printUsage();
+    return 1;
+}
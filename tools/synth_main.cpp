@@ -0,0 +1,206 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "batch_processor.hpp"
+#include "synthetic_sequence.hpp"
+
+// Synthetic sequences with known poses: accuracy of every tracker change can be checked offline
+//   generate  render frames and ground truth
+//   evaluate  track them and report absolute pose error next to latency
+
+static void printUsage()
+{
+    std::cout << "Usage: ar_synth <generate|evaluate> [options] <sequence-dir>\n"
+              << "generate:\n"
+              << "  --nft                 Warp the NFT reference (default: chessboard)\n"
+              << "  --pattern WxH         Chessboard inner corners (default: 8x6)\n"
+              << "  --square S            Chessboard square size (default: 25)\n"
+              << "  --reference PATH      NFT reference image (default: data/reference/reference.png)\n"
+              << "  --calibration PATH    calibration.json of the rendered camera (default: data/calibration/<WxH>/calibration.json)\n"
+              << "  --size WxH            Frame size (default: the calibrated resolution)\n"
+              << "  --frames N            Sequence length (default: 300)\n"
+              << "  --trajectory NAME     orbit (default), approach or shake\n"
+              << "  --coverage F          Target width / image width at the nominal distance (default: 0.5)\n"
+              << "  --blur SIGMA          Gaussian blur in pixels (default: 0)\n"
+              << "  --motion-blur F       Exposure as a fraction of the frame interval (default: 0)\n"
+              << "  --noise SIGMA         Sensor noise in grey levels (default: 0)\n"
+              << "  --lighting F          Gain flicker and brightness gradient amplitude, 0..1 (default: 0)\n"
+              << "  --occlusion F         Width of a sweeping occluder relative to the target (default: 0)\n"
+              << "  --no-distortion       Render an ideal pinhole camera\n"
+              << "  --seed N              Noise seed (default: 1)\n"
+              << "evaluate:\n"
+              << "  --solver LIST         Solvers to compare, comma separated: opencv (default), robust, planar\n"
+              << "  --threads N           Worker threads (default: all cores)\n"
+              << "  --output PATH         Per-frame errors as JSON (default: <sequence-dir>/evaluation.json)\n";
+}
+
+static bool parseSolver(const std::string &name, PoseSolver &solver)
+{
+    if (name == "opencv")
+        solver = PoseSolver::OpenCV;
+    else if (name == "robust")
+        solver = PoseSolver::Robust;
+    else if (name == "planar")
+        solver = PoseSolver::Planar;
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+    const std::string command = argv[1];
+
+    SyntheticOptions options;
+    std::vector<std::string> solvers{"opencv"};
+    unsigned threads = 0;
+    std::filesystem::path output;
+    std::filesystem::path dir;
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        // Options that take a value
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--nft")
+            options.useNft = true;
+        else if (arg == "--pattern" || arg == "--size")
+        {
+            cv::Size &size = arg == "--pattern" ? options.patternSize : options.imageSize;
+            if (!parsePatternSize(value(), size))
+            {
+                std::cerr << "Invalid size for " << arg << ", expected WxH" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--square")
+            options.squareSize = std::stof(value());
+        else if (arg == "--reference")
+            options.referencePath = value();
+        else if (arg == "--calibration")
+            options.calibrationPath = value();
+        else if (arg == "--frames")
+            options.frames = std::stoi(value());
+        else if (arg == "--trajectory")
+        {
+            if (!parseTrajectory(value(), options.trajectory))
+            {
+                std::cerr << "Unknown trajectory, expected orbit, approach or shake" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--coverage")
+            options.coverage = std::stod(value());
+        else if (arg == "--blur")
+            options.blurSigma = std::stod(value());
+        else if (arg == "--motion-blur")
+            options.motionBlur = std::stod(value());
+        else if (arg == "--noise")
+            options.noiseSigma = std::stod(value());
+        else if (arg == "--lighting")
+            options.lighting = std::stod(value());
+        else if (arg == "--occlusion")
+            options.occlusion = std::stod(value());
+        else if (arg == "--no-distortion")
+            options.distort = false;
+        else if (arg == "--seed")
+            options.seed = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--solver")
+        {
+            solvers.clear();
+            std::stringstream list(value());
+            std::string item;
+            while (std::getline(list, item, ','))
+                solvers.push_back(item);
+        }
+        else if (arg == "--threads")
+            threads = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--output")
+            output = value();
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+            dir = arg;
+    }
+    if (dir.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (command == "generate")
+    {
+        SyntheticGenerator generator(options);
+        if (!generator.init() || !generator.generate(dir))
+            return 1;
+        std::cout << "Wrote " << options.frames << " frames and ground truth to " << dir << std::endl;
+        return 0;
+    }
+    if (command != "evaluate")
+    {
+        printUsage();
+        return 1;
+    }
+
+    // One row per solver: accuracy against the truth next to the time it took
+    nlohmann::json report;
+    std::cout << std::setw(10) << "solver" << std::setw(10) << "detect" << std::setw(8) << "gross"
+              << std::setw(12) << "rot med" << std::setw(12) << "rot p95" << std::setw(12) << "trans med" << std::setw(12) << "trans p95"
+              << std::setw(12) << "px med" << std::setw(12) << "track ms" << std::setw(12) << "track p95" << std::endl;
+    for (const auto &name : solvers)
+    {
+        PoseSolver solver;
+        if (!parseSolver(name, solver))
+        {
+            std::cerr << "Unknown solver " << name << std::endl;
+            return 1;
+        }
+        const nlohmann::json result = evaluateSynthetic(dir, solver, threads);
+        if (result.is_null())
+            return 1;
+        const nlohmann::json &s = result["summary"];
+        std::cout << std::setw(10) << name << std::fixed << std::setprecision(3)
+                  << std::setw(10) << s["detection_rate"].get<double>()
+                  << std::setw(8) << s["gross_errors"].get<int>()
+                  << std::setw(12) << s["rotation_error_deg"]["median"].get<double>()
+                  << std::setw(12) << s["rotation_error_deg"]["p95"].get<double>()
+                  << std::setw(12) << s["translation_error"]["median"].get<double>()
+                  << std::setw(12) << s["translation_error"]["p95"].get<double>()
+                  << std::setw(12) << s["corner_error_px"]["median"].get<double>()
+                  << std::setw(12) << s["track_ms"]["mean"].get<double>()
+                  << std::setw(12) << s["track_ms"]["p95"].get<double>() << std::endl;
+        report[name] = result;
+    }
+
+    if (output.empty())
+        output = dir / "evaluation.json";
+    std::ofstream out(output);
+    if (!out.is_open())
+    {
+        std::cerr << "Unable to open " << output << std::endl;
+        return 1;
+    }
+    out << report.dump(4);
+    std::cout << "Per-frame errors saved to " << output << std::endl;
+    return 0;
+}
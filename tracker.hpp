@@ -1,14 +1,64 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include "frame_preprocessor.hpp"
+
+class ThreadPool;
+
+// Pose solver used by a tracker after its 2D-3D correspondences are found
+enum class PoseSolver
+{
+    OpenCV, // cv::solvePnP / cv::solvePnPRansac
+    Robust, // Parallel PROSAC hypothesis evaluation (robust_pose.hpp)
+    Planar,  // Homography + IPPE + Gauss-Newton for z = 0 targets (planar_pose.hpp)
+    Temporal // LM seeded with the previous pose, cold OpenCV solve as fallback (temporal_pose.hpp)
+};
+
+// Per-call details of the last pose estimate
+struct PoseDiagnostics
+{
+    int correspondences = 0; // 2D-3D correspondences handed to the solver
+    int inliers = 0;         // Correspondences consistent with the final pose
+    int hypotheses = 0;      // Minimal-sample hypotheses scored (robust solvers)
+    bool reusedPrior = false; // Previous pose was accepted without resampling
+    int iterations = 0;      // Refinement iterations (iterative solvers)
+    bool warmStarted = false; // Pose came from the warm-started solver without a cold fallback
+    double solveMs = 0.0;    // Time spent in the pose solver
+};
+
+// Cost / accuracy settings of the trackers, adjusted at runtime by the QualityGovernor
+// The defaults are the values the trackers always used.
+struct TrackerQuality
+{
+    int orbFeatures = 5000;      // ORB features per frame (NFT)
+    int orbLevels = 8;           // ORB pyramid levels (NFT)
+    float matchRatio = 0.75f;    // Lowe's ratio test threshold (NFT)
+    int ransacIterations = 100;  // RANSAC hypotheses (NFT with the OpenCV and robust solvers)
+    int subPixWindow = 11;       // cornerSubPix half window (chessboard)
+    int subPixIterations = 30;   // cornerSubPix iterations (chessboard), 0 skips the refinement
+    bool halfResolution = false; // Detect on the half-resolution level when the frame has one
+};
 
 class PoseTracker
 {
 public:
     virtual ~PoseTracker() = default;
 
+    // Show OpenCV debug windows from estimatePose (turn off when tracking off the main thread)
+    bool showDebug = true;
+    // Solver used for the pose estimate
+    PoseSolver solver = PoseSolver::OpenCV;
+    // Filled by estimatePose
+    PoseDiagnostics lastDiagnostics;
+    // Detection and solver settings, read on every estimatePose call
+    TrackerQuality quality;
+
     // Initializes the tracker (Load reference image or setup params)
     virtual void init() = 0;
 
+    // Workers for the per-frame parallel stages (ThreadPool::shared() by default, nullptr runs
+    // them on the calling thread)
+    virtual void setThreadPool(ThreadPool *) {}
+
     // Returns true if pose was found.
     // outputs: rvec and tvec (rotation and translation)
     virtual bool estimatePose(const cv::Mat &frame,
@@ -16,4 +66,14 @@ public:
                               const cv::Mat &distCoeffs,
                               cv::Mat &rvec,
                               cv::Mat &tvec) = 0;
-};
\ No newline at end of file
+
+    // Same on a preprocessed frame; trackers read its grayscale images instead of converting again
+    virtual bool estimatePose(const PreparedFrame &frame,
+                              const cv::Mat &cameraMatrix,
+                              const cv::Mat &distCoeffs,
+                              cv::Mat &rvec,
+                              cv::Mat &tvec)
+    {
+        return estimatePose(frame.color, cameraMatrix, distCoeffs, rvec, tvec);
+    }
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "chessboard_tracker.hpp"
+#include "nft_tracker.hpp"
+#include <memory>
+#include <string>
+
+// Create and initialize the tracker selected by useNft
+inline std::unique_ptr<PoseTracker> createTracker(bool useNft, cv::Size patternSize, float squareSize,
+                                                  const std::string &referencePath = "data/reference/reference.png")
+{
+    std::unique_ptr<PoseTracker> tracker;
+    if (useNft)
+    {
+        // NFT Tracker
+        tracker = std::make_unique<NFTTracker>(referencePath);
+    }
+    else
+    {
+        // Chessboard Tracker
+        tracker = std::make_unique<ChessboardTracker>(patternSize, squareSize);
+    }
+    // Load reference image / prepare object points
+    tracker->init();
+    return tracker;
+}
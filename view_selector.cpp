@@ -0,0 +1,137 @@
+#include "view_selector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ViewSelector::ViewSelector(const ViewSelectorOptions &options, cv::Size imageSize, cv::Size patternSize, float squareSize)
+    : options(options), imageSize(imageSize)
+{
+    for (int i = 0; i < patternSize.height; i++)
+        for (int j = 0; j < patternSize.width; j++)
+            boardPoints.push_back(cv::Point3f(j * squareSize, i * squareSize, 0));
+}
+
+cv::Mat ViewSelector::defaultCameraMatrix() const
+{
+    // Roughly a 53 degree horizontal field of view, principal point in the center
+    const double f = std::max(imageSize.width, imageSize.height);
+    return (cv::Mat_<double>(3, 3) << f, 0, imageSize.width * 0.5, 0, f, imageSize.height * 0.5, 0, 0, 1);
+}
+
+SelectedView ViewSelector::describe(const std::vector<cv::Point2f> &corners, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs) const
+{
+    SelectedView view;
+    view.view.corners = corners;
+
+    // Board pose under the current intrinsics
+    cv::Mat rvec, tvec, R;
+    const cv::Mat K = cameraMatrix.empty() ? defaultCameraMatrix() : cameraMatrix;
+    cv::solvePnP(boardPoints, corners, K, distCoeffs, rvec, tvec);
+    cv::Rodrigues(rvec, R);
+    view.normal = cv::Vec3d(R.at<double>(0, 2), R.at<double>(1, 2), R.at<double>(2, 2));
+    view.distance = cv::norm(tvec);
+
+    // Coverage cells touched by the corners
+    const int n = options.gridCells;
+    for (const auto &c : corners)
+    {
+        const int cx = std::clamp(static_cast<int>(c.x * n / imageSize.width), 0, n - 1);
+        const int cy = std::clamp(static_cast<int>(c.y * n / imageSize.height), 0, n - 1);
+        view.cells.push_back(cy * n + cx);
+    }
+    std::sort(view.cells.begin(), view.cells.end());
+    view.cells.erase(std::unique(view.cells.begin(), view.cells.end()), view.cells.end());
+    return view;
+}
+
+double ViewSelector::scoreAgainstPool(const SelectedView &view, int skip) const
+{
+    // Coverage: share of the candidate's cells that the rest of the pool touches rarely
+    std::vector<int> counts(options.gridCells * options.gridCells, 0);
+    for (int i = 0; i < static_cast<int>(pool.size()); ++i)
+        if (i != skip)
+            for (int cell : pool[i].cells)
+                counts[cell]++;
+    double coverageGain = 0.0;
+    for (int cell : view.cells)
+        coverageGain += 1.0 / (1.0 + counts[cell]);
+    coverageGain /= std::max<size_t>(1, view.cells.size());
+
+    // Pose diversity: distance to the closest kept pose (normal angle and log distance ratio)
+    const double referenceAngle = options.referenceAngleDeg * CV_PI / 180.0;
+    const double referenceScale = std::log(options.referenceScale);
+    double diversity = 1.0;
+    for (int i = 0; i < static_cast<int>(pool.size()); ++i)
+    {
+        if (i == skip)
+            continue;
+        const double angle = std::acos(std::clamp(view.normal.dot(pool[i].normal), -1.0, 1.0)) / referenceAngle;
+        const double scale = std::log(view.distance / pool[i].distance) / referenceScale;
+        diversity = std::min(diversity, std::sqrt(angle * angle + scale * scale));
+    }
+
+    // Tilted boards constrain the focal length, fronto-parallel ones hardly do
+    const double tilt = std::min(1.0, std::acos(std::min(1.0, std::fabs(view.normal[2]))) / (CV_PI / 4.0));
+
+    return 0.4 * coverageGain + 0.4 * diversity + 0.2 * tilt;
+}
+
+double ViewSelector::score(const std::vector<cv::Point2f> &corners, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs) const
+{
+    return scoreAgainstPool(describe(corners, cameraMatrix, distCoeffs), -1);
+}
+
+bool ViewSelector::offer(const CalibrationView &view, const cv::Mat &frame, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs)
+{
+    SelectedView candidate = describe(view.corners, cameraMatrix, distCoeffs);
+    candidate.score = scoreAgainstPool(candidate, -1);
+    if (candidate.score < options.minScore)
+    {
+        rejectedInRow++;
+        return false;
+    }
+
+    if (static_cast<int>(pool.size()) >= options.maxViews)
+    {
+        // Weakest member: the one the rest of the pool misses least
+        int weakest = -1;
+        double weakestScore = std::numeric_limits<double>::max();
+        for (int i = 0; i < static_cast<int>(pool.size()); ++i)
+        {
+            const double s = scoreAgainstPool(pool[i], i);
+            if (s < weakestScore)
+            {
+                weakestScore = s;
+                weakest = i;
+            }
+        }
+        if (candidate.score <= weakestScore)
+        {
+            rejectedInRow++;
+            return false;
+        }
+        pool.erase(pool.begin() + weakest);
+    }
+
+    candidate.view = view;
+    candidate.frame = frame.clone();
+    pool.push_back(std::move(candidate));
+    rejectedInRow = 0;
+    return true;
+}
+
+double ViewSelector::coverage() const
+{
+    std::vector<char> touched(options.gridCells * options.gridCells, 0);
+    for (const auto &view : pool)
+        for (int cell : view.cells)
+            touched[cell] = 1;
+    return static_cast<double>(std::count(touched.begin(), touched.end(), 1)) / touched.size();
+}
+
+bool ViewSelector::done() const
+{
+    return static_cast<int>(pool.size()) >= options.minViews &&
+           coverage() >= options.targetCoverage &&
+           rejectedInRow >= options.patience;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "calibration_engine.hpp"
+
+// Settings of the calibration view selector
+struct ViewSelectorOptions
+{
+    int maxViews = 15;             // Pool size; a full pool only accepts views that beat its weakest member
+    int minViews = 6;              // Never finish with fewer views
+    double minScore = 0.3;         // Candidates scoring below this are rejected outright
+    double targetCoverage = 0.6;   // Fraction of image cells the pool has to touch before finishing
+    int patience = 90;             // Finish after this many candidates in a row were rejected
+    int gridCells = 8;             // Coverage grid cells per image axis
+    double referenceAngleDeg = 20; // Board normals this far apart count as fully distinct
+    double referenceScale = 1.5;   // Board distances this far apart (ratio) count as fully distinct
+};
+
+// A kept view with what the selector scored it on
+struct SelectedView
+{
+    CalibrationView view;   // Corners (and image path once saved)
+    cv::Mat frame;          // Camera frame the corners came from
+    cv::Vec3d normal;       // Board normal in camera coordinates
+    double distance = 0.0;  // Board distance from the camera
+    std::vector<int> cells; // Coverage grid cells touched by the corners
+    double score = 0.0;     // Score when it was accepted
+};
+
+// Picks informative calibration views from a stream of detections
+// A candidate scores by how much new image area its corners cover, how different its board pose is
+// from the views already kept (measured with the current, possibly partial, intrinsics) and how
+// tilted the board is. Only high scorers are kept, in a pool of bounded size.
+class ViewSelector
+{
+public:
+    ViewSelector(const ViewSelectorOptions &options, cv::Size imageSize, cv::Size patternSize, float squareSize);
+
+    // Score of a candidate against the current pool, in [0, 1]
+    double score(const std::vector<cv::Point2f> &corners, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs) const;
+
+    // Offer a candidate; true when it was kept (possibly replacing the weakest view)
+    // frame may be empty when the view already refers to an image file
+    bool offer(const CalibrationView &view, const cv::Mat &frame, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs);
+
+    // Enough informative views were collected
+    bool done() const;
+
+    // Fraction of coverage grid cells touched by the pool
+    double coverage() const;
+
+    const std::vector<SelectedView> &views() const { return pool; }
+
+    // Intrinsics guess for scoring before the first solve
+    cv::Mat defaultCameraMatrix() const;
+
+    ViewSelectorOptions options;
+
+private:
+    // Pose and coverage features of a candidate
+    SelectedView describe(const std::vector<cv::Point2f> &corners, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs) const;
+    // Score of a described view against the pool, skipping pool entry `skip`
+    double scoreAgainstPool(const SelectedView &view, int skip) const;
+
+    cv::Size imageSize;
+    std::vector<cv::Point3f> boardPoints;
+    std::vector<SelectedView> pool;
+    int rejectedInRow = 0;
+};